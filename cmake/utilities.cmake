@@ -1,19 +1,23 @@
 
 # Function to compile GLSL source files to Spir-V
+# Shared GLSL from src/Utilities/shaders can be included with #include "<name>.glsl".
 #
 # add_spv_compilation(
 #   TARGET_NAME MyProject
 #   SHADER_FILES foo.vert foo.frag
 #   OUT_SPV_DIR ./shaders
 # )
+#
+# With VARIANT and DEFINES, the shaders are compiled with the given macros defined,
+# to <name>_<variant>.<ext>.spv, e.g. foo_bar.frag.spv for VARIANT bar.
 function ( add_spv_compilation )
   #set(oneValueArgs DST VULKAN_TARGET HEADER DEPENDENCY FLAGS)
   #set(multiValueArgs SOURCE_FILES HEADER_FILES)
   #cmake_parse_arguments(COMPILE  "${options}" "${oneValueArgs}" "${multiValueArgs}" ${ARGN} )
   
   # Parse arguments.
-  set ( oneValueArgs TARGET_NAME OUT_SPV_DIR )
-  set ( multiValueArgs SHADER_FILES )
+  set ( oneValueArgs TARGET_NAME OUT_SPV_DIR VARIANT )
+  set ( multiValueArgs SHADER_FILES DEFINES )
   cmake_parse_arguments( COMPILE  "${options}" "${oneValueArgs}" "${multiValueArgs}" ${ARGN} )
   
   # Sanity check.
@@ -41,15 +45,27 @@ function ( add_spv_compilation )
     COMMENT "Creating ${COMPILE_OUT_SPV_DIR}"
   )
 
+  set ( DEFINE_FLAGS "" )
+  foreach( define IN LISTS COMPILE_DEFINES )
+    list(APPEND DEFINE_FLAGS -D${define})
+  endforeach()
+
   # Compile each shader into the target directory.
-  foreach( source IN LISTS SHADER_FILES )
+  foreach( source IN LISTS COMPILE_SHADER_FILES )
     get_filename_component(FILENAME ${source} NAME)
+    if ( DEFINED COMPILE_VARIANT )
+      get_filename_component(NAME_WE ${source} NAME_WE)
+      get_filename_component(EXT ${source} EXT)
+      set ( FILENAME ${NAME_WE}_${COMPILE_VARIANT}${EXT} )
+    endif()
     add_custom_command(
       TARGET ${COMPILE_TARGET_NAME}
       PRE_BUILD
       COMMAND
         ${glslc_executable}
         #      -MD -MF ${COMPILE_OUT_SPV_DIR}/${FILENAME}.d
+        -I ${PROJECT_SOURCE_DIR}/src/Utilities/shaders
+        ${DEFINE_FLAGS}
         -o ${COMPILE_OUT_SPV_DIR}/${FILENAME}.spv
         ${source}
       DEPENDS ${source} ${COMPILE_OUT_SPV_DIR}
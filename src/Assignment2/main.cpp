@@ -1,11 +1,20 @@
 #include "ApplicationBase.h"
 #include "VulkanBase.h"
 #include "Image.h"
+#include "CommandLine.h"
+#include "Buffer.h"
+#include "ComputePipeline.h"
 
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/rotate_vector.hpp>
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
 
 // Assignment 2.
 
@@ -35,29 +44,273 @@ struct RenderEntry
 {
     VkBuffer uniformBuffer = VK_NULL_HANDLE;
     VkDeviceMemory uniformBufferMemory = VK_NULL_HANDLE;
+    void* uniformBufferMapped = nullptr; // Mapped for the lifetime of the buffer.
     VkDescriptorBufferInfo bufferInfo = {};
+
+    // Counters of shaders/shader.frag, read back once the entry's frame is done.
+    std::unique_ptr<svk::Buffer> counterBuffer; // Host-visible and coherent.
+    bool isCounted = false; // Whether the last frame drawn with the entry counted steps.
+
+    // Per-tile object lists of shaders/cull_tiles.comp, and its camera and object bounds.
+    std::unique_ptr<svk::Buffer> tileObjects;
+    std::unique_ptr<svk::Buffer> tileCullingBuffer;
+    // Whether the entry's command buffer lists the tile objects. The latch may toggle culling after recording.
+    bool isTileCulled = false;
+};
+
+
+// MarchCounters of shaders/shader.frag.
+struct MarchCounters
+{
+    uint32_t stepsLow;
+    uint32_t stepsHigh;
+    uint32_t raysLow;
+    uint32_t raysHigh;
+};
+
+
+enum class Marcher
+{
+    SphereTracing = 0,
+    OverRelaxed = 1, // Enhanced sphere tracing.
+};
+
+
+enum class Shadow
+{
+    None = 0,
+    Sharp = 1,
+    Grid = 2, // Soft, from a ray per sample of the area light.
+    Cone = 3, // Soft, from a single ray and its closest distance to occluders.
+};
+
+
+// Screen tiles of shaders/cull_tiles.comp.
+const uint32_t TileSize = 16;
+const uint32_t TileMaskWords = 2;
+const uint32_t MaxTileObjects = 32 * TileMaskWords;
+const uint32_t TileCullingGroupSize = 8;
+
+// Objects of shaders/shader.frag, in the order of their OBJECT_* ids.
+const uint32_t NumObjects = 8;
+static_assert( NumObjects <= MaxTileObjects, "Object masks of tiles are too short." );
+
+
+// Bounding spheres of the objects of shaders/shader.frag, with the animated blob center: center and radius.
+// Radii include the hit distance of far rays. The room holds the camera, so it is in every tile.
+std::array<glm::vec4, NumObjects> ObjectBounds( const glm::vec3& blobCenter )
+{
+    const float margin = 0.001f * 20.0f; // HIT_RATIO * MAX_DIST.
+    return {
+        glm::vec4( blobCenter, 0.87f + margin ),                    // Blob, up to 0.07 displacement.
+        glm::vec4( 0.0f, 0.0f, 0.0f, -1.0f ),                       // Room.
+        glm::vec4( -1.0f, -1.0f, 5.0f, 2.45f + margin ),            // Crate, 1x2x1 half size.
+        glm::vec4( 1.5f, -1.8f, 4.0f, 1.2f + margin ),              // Sphere.
+        glm::vec4( -2.0f, -2.0f, 2.5f, 1.07f + margin ),            // Reflector, 0.5x0.8x0.5 half size.
+        glm::vec4( 0.0f, 0.0f, 1.0f, 1.82f + margin ),              // Refractor, 1.5x1x0.1 half size and 0.1 wave.
+        glm::vec4( 2.0f, -2.0f, 2.0f, 0.97f + margin ),             // Fractal, tetrahedron of 0.5*sqrt(3) and 0.1 spheres.
+        glm::vec4( -2.0f, 2.0f, 3.0f, 1.82f + margin ),             // Flag, 1.5x1x0.1 half size and 0.1 wave.
+    };
+}
+
+
+// TileCulling of shaders/cull_tiles.comp.
+struct TileCullingStruct
+{
+    glm::mat4 lookAt;
+    glm::vec2 resolution;
+    uint32_t numTilesX;
+    uint32_t numTilesY;
+    glm::vec4 objectBounds[MaxTileObjects];
+    uint32_t numObjects;
 };
 
 
 struct UniformsStruct
 {
     glm::mat4 lookAt; // LookAt matrix.
+    glm::mat4 crateToLocal; // Animated transforms from world to object coordinates.
+    glm::mat4 reflectorToLocal;
+    glm::vec4 blob; // Center of the blob, and amplitude of its surface displacement.
+    glm::vec4 sdfBoxMin; // Box of the baked static distances, and its voxel size. Voxel size 0 if not baked.
+    glm::vec4 sdfBoxSize;
     glm::vec2 resolution; // Resolution of the screen.
     glm::vec2 mouse; // Mouse coordinates.
     float time; // Time since startup, in seconds.
     float gamma; // Gamma correction parameter.
-    int shadow; // 0 = none, 1 = sharp, 2 = soft.
+    int shadow; // Shadow.
+    int marcher; // Marcher.
+    uint32_t numTilesX; // Tiles per row of the tile object lists, 0 without culling.
+    float blobPhase; // Phases of the surface displacement of the blob and of the waves, from [0,2*PI).
+    float wavePhase;
+    int fractalIterations;
+    float lodFootprint; // Width of the pixel cone of rays per unit distance, over the LOD quality. 0 for full detail.
 };
 
 
+// LOD quality feedback: frames per adjustment, and the factor of each step.
+const int LodFeedbackFrames = 30;
+const float LodQualityStep = 1.25f;
+const float MinLodQuality = 1.0f / 32.0f;
+
+
+// Box of the static objects baked by shaders/bake_sdf.comp: the room and the hole of the lamp, with a margin.
+const glm::vec3 SdfBoxMin( -3.25f, -3.25f, -6.25f );
+const glm::vec3 SdfBoxMax( 3.25f, 3.75f, 6.25f );
+const uint32_t DefaultSdfResolution = 128;
+const uint32_t SdfBakeGroupSize = 4;
+
+// Params of shaders/bake_sdf.comp.
+struct SdfBakeParams
+{
+    glm::vec4 boxMin; // Corner, and voxel size.
+    uint32_t size[4]; // Voxels along x, y and z.
+};
+
+
+// Angle from [0,2*PI). Computed in double, so that it stays accurate as the time grows.
+float RegularAngle( const double angle )
+{
+    const double _2Pi = 6.28318530717958647692;
+    const double regular = std::fmod( angle, _2Pi );
+    return float( regular < 0.0 ? regular + _2Pi : regular );
+}
+
+
+// Animates the objects of shaders/shader.frag: what only depends on time is computed
+// here once per frame, instead of on every march step of every pixel.
+void AnimateObjects( UniformsStruct& uniforms, const double time )
+{
+    SVK_TRACE_SCOPE( "AnimateObjects" );
+
+    const float pi = 3.14159265359f;
+    const glm::vec3 axisX( 1, 0, 0 );
+    const glm::vec3 axisY( 0, 1, 0 );
+    const glm::vec3 axisZ( 0, 0, 1 );
+
+    const glm::vec3 blobCenter( -0.5f, -2.2f + std::abs( std::sin( RegularAngle( 3.0 * time ) ) ), 2.0f );
+    uniforms.blob = glm::vec4( blobCenter, 0.07f * std::sin( RegularAngle( 2.0 * time ) ) );
+    uniforms.blobPhase = RegularAngle( 10.0 * time );
+
+    uniforms.crateToLocal = glm::rotate( glm::mat4( 1.0f ), RegularAngle( time ), axisY );
+    uniforms.crateToLocal = glm::translate( uniforms.crateToLocal, -glm::vec3( -1, -1, 5 ) );
+
+    // Rotated around X, Y and Z by -0.1*PI, then spinning around Y.
+    uniforms.reflectorToLocal = glm::rotate( glm::mat4( 1.0f ), RegularAngle( -time ), axisY );
+    uniforms.reflectorToLocal = glm::rotate( uniforms.reflectorToLocal, -0.1f * pi, axisZ );
+    uniforms.reflectorToLocal = glm::rotate( uniforms.reflectorToLocal, -0.1f * pi, axisY );
+    uniforms.reflectorToLocal = glm::rotate( uniforms.reflectorToLocal, -0.1f * pi, axisX );
+    uniforms.reflectorToLocal = glm::translate( uniforms.reflectorToLocal, -glm::vec3( -2, -2, 2.5 ) );
+
+    uniforms.wavePhase = RegularAngle( -10.0 * time );
+
+    const int maxFractalIterations = 8;
+    uniforms.fractalIterations = 1 + int( std::fmod( 2.0 * time, double( maxFractalIterations ) ) );
+}
+
+
 class AppExample : public svk::ApplicationBase
 {
 private:
     std::vector<RenderEntry> renderEntries;
     std::shared_ptr<svk::Image> texture;
 
+    svk::FrameTimings::Clock::time_point lastPresented;
+    svk::FrameTimings::Clock::time_point lastLatencyReport;
+    double latchedLatencySum = 0.0;
+    double acquiredLatencySum = 0.0;
+    int numLatencyFrames = 0;
+
+    Marcher marcher = Marcher::OverRelaxed;
+    Shadow shadow = Shadow::Cone;
+    bool isTileCulling = true;
+    uint32_t numTilesX = 0;
+    uint32_t numTilesY = 0;
+    svk::ComputePipeline tileCullingPipeline;
+    bool isLod = true;
+    float lodQuality = 1.0f; // Features narrower than 1/lodQuality pixels are dropped.
+    double gpuTimeTargetMs = 0.0;
+    size_t lastGpuSample = 0;
+    double gpuTimeSum = 0.0;
+    int numGpuTimes = 0;
+    uint32_t sdfResolution = DefaultSdfResolution; // Voxels along the longest side of the box, 0 to not bake.
+    bool isSdfUsed = true;
+    uint32_t sdfSize[3] = {};
+    float sdfVoxel = 0.0f;
+    std::shared_ptr<svk::Image> bakedSdf;
+    svk::Buffer sdfBakeBuffer;
+    svk::ComputePipeline sdfBakePipeline;
+    bool isSdfBakePending = false;
+    bool isCountingSteps = false;
+    uint64_t countedSteps = 0;
+    uint64_t countedRays = 0;
+    int numCountedFrames = 0;
+    svk::FrameTimings::Clock::time_point lastStepsReport;
+
 public:
 
+    // --marcher=sphere|relaxed selects the ray marcher, also toggled with M.
+    // --shadow=none|sharp|grid|cone selects the shadows, also cycled with H.
+    // --no-tile-culling marches all objects on primary rays, also toggled with C.
+    // --lod=quality|off scales the level of detail: detail is dropped below 1/quality pixels (default 1),
+    // also toggled with L.
+    // --gpu-time-target=ms adjusts the LOD quality, up to 1, to keep GPU frames within the target.
+    // --sdf-resolution=voxels|off sets the voxels along the longest side of the baked static distances
+    // (default 128, 2 bytes each), and their use is toggled with B.
+    // --count-steps reports the average march steps per ray once a second. It draws with the
+    // count_steps variant of shaders/shader.frag, which needs the fragmentStoresAndAtomics device feature.
+    void ParseMarchOptions( int argc, char** argv )
+    {
+        const std::string marcherName = svk::FindCommandLineOption( argc, argv, "marcher" );
+        if ( marcherName == "sphere" )
+            marcher = Marcher::SphereTracing;
+        else if ( marcherName == "relaxed" )
+            marcher = Marcher::OverRelaxed;
+        else if ( !marcherName.empty() )
+            throw std::runtime_error( "Unknown --marcher=" + marcherName + ", expected sphere or relaxed." );
+
+        const std::string shadowName = svk::FindCommandLineOption( argc, argv, "shadow" );
+        if ( shadowName == "none" )
+            shadow = Shadow::None;
+        else if ( shadowName == "sharp" )
+            shadow = Shadow::Sharp;
+        else if ( shadowName == "grid" )
+            shadow = Shadow::Grid;
+        else if ( shadowName == "cone" )
+            shadow = Shadow::Cone;
+        else if ( !shadowName.empty() )
+            throw std::runtime_error( "Unknown --shadow=" + shadowName + ", expected none, sharp, grid or cone." );
+
+        isTileCulling = !svk::HasCommandLineOption( argc, argv, "no-tile-culling" );
+
+        const std::string lod = svk::FindCommandLineOption( argc, argv, "lod" );
+        if ( lod == "off" )
+            isLod = false;
+        else if ( !lod.empty() )
+            lodQuality = float( std::atof( lod.c_str() ) );
+        if ( lodQuality <= 0.0f )
+            throw std::runtime_error( "--lod=" + lod + ": Expected a positive quality or off." );
+
+        const std::string resolution = svk::FindCommandLineOption( argc, argv, "sdf-resolution" );
+        if ( resolution == "off" )
+        {
+            sdfResolution = 0;
+        }
+        else if ( !resolution.empty() )
+        {
+            const int voxels = std::atoi( resolution.c_str() );
+            if ( voxels <= 0 )
+                throw std::runtime_error( "--sdf-resolution=" + resolution + ": Expected a positive voxel count or off." );
+            sdfResolution = uint32_t( voxels );
+        }
+
+        // Frame times come from the GPU profiler.
+        gpuTimeTargetMs = std::atof( svk::FindCommandLineOption( argc, argv, "gpu-time-target" ).c_str() );
+        if ( gpuTimeTargetMs > 0.0 && !gpuProfiler )
+            gpuProfiler = std::make_shared<svk::GpuProfiler>();
+        isCountingSteps = svk::HasCommandLineOption( argc, argv, "count-steps" );
+    }
+
     virtual VkVertexInputBindingDescription getVertexBindingDescription() const override
     {
         return { 0, sizeof(Vertex), VK_VERTEX_INPUT_RATE_VERTEX };
@@ -84,12 +337,33 @@ public:
         samplerLayoutBinding.pImmutableSamplers = nullptr;
         samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
-        return { uboLayoutBinding, samplerLayoutBinding };
+        VkDescriptorSetLayoutBinding counterLayoutBinding{};
+        counterLayoutBinding.binding = 2;
+        counterLayoutBinding.descriptorCount = 1;
+        counterLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        counterLayoutBinding.pImmutableSamplers = nullptr;
+        counterLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        VkDescriptorSetLayoutBinding tilesLayoutBinding{};
+        tilesLayoutBinding.binding = 3;
+        tilesLayoutBinding.descriptorCount = 1;
+        tilesLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        tilesLayoutBinding.pImmutableSamplers = nullptr;
+        tilesLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        VkDescriptorSetLayoutBinding sdfLayoutBinding{};
+        sdfLayoutBinding.binding = 4;
+        sdfLayoutBinding.descriptorCount = 1;
+        sdfLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        sdfLayoutBinding.pImmutableSamplers = nullptr;
+        sdfLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        return { uboLayoutBinding, samplerLayoutBinding, counterLayoutBinding, tilesLayoutBinding, sdfLayoutBinding };
     }
 
     virtual std::vector<VkWriteDescriptorSet> getDescriptorWrites( const VkDescriptorSet& descriptorSet, const int swapEntryIndex ) const override
     {
-        std::vector<VkWriteDescriptorSet> descriptorWrites(2);
+        std::vector<VkWriteDescriptorSet> descriptorWrites(5);
 
         descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         descriptorWrites[0].dstSet = descriptorSet;
@@ -107,12 +381,41 @@ public:
         descriptorWrites[1].descriptorCount = 1;
         descriptorWrites[1].pImageInfo = &texture->Info();
 
+        descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[2].dstSet = descriptorSet;
+        descriptorWrites[2].dstBinding = 2;
+        descriptorWrites[2].dstArrayElement = 0;
+        descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[2].descriptorCount = 1;
+        descriptorWrites[2].pBufferInfo = &renderEntries[swapEntryIndex].counterBuffer->Info();
+
+        descriptorWrites[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[3].dstSet = descriptorSet;
+        descriptorWrites[3].dstBinding = 3;
+        descriptorWrites[3].dstArrayElement = 0;
+        descriptorWrites[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[3].descriptorCount = 1;
+        descriptorWrites[3].pBufferInfo = &renderEntries[swapEntryIndex].tileObjects->Info();
+
+        descriptorWrites[4].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[4].dstSet = descriptorSet;
+        descriptorWrites[4].dstBinding = 4;
+        descriptorWrites[4].dstArrayElement = 0;
+        descriptorWrites[4].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrites[4].descriptorCount = 1;
+        descriptorWrites[4].pImageInfo = &bakedSdf->Info();
+
         return descriptorWrites;
     }
 
     virtual void InitAppResources() override
     {
+        // The step counters are atomics in the fragment shader.
+        if ( isCountingSteps && !svk::theVulkanContext().IsFragmentStoresAndAtomicsSupported() )
+            throw std::runtime_error( "--count-steps needs the fragmentStoresAndAtomics device feature." );
+
         texture = svk::Image::CreateFromFile( *commandPool, TEXTURE_PATH );
+        InitBakedSdf();
 
         std::cout << std::endl << std::endl
             << "Seems like the program has been loaded." << std::endl
@@ -121,6 +424,11 @@ public:
             << "Q-E : rotation left-right." << std::endl
             << "R-F : movement up-down." << std::endl
             << "T-G : rotation up-down." << std::endl
+            << "M : switch between sphere tracing and over-relaxed sphere tracing." << std::endl
+            << "H : cycle shadows: none, sharp, soft grid and soft cone." << std::endl
+            << "C : switch culling of objects per screen tile on and off." << std::endl
+            << "L : switch level of detail of the fractal and the blob on and off." << std::endl
+            << "B : switch baked distances of the room and the sphere on and off." << std::endl
             << std::endl
             << "Enjoy! Please contact me if you fail to run this." << std::endl
             << std::endl;
@@ -129,6 +437,9 @@ public:
     virtual void DestroyAppResources() override
     {
         texture.reset();
+        bakedSdf.reset();
+        sdfBakeBuffer.Clear();
+        sdfBakePipeline.Clear();
     }
 
     virtual void InitRenderEntries( const svk::SwapChainInfo& swapChainInfo ) override
@@ -140,11 +451,56 @@ public:
         {
             auto& entry = renderEntries[i];
             svk::createBuffer( bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, entry.uniformBuffer, entry.uniformBufferMemory );
+            vkMapMemory( svk::theVulkanContext().LogicalDevice(), entry.uniformBufferMemory, 0, bufferSize, 0, &entry.uniformBufferMapped );
             VkDescriptorBufferInfo bufferInfo{};
             bufferInfo.buffer = entry.uniformBuffer;
             bufferInfo.offset = 0;
             bufferInfo.range = bufferSize;
             entry.bufferInfo = bufferInfo;
+
+            entry.counterBuffer = std::make_unique<svk::Buffer>(
+                sizeof(MarchCounters), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+            memset( entry.counterBuffer->Mapped(), 0, sizeof(MarchCounters) );
+        }
+
+        // Tile lists follow the swap chain extent.
+        numTilesX = svk::ComputePipeline::GroupCount( swapChainInfo.extent.width, TileSize );
+        numTilesY = svk::ComputePipeline::GroupCount( swapChainInfo.extent.height, TileSize );
+
+        VkDescriptorSetLayoutBinding cullingBinding{};
+        cullingBinding.binding = 0;
+        cullingBinding.descriptorCount = 1;
+        cullingBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        cullingBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        VkDescriptorSetLayoutBinding tilesBinding{};
+        tilesBinding.binding = 1;
+        tilesBinding.descriptorCount = 1;
+        tilesBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        tilesBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        tileCullingPipeline.Reset( std::string(PROJECT_NAME) + "/cull_tiles.comp.spv", { cullingBinding, tilesBinding }, 0, swapChainInfo.numEntries );
+
+        for ( int i = 0; i < swapChainInfo.numEntries; ++i )
+        {
+            auto& entry = renderEntries[i];
+            entry.tileObjects = std::make_unique<svk::Buffer>( numTilesX * numTilesY * TileMaskWords * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT );
+            entry.tileCullingBuffer = std::make_unique<svk::Buffer>(
+                sizeof(TileCullingStruct), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+
+            VkWriteDescriptorSet cullingWrite{};
+            cullingWrite.dstBinding = 0;
+            cullingWrite.descriptorCount = 1;
+            cullingWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            cullingWrite.pBufferInfo = &entry.tileCullingBuffer->Info();
+
+            VkWriteDescriptorSet tilesWrite{};
+            tilesWrite.dstBinding = 1;
+            tilesWrite.descriptorCount = 1;
+            tilesWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            tilesWrite.pBufferInfo = &entry.tileObjects->Info();
+
+            tileCullingPipeline.UpdateDescriptorSet( i, { cullingWrite, tilesWrite } );
         }
     }
 
@@ -153,27 +509,282 @@ public:
         const auto device = svk::theVulkanContext().LogicalDevice();
         for ( auto& entry : renderEntries )
         {
+            vkUnmapMemory( device, entry.uniformBufferMemory );
             vkDestroyBuffer( device, entry.uniformBuffer, nullptr );
             vkFreeMemory( device, entry.uniformBufferMemory, nullptr );
         }
         renderEntries.clear();
+        tileCullingPipeline.Clear();
     }
 
+    // The GPU is done with the entry: collect the counters of its last frame.
     virtual void UpdateRenderEntry( const svk::SwapChainInfo& swapChainInfo, const svk::SwapChainEntry& swapChainEntry, const int swapEntryIndex ) override
     {
-        const auto device = svk::theVulkanContext().LogicalDevice();
+        SVK_TRACE_SCOPE( "AppExample::UpdateRenderEntry" );
+
+        UpdateLodQuality();
+
+        auto& entry = renderEntries[swapEntryIndex];
+        if ( !entry.isCounted )
+            return;
+
+        auto& counters = *static_cast<MarchCounters*>( entry.counterBuffer->Mapped() );
+        countedSteps += ( uint64_t( counters.stepsHigh ) << 32 ) | counters.stepsLow;
+        countedRays += ( uint64_t( counters.raysHigh ) << 32 ) | counters.raysLow;
+        ++numCountedFrames;
+        counters = {};
+        entry.isCounted = false;
+
+        ReportMarchSteps();
+    }
+
+    // Steps the LOD quality toward the GPU time target, from the average time of the last frames.
+    // Frames still in flight were recorded at the previous quality, which the average mostly hides.
+    void UpdateLodQuality()
+    {
+        if ( gpuTimeTargetMs <= 0.0 || !gpuProfiler || !isLod )
+            return;
+
+        double milliseconds = 0.0;
+        size_t numSamples = 0;
+        if ( !gpuProfiler->LatestSample( "frame", milliseconds, numSamples ) || numSamples == lastGpuSample )
+            return;
+        lastGpuSample = numSamples;
+        gpuTimeSum += milliseconds;
+        if ( ++numGpuTimes < LodFeedbackFrames )
+            return;
+
+        const double averageMs = gpuTimeSum / numGpuTimes;
+        gpuTimeSum = 0.0;
+        numGpuTimes = 0;
+
+        float quality = lodQuality;
+        if ( averageMs > 1.05 * gpuTimeTargetMs )
+            quality = std::max( lodQuality / LodQualityStep, MinLodQuality );
+        else if ( averageMs < 0.85 * gpuTimeTargetMs )
+            quality = std::min( lodQuality * LodQualityStep, 1.0f );
+        if ( quality == lodQuality )
+            return;
+
+        lodQuality = quality;
+        std::cout << "LOD quality " << lodQuality << ", GPU frame " << averageMs << " ms for a target of " << gpuTimeTargetMs << " ms." << std::endl;
+    }
+
+    // Volume of the distances to the static objects, and the compute pass that bakes them.
+    // Without baking, a single voxel stands in for the volume, and the shaders only use analytic distances.
+    void InitBakedSdf()
+    {
+        SVK_TRACE_SCOPE( "AppExample::InitBakedSdf" );
+
+        bakedSdf = std::make_shared<svk::Image>();
+        if ( sdfResolution == 0 )
+        {
+            bakedSdf->Reset3D( 1, 1, 1, VK_FORMAT_R16_SFLOAT, VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_LAYOUT_UNDEFINED );
+            bakedSdf->TransitionLayout( *commandPool, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL );
+            return;
+        }
+
+        VkPhysicalDeviceProperties properties{};
+        vkGetPhysicalDeviceProperties( svk::theVulkanContext().PhysicalDevice(), &properties );
+        if ( sdfResolution > properties.limits.maxImageDimension3D )
+            throw std::runtime_error( "--sdf-resolution exceeds the maximum 3D image size of " + std::to_string( properties.limits.maxImageDimension3D ) + "." );
+
+        // Cubic voxels, an even number along x for the pairs of half floats of the bake.
+        const glm::vec3 extent = SdfBoxMax - SdfBoxMin;
+        sdfVoxel = std::max( extent.x, std::max( extent.y, extent.z ) ) / float( sdfResolution );
+        sdfSize[0] = 2 * uint32_t( std::ceil( extent.x / ( 2.0f * sdfVoxel ) ) );
+        sdfSize[1] = uint32_t( std::ceil( extent.y / sdfVoxel ) );
+        sdfSize[2] = uint32_t( std::ceil( extent.z / sdfVoxel ) );
+
+        // Half floats are filterable and can be copied to on all devices, unlike storage images of them.
+        bakedSdf->Reset3D( sdfSize[0], sdfSize[1], sdfSize[2], VK_FORMAT_R16_SFLOAT, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_LAYOUT_UNDEFINED );
+        bakedSdf->TransitionLayout( *commandPool, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL );
+
+        const VkDeviceSize numBytes = VkDeviceSize( sdfSize[0] ) * sdfSize[1] * sdfSize[2] * sizeof(uint16_t);
+        sdfBakeBuffer.Reset( numBytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT );
+
+        VkDescriptorSetLayoutBinding distancesBinding{};
+        distancesBinding.binding = 0;
+        distancesBinding.descriptorCount = 1;
+        distancesBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        distancesBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        sdfBakePipeline.Reset( std::string(PROJECT_NAME) + "/bake_sdf.comp.spv", { distancesBinding }, sizeof(SdfBakeParams) );
+
+        VkWriteDescriptorSet distancesWrite{};
+        distancesWrite.dstBinding = 0;
+        distancesWrite.descriptorCount = 1;
+        distancesWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        distancesWrite.pBufferInfo = &sdfBakeBuffer.Info();
+        sdfBakePipeline.UpdateDescriptorSet( 0, { distancesWrite } );
+
+        std::cout << "Baked distances: " << sdfSize[0] << "x" << sdfSize[1] << "x" << sdfSize[2] << " voxels of "
+            << sdfVoxel << ", " << numBytes / 1024 << " KiB." << std::endl;
+        RequestSdfBake();
+    }
+
+    // Bakes the static objects with the next frame. Call whenever they change.
+    void RequestSdfBake()
+    {
+        isSdfBakePending = sdfResolution > 0;
+    }
+
+    // Bakes the distances into the buffer, and copies them to the volume. Barriers order the bake
+    // after the frames still sampling the volume, and before the frames that sample it next.
+    void RecordSdfBake( const VkCommandBuffer commandBuffer )
+    {
+        if ( !isSdfBakePending )
+            return;
+        isSdfBakePending = false;
+
+        svk::cmdBufferBarrier(
+            commandBuffer, sdfBakeBuffer.Handle(),
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT
+        );
+
+        SdfBakeParams params;
+        params.boxMin = glm::vec4( SdfBoxMin, sdfVoxel );
+        params.size[0] = sdfSize[0];
+        params.size[1] = sdfSize[1];
+        params.size[2] = sdfSize[2];
+        params.size[3] = 0;
+
+        sdfBakePipeline.Bind( commandBuffer );
+        sdfBakePipeline.PushConstants( commandBuffer, &params, sizeof(params) );
+        sdfBakePipeline.Dispatch(
+            commandBuffer,
+            svk::ComputePipeline::GroupCount( sdfSize[0] / 2, SdfBakeGroupSize ),
+            svk::ComputePipeline::GroupCount( sdfSize[1], SdfBakeGroupSize ),
+            svk::ComputePipeline::GroupCount( sdfSize[2], SdfBakeGroupSize ) );
+
+        svk::cmdBufferBarrier(
+            commandBuffer, sdfBakeBuffer.Handle(),
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT
+        );
+
+        bakedSdf->TransitionLayout( commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL );
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = 0;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = { 0, 0, 0 };
+        region.imageExtent = { sdfSize[0], sdfSize[1], sdfSize[2] };
+        vkCmdCopyBufferToImage( commandBuffer, sdfBakeBuffer.Handle(), bakedSdf->Handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region );
+
+        bakedSdf->TransitionLayout( commandBuffer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL );
+    }
+
+    // Bakes the static distances when needed, and lists the objects of each tile,
+    // before the fragment shader marches them.
+    virtual void RecordPreRenderPassCommands( const VkCommandBuffer commandBuffer, const int swapEntryIndex ) override
+    {
+        SVK_TRACE_SCOPE( "AppExample::RecordPreRenderPassCommands" );
+
+        RecordSdfBake( commandBuffer );
+
+        auto& entry = renderEntries[swapEntryIndex];
+        entry.isTileCulled = isTileCulling;
+        if ( !entry.isTileCulled )
+            return;
+
+        tileCullingPipeline.Bind( commandBuffer, swapEntryIndex );
+        tileCullingPipeline.Dispatch(
+            commandBuffer,
+            svk::ComputePipeline::GroupCount( numTilesX, TileCullingGroupSize ),
+            svk::ComputePipeline::GroupCount( numTilesY, TileCullingGroupSize ) );
+
+        svk::cmdBufferBarrier(
+            commandBuffer, entry.tileObjects->Handle(),
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT
+        );
+    }
+
+    // Makes the counters visible to UpdateRenderEntry.
+    virtual void RecordPostRenderPassCommands( const VkCommandBuffer commandBuffer, const int swapEntryIndex ) override
+    {
+        if ( !isCountingSteps )
+            return;
+
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = renderEntries[swapEntryIndex].counterBuffer->Handle();
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+        vkCmdPipelineBarrier( commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr );
+    }
+
+    virtual void OnInputEvent( const svk::InputEvent& event ) override
+    {
+        if ( event.type == svk::InputEventType::Key && event.code == GLFW_KEY_M && event.action == GLFW_PRESS )
+        {
+            marcher = ( marcher == Marcher::SphereTracing ) ? Marcher::OverRelaxed : Marcher::SphereTracing;
+            std::cout << "Marcher: " << MarcherName( marcher ) << std::endl;
+            // Start the average over with the new marcher.
+            countedSteps = 0;
+            countedRays = 0;
+            numCountedFrames = 0;
+        }
+        else if ( event.type == svk::InputEventType::Key && event.code == GLFW_KEY_H && event.action == GLFW_PRESS )
+        {
+            shadow = Shadow( ( int( shadow ) + 1 ) % 4 );
+            std::cout << "Shadows: " << ShadowName( shadow ) << std::endl;
+            countedSteps = 0;
+            countedRays = 0;
+            numCountedFrames = 0;
+        }
+        else if ( event.type == svk::InputEventType::Key && event.code == GLFW_KEY_C && event.action == GLFW_PRESS )
+        {
+            isTileCulling = !isTileCulling;
+            std::cout << "Tile culling: " << ( isTileCulling ? "on" : "off" ) << std::endl;
+            countedSteps = 0;
+            countedRays = 0;
+            numCountedFrames = 0;
+        }
+        else if ( event.type == svk::InputEventType::Key && event.code == GLFW_KEY_L && event.action == GLFW_PRESS )
+        {
+            isLod = !isLod;
+            std::cout << "Level of detail: " << ( isLod ? "on" : "off" ) << std::endl;
+            gpuTimeSum = 0.0;
+            numGpuTimes = 0;
+        }
+        else if ( event.type == svk::InputEventType::Key && event.code == GLFW_KEY_B && event.action == GLFW_PRESS )
+        {
+            isSdfUsed = !isSdfUsed;
+            std::cout << "Baked distances: " << ( isSdfUsed && sdfResolution > 0 ? "on" : "off" ) << std::endl;
+            countedSteps = 0;
+            countedRays = 0;
+            numCountedFrames = 0;
+        }
+    }
+
+    // Camera and time are latched right before submit, from the latest input.
+    virtual void LatchRenderEntry( const svk::SwapChainInfo& swapChainInfo, const svk::SwapChainEntry& swapChainEntry, const int swapEntryIndex ) override
+    {
         auto& entry = renderEntries[swapEntryIndex];
 
-        static auto startTime = std::chrono::high_resolution_clock::now();
+        PollInput();
+        ReportLatency();
 
-        auto currentTime = std::chrono::high_resolution_clock::now();
-        float time = std::chrono::duration<float, std::chrono::seconds::period>( currentTime - startTime ).count();
+        const double time = ClockTime();
 
-        double xpos, ypos;
-        glfwGetCursorPos( window, &xpos, &ypos );
+        // Polled on the render thread, from the input events applied so far.
+        const double xpos = input.CursorX();
+        const double ypos = input.CursorY();
 
-        int width, height;
-        glfwGetFramebufferSize( window, &width, &height );
+        const int width = input.FramebufferWidth();
+        const int height = input.FramebufferHeight();
 
         // Saved camera parameters.
         static glm::vec3 eye = glm::vec3(0,0,-2);
@@ -183,13 +794,13 @@ public:
         // Update camera positioning from keys.
         float rot_hor = 0.0f;
         float rot_ver = 0.0f;
-        if ( glfwGetKey( window, GLFW_KEY_Q ) )
+        if ( input.IsKeyDown( GLFW_KEY_Q ) )
             rot_hor -= 0.05;
-        if ( glfwGetKey( window, GLFW_KEY_E ) )
+        if ( input.IsKeyDown( GLFW_KEY_E ) )
             rot_hor += 0.05;
-        if ( glfwGetKey( window, GLFW_KEY_T ) )
+        if ( input.IsKeyDown( GLFW_KEY_T ) )
             rot_ver -= 0.05;
-        if ( glfwGetKey( window, GLFW_KEY_G ) )
+        if ( input.IsKeyDown( GLFW_KEY_G ) )
             rot_ver += 0.05;
 
         forward = glm::rotate( forward, rot_hor, up0 );
@@ -197,35 +808,110 @@ public:
         forward = glm::rotate( forward, rot_ver, right );
         const glm::vec3 up = glm::normalize( glm::cross( forward, right ) );
 
-        if ( glfwGetKey( window, GLFW_KEY_A ) )
+        if ( input.IsKeyDown( GLFW_KEY_A ) )
             eye -= 0.1f*right;
-        if ( glfwGetKey( window, GLFW_KEY_D ) )
+        if ( input.IsKeyDown( GLFW_KEY_D ) )
             eye += 0.1f*right;
-        if ( glfwGetKey( window, GLFW_KEY_W ) )
+        if ( input.IsKeyDown( GLFW_KEY_W ) )
             eye += 0.1f*forward;
-        if ( glfwGetKey( window, GLFW_KEY_S ) )
+        if ( input.IsKeyDown( GLFW_KEY_S ) )
             eye -= 0.1f*forward;
-        if ( glfwGetKey( window, GLFW_KEY_R ) )
+        if ( input.IsKeyDown( GLFW_KEY_R ) )
             eye += 0.1f*up;
-        if ( glfwGetKey( window, GLFW_KEY_F ) )
+        if ( input.IsKeyDown( GLFW_KEY_F ) )
             eye -= 0.1f*up;
 
         UniformsStruct uniforms{};
         uniforms.resolution = glm::vec2( width, height );
         uniforms.mouse = glm::vec2( xpos, ypos );
-        uniforms.time = time;
+        uniforms.time = float( time );
         uniforms.gamma = 2.2f;
-        uniforms.shadow = 2;
+        uniforms.shadow = int( shadow );
+        uniforms.marcher = int( marcher );
+        entry.isCounted = isCountingSteps;
         uniforms.lookAt = glm::mat4(
             glm::vec4( right, 0.0f ),
             glm::vec4( up, 0.0f ),
             glm::vec4( forward, 0.0f ),
             glm::vec4( eye, 1.0f ) );
 
-        void* data;
-        vkMapMemory( device, entry.uniformBufferMemory, 0, sizeof( uniforms ), 0, &data );
-        memcpy( data, &uniforms, sizeof( uniforms ) );
-        vkUnmapMemory( device, entry.uniformBufferMemory );
+        uniforms.numTilesX = entry.isTileCulled ? numTilesX : 0;
+        AnimateObjects( uniforms, time );
+        // A pixel is 2/height wide at distance 1, see shaders/shader.frag.
+        uniforms.lodFootprint = ( isLod && height > 0 ) ? 2.0f / ( float( height ) * lodQuality ) : 0.0f;
+        if ( isSdfUsed && sdfResolution > 0 )
+        {
+            uniforms.sdfBoxMin = glm::vec4( SdfBoxMin, sdfVoxel );
+            uniforms.sdfBoxSize = glm::vec4( glm::vec3( sdfSize[0], sdfSize[1], sdfSize[2] ) * sdfVoxel, 0.0f );
+        }
+
+        memcpy( entry.uniformBufferMapped, &uniforms, sizeof( uniforms ) );
+
+        // Recorded with the frame, the culling pass reads the same camera and objects when the frame is submitted.
+        TileCullingStruct culling{};
+        culling.lookAt = uniforms.lookAt;
+        culling.resolution = uniforms.resolution;
+        culling.numTilesX = numTilesX;
+        culling.numTilesY = numTilesY;
+        const auto bounds = ObjectBounds( glm::vec3( uniforms.blob.x, uniforms.blob.y, uniforms.blob.z ) );
+        std::copy( bounds.begin(), bounds.end(), culling.objectBounds );
+        culling.numObjects = NumObjects;
+        memcpy( entry.tileCullingBuffer->Mapped(), &culling, sizeof( culling ) );
+    }
+
+    // Prints once a second how long input waits to be presented: from the latch,
+    // and from right after acquire, where it was sampled before latching.
+    void ReportLatency()
+    {
+        const auto& timings = swapchain->LastFrameTimings();
+        if ( timings.presented == lastPresented )
+            return;
+        lastPresented = timings.presented;
+
+        using Milliseconds = std::chrono::duration<double, std::milli>;
+        latchedLatencySum += Milliseconds( timings.presented - timings.inputSampled ).count();
+        acquiredLatencySum += Milliseconds( timings.presented - timings.acquired ).count();
+        ++numLatencyFrames;
+
+        if ( timings.presented - lastLatencyReport < std::chrono::seconds( 1 ) )
+            return;
+        std::cout << "Input to present: " << latchedLatencySum / numLatencyFrames << " ms latched, "
+            << acquiredLatencySum / numLatencyFrames << " ms if sampled after acquire." << std::endl;
+        lastLatencyReport = timings.presented;
+        latchedLatencySum = 0.0;
+        acquiredLatencySum = 0.0;
+        numLatencyFrames = 0;
+    }
+
+    static const char* MarcherName( const Marcher marcher )
+    {
+        return ( marcher == Marcher::SphereTracing ) ? "sphere tracing" : "over-relaxed sphere tracing";
+    }
+
+    static const char* ShadowName( const Shadow shadow )
+    {
+        switch ( shadow )
+        {
+        case Shadow::None: return "none";
+        case Shadow::Sharp: return "sharp";
+        case Shadow::Grid: return "soft, 25 rays per point";
+        case Shadow::Cone: return "soft, one cone-traced ray per point";
+        }
+        return "unknown";
+    }
+
+    // Prints once a second the average march steps per ray, over primary, shadow and secondary rays.
+    void ReportMarchSteps()
+    {
+        const auto now = svk::FrameTimings::Clock::now();
+        if ( now - lastStepsReport < std::chrono::seconds( 1 ) || countedRays == 0 )
+            return;
+        std::cout << "March steps per ray: " << double( countedSteps ) / double( countedRays )
+            << " (" << MarcherName( marcher ) << ", " << countedRays / numCountedFrames << " rays per frame)" << std::endl;
+        lastStepsReport = now;
+        countedSteps = 0;
+        countedRays = 0;
+        numCountedFrames = 0;
     }
 
     virtual void InitSwapChain() override
@@ -236,17 +922,19 @@ public:
             vertices,
             indices,
             std::string(PROJECT_NAME) + "/shader.vert.spv",
-            std::string(PROJECT_NAME) + "/shader.frag.spv"
+            std::string(PROJECT_NAME) + ( isCountingSteps ? "/shader_count_steps.frag.spv" : "/shader.frag.spv" )
         );
     }
 };
 
 
-int main()
+int main( int argc, char** argv )
 {
     AppExample app;
     try
     {
+        app.ParseCommandLine( argc, argv );
+        app.ParseMarchOptions( argc, argv );
         app.Init(
             800, // width
             600, // height
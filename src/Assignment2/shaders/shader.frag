@@ -1,16 +1,51 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 
 layout ( binding = 0 ) uniform UniformBufferObject {
     mat4 lookAt; // LookAt matrix.
+    mat4 crateToLocal; // Animated transforms from world to object coordinates.
+    mat4 reflectorToLocal;
+    vec4 blob; // Center of the blob, and amplitude of its surface displacement.
+    vec4 sdfBoxMin; // Box of bakedSdf, and its voxel size. Voxel size 0 if not baked.
+    vec4 sdfBoxSize;
     vec2 resolution; // Resolution of the screen.
     vec2 mouse; // Mouse coordinates.
     float time; // Time since startup, in seconds.
     float gamma; // Gamma correction parameter.
-    int shadow; // 0 = none, 1 = sharp, 2 = soft.
+    int shadow; // 0 = none, 1 = sharp, 2 = soft, 3 = soft from a single cone-traced ray.
+    int marcher; // 0 = sphere tracing, 1 = over-relaxed sphere tracing.
+    uint numTilesX; // Tiles per row of tileObjects, 0 to march all objects on every ray.
+    float blobPhase; // Phases of the surface displacement of the blob and of the waves, from [0,2*PI).
+    float wavePhase;
+    int fractalIterations;
+    float lodFootprint; // Width of the pixel cone of rays per unit distance, over the LOD quality. 0 for full detail.
 } uniforms;
 
 layout( binding = 1 ) uniform sampler2D texSampler;
 
+#ifdef COUNT_STEPS
+// Totals of the frame as 64-bit values in two words. Reset by the host.
+// Only written in the COUNT_STEPS variant, which needs the fragmentStoresAndAtomics feature.
+layout( binding = 2 ) buffer MarchCounters {
+    uint stepsLow;
+    uint stepsHigh;
+    uint raysLow;
+    uint raysHigh;
+} marchCounters;
+#endif
+
+
+// Objects of each screen tile of TILE_SIZE pixels, written by cull_tiles.comp.
+#define TILE_SIZE 16
+#define TILE_MASK_WORDS 2
+layout( std430, binding = 3 ) readonly buffer TileObjects {
+    uint tileObjects[];
+};
+
+
+// Distances to the static objects, written by bake_sdf.comp.
+layout( binding = 4 ) uniform sampler3D bakedSdf;
+
 
 layout(location = 0) out vec4 outColor;
 
@@ -38,16 +73,16 @@ layout(location = 0) out vec4 outColor;
 //   Refractions                  | X | See material parameter refractivity.
 //   Caustics                     |   |
 //   SDF Ambient Occlusions       |   |
-//   Texturing                    | X | See function check_flag.
+//   Texturing                    | X | See function mat_flag.
 //   Simple game                  | X | Camera positioning using keys. Check console output for more info.
 //   Progressive path tracing     |   |
 //   Basic post-processing        |   |
 //   Advanced post-processing     |   |
 //   Screen space reflections     |   |
 //   Screen space AO              |   |
-//   Simple own SDF               | X | See function check_refractor.
-//   Advanced own SDF             | X | See function check_fractal.
-//   Animated SDF                 | X | See function check_blob, check_flag.
+//   Simple own SDF               | X | See function dist_refractor.
+//   Advanced own SDF             | X | See function dist_fractal.
+//   Animated SDF                 | X | See functions dist_blob, dist_flag.
 //   Other?                       | X | Custom C++ wrapping.
 
 
@@ -83,6 +118,11 @@ layout(location = 0) out vec4 outColor;
  * the surface
  */
 #define HIT_RATIO 0.001
+/* Over-relaxation factor of enhanced sphere tracing, from [1,2). Steps are this
+ * much longer than the distance bound, until a step is found to overshoot.
+ * See Keinert et al., "Enhanced Sphere Tracing" (2014).
+ */
+#define RELAXATION 1.6
 
 
 struct material
@@ -100,33 +140,13 @@ struct material
 
 const material material_default = material( vec3(0.8), vec3(0.8), 20.0, 0.0, 0.0, -1, vec2(0), 0.0, 1.0 );
 
-// This lamp is positioned at the hole in the roof.
-// Consider it as a point light.
-const vec3 lamp_pos = vec3( 0.0, 3.1, 3.0 );
-const float lamp_delta_dist = 0.1; // distance to discard when tracing shadow rays.
-const vec3 light_area_radius = vec3( 0.5, 0.5, 0.5 );
 const int num_light_samples = 25;
 
 const int num_glossy_samples = 25;
 
 
-// Good resource for finding more building blocks for distance functions:
-// https://www.iquilezles.org/www/articles/distfunctions/distfunctions.htm
-
-/* Basic box distance field.
- *
- * Parameters:
- *  p   Point for which to evaluate the distance field
- *  b   "Radius" of the box
- *
- * Returns:
- *  Distance to the box from point p.
- */
-float box(vec3 p, vec3 b)
-{
-    vec3 d = abs(p) - b;
-    return min(max(d.x,max(d.y,d.z)),0.0) + length(max(d,0.0));
-}
+// The lamp, and the objects that do not move, are shared with bake_sdf.comp.
+#include "static_scene.glsl"
 
 /* Rotates point around origin along the X axis.
  *
@@ -189,78 +209,83 @@ vec3 rot_z(vec3 p, float a)
 }
 
 
-// Helper function to make angle from [0,2*PI).
-float regular_angle( const in float angle )
-{
-    return mod( angle, 2*PI );
-}
-
-
 /* Each object has a distance function and a material function. The distance
  * function evaluates the distance field of the object at a given point, and
  * the material function determines the surface material at a point.
+ * Marching only needs distances, so materials are evaluated once per hit,
+ * by map_material().
+ * Terms that only depend on time, like animated transforms and phases, are
+ * computed once per frame on the host, see LatchRenderEntry() in main.cpp.
  */
 
+/* Level of detail of the expensive objects: features narrower than the
+ * footprint of the ray, the width of its pixel cone at the point, are dropped.
+ * Set by the marchers before evaluating distances. Secondary and shadow rays
+ * continue the cone of their pixel from the primary hit.
+ */
+float lod_footprint = 0.0;
+float ray_cone_start = 0.0; // Distance from the eye to the origin of the current ray.
 
-void check_blob( const vec3 p, inout float min_dist, inout material mat )
+void set_lod_footprint( const float t )
 {
-    const vec3 center = vec3( -0.5, -2.2 + abs( sin(regular_angle( uniforms.time*3.0 )) ), 2.0 );
-    const vec3 p_loc = p - center;
-    // Get spherical coordinates.
+    lod_footprint = ( ray_cone_start + t ) * uniforms.lodFootprint;
+}
+
+
+#define OBJECT_BLOB 0
+#define OBJECT_ROOM 1
+#define OBJECT_CRATE 2
+#define OBJECT_SPHERE 3
+#define OBJECT_REFLECTOR 4
+#define OBJECT_REFRACTOR 5
+#define OBJECT_FRACTAL 6
+#define OBJECT_FLAG 7
+#define NUM_OBJECTS 8
+
+
+const float blob_radius = 0.8;
+const float blob_displacement = 0.07;
+
+float dist_blob( const vec3 p )
+{
+    const vec3 p_loc = p - uniforms.blob.xyz;
     const float rho = length( p_loc );
+
+    // The displacement fades out as it gets thinner than the footprint.
+    const float detail = 1.0 - smoothstep( 0.5*blob_displacement, blob_displacement, lod_footprint );
+    if ( detail <= 0.0 )
+        return rho - blob_radius;
+
+    // Get spherical coordinates.
     const float h = p_loc.y / rho;
     const float theta = asin(h);
     const float phi = atan(p_loc.z/p_loc.x) + ( (p_loc.x < 0) ? PI : 0.0);
 
-    const float t = 2.0 * uniforms.time;
-    float variation = sin(regular_angle( 10.0*theta + 5.0*t )) * (1.0-pow(h,4)) * sin(10.0*phi);
-    const float radius = 0.8 + variation * sin(t) * 0.07;
+    float variation = sin( 10.0*theta + uniforms.blobPhase ) * (1.0-pow(h,4)) * sin(10.0*phi);
+    const float radius = blob_radius + detail * variation * uniforms.blob.w;
 
-    const float dist = length(p_loc) - radius;
-    if ( dist < min_dist )
-        min_dist = dist;
-    else
-        return;
+    return rho - radius;
+}
 
-    mat = material_default;
+material mat_blob( const vec3 p )
+{
+    material mat = material_default;
     mat.diffuse = mat.specular = vec3( 1.0, 0.5, 0.3 );
+    return mat;
 }
 
 
-void check_sphere( const vec3 p, inout float min_dist, inout material mat )
+material mat_sphere( const vec3 p )
 {
-    const vec3 center = vec3( 1.5, -1.8, 4.0 );
-    const float radius = 1.2;
-
-    vec3 p_loc = p - center;
-
-    const float dist = length(p_loc) - radius;
-    if ( dist < min_dist )
-        min_dist = dist;
-    else
-        return;
-
-    mat = material_default;
+    material mat = material_default;
     mat.diffuse = mat.specular = vec3( 0.1, 0.2, 0.0 );
+    return mat;
 }
 
 
-void check_room( const vec3 p, inout float min_dist, inout material mat )
+material mat_room( const vec3 p )
 {
-    const vec3 dimensions = vec3( 3.0, 3.0, 6.0 );
-    const vec3 center = vec3( 0.0, 0.0, 0.0 );
-
-    const float dist = max(
-        -box( p - (lamp_pos-vec3(0,lamp_delta_dist,0)), light_area_radius ),
-        -box( p - center, dimensions )
-    );
-
-    if ( dist < min_dist )
-        min_dist = dist;
-    else
-        return;
-
-    mat = material_default;
+    material mat = material_default;
     if ( p.x <= -2.98 )
     {
         mat.diffuse = vec3( 1.0, 0.0, 0.0 );
@@ -274,80 +299,89 @@ void check_room( const vec3 p, inout float min_dist, inout material mat )
         mat.diffuse = vec3( 1.0, 1.0, 1.0 );
     }
     mat.specular = mat.diffuse;
+    return mat;
 }
 
 
-void check_crate( const vec3 p, inout float min_dist, inout material mat )
-{
-    const vec3 center = vec3( -1, -1, 5 );
-    const vec3 size = vec3( 1, 2, 1 );
+const vec3 crate_size = vec3( 1, 2, 1 );
 
-    const vec3 p_loc = rot_y( p - center, regular_angle(uniforms.time) );
+vec3 crate_local( const vec3 p )
+{
+    return ( uniforms.crateToLocal * vec4( p, 1.0 ) ).xyz;
+}
 
-    const float dist = box( p_loc, size );
-    if ( dist < min_dist )
-        min_dist = dist;
-    else
-        return;
+float dist_crate( const vec3 p )
+{
+    return box( crate_local( p ), crate_size );
+}
 
-    mat = material_default;
+material mat_crate( const vec3 p )
+{
+    const vec3 p_loc = crate_local( p );
+    material mat = material_default;
     if ( fract( p_loc.x + floor( p_loc.y * 2.0 ) * 0.5 + floor( p_loc.z * 2.0 ) * 0.5 ) < 0.5 )
         mat.diffuse = vec3( 0.0, 1.0, 1.0 );
     else
         mat.diffuse = vec3( 1.0, 1.0, 1.0 );
     mat.specular = vec3( 0.2, 0.2, 0.7 );
+    return mat;
 }
 
 
-void check_flag( const vec3 p, inout float min_dist, inout material mat )
+const vec3 flag_size = vec3( 1.5, 1.0, 0.1 );
+
+vec3 flag_local( const vec3 p )
 {
     const vec3 center = vec3( -2, 2, 3 );
-    const vec3 size = vec3( 1.5, 1.0, 0.1 );
     const float wave_size = 0.1;
 
     vec3 p_loc = p - center;
     p_loc = rot_y( p_loc, 0.25*PI );
 
-    p_loc.z += sin(regular_angle( -10.0*uniforms.time + 5.0*p_loc.x )) * wave_size;
+    p_loc.z += sin( 5.0*p_loc.x + uniforms.wavePhase ) * wave_size;
+    return p_loc;
+}
 
-    const float dist = box( p_loc, size );
-    if ( dist < min_dist )
-        min_dist = dist;
-    else
-        return;
+float dist_flag( const vec3 p )
+{
+    return box( flag_local( p ), flag_size );
+}
 
-    mat = material_default;
+material mat_flag( const vec3 p )
+{
+    const vec3 p_loc = flag_local( p );
+    material mat = material_default;
     mat.textureIdx = 0;
-    mat.texCoord = 0.5 * ( vec2(1) + vec2(1,-1)*(p_loc/size).xy );
+    mat.texCoord = 0.5 * ( vec2(1) + vec2(1,-1)*(p_loc/flag_size).xy );
+    return mat;
 }
 
 
-void check_reflector( const vec3 p, inout float min_dist, inout material mat )
+const vec3 reflector_size = vec3( 0.5, 0.8, 0.5 );
+
+vec3 reflector_local( const vec3 p )
 {
-    const vec3 center = vec3( -2, -2, 2.5 );
-    const vec3 size = vec3( 0.5, 0.8, 0.5 );
+    return ( uniforms.reflectorToLocal * vec4( p, 1.0 ) ).xyz;
+}
 
-    vec3 p_loc = p - center;
-    p_loc = rot_x( p_loc, -0.1 * PI );
-    p_loc = rot_y( p_loc, -0.1 * PI );
-    p_loc = rot_z( p_loc, -0.1 * PI );
-    p_loc = rot_y( p_loc, regular_angle(-uniforms.time) );
-
-    const float dist = box( p_loc, size );
-    if ( dist < min_dist )
-        min_dist = dist;
-    else
-        return;
+float dist_reflector( const vec3 p )
+{
+    return box( reflector_local( p ), reflector_size );
+}
 
-    mat = material_default;
+material mat_reflector( const vec3 p )
+{
+    const vec3 p_loc = reflector_local( p );
+    material mat = material_default;
     mat.diffuse = mat.specular = vec3( 0.2, 0.2, 0.7 );
     mat.reflectivity = 0.7;
-    if ( abs(p_loc.x/size.x) > abs(p_loc.z/size.z) )
+    if ( abs(p_loc.x/reflector_size.x) > abs(p_loc.z/reflector_size.z) )
         mat.reflectionGlossiness = 20.0;
+    return mat;
 }
 
 
-void check_refractor( const vec3 p, inout float min_dist, inout material mat )
+float dist_refractor( const vec3 p )
 {
     const vec3 center = vec3( 0, 0, 1 );
     const vec3 size = vec3( 1.5, 1.0, 0.1 );
@@ -356,23 +390,23 @@ void check_refractor( const vec3 p, inout float min_dist, inout material mat )
     vec3 p_loc = p - center;
     //p_loc = rot_y( p_loc, 0.25 * PI );
 
-    p_loc.z += sin( regular_angle( -10.0 * uniforms.time + 5.0 * p_loc.x ) ) * wave_size;
+    p_loc.z += sin( 5.0 * p_loc.x + uniforms.wavePhase ) * wave_size;
 
-    const float dist = box( p_loc, size );
-    if ( dist < min_dist )
-        min_dist = dist;
-    else
-        return;
+    return box( p_loc, size );
+}
 
-    mat = material_default;
+material mat_refractor( const vec3 p )
+{
+    material mat = material_default;
     mat.refractivity = 0.9;
     mat.refractionIndex = 1.2;
     //mat.textureIdx = 0;
     //mat.texCoord = 0.5 * (vec2( 1 ) + vec2( 1, -1 ) * (p_loc / size).xy);
+    return mat;
 }
 
 
-void check_fractal( const vec3 p, inout float min_dist, inout material mat )
+float dist_fractal( const vec3 p )
 {
     const vec3 center = vec3( 2, -2, 2 );
     const float sphere_radius = 0.2;
@@ -381,8 +415,10 @@ void check_fractal( const vec3 p, inout float min_dist, inout material mat )
     vec3 p_loc = (p - center) / size;
 
     const float Scale = 2.0;
-    const int MaxIterations = 8;
-    const int Iterations = 1 + int(2.0*uniforms.time) % MaxIterations;
+    // Level n has features of size*Scale^-n: finer levels than the footprint are not iterated.
+    int Iterations = uniforms.fractalIterations;
+    if ( lod_footprint > 0.0 )
+        Iterations = clamp( int( log2( size.x / lod_footprint ) / log2( Scale ) ), 1, Iterations );
 
     vec3 a1 = vec3( 1, 1, 1 );
     vec3 a2 = vec3( -1, -1, 1 );
@@ -402,52 +438,161 @@ void check_fractal( const vec3 p, inout float min_dist, inout material mat )
     }
 
     p_loc *= pow( Scale, float(-n) );
-    dist = length( p_loc ) - sphere_radius;
-
-    if ( dist < min_dist )
-        min_dist = dist;
-    else
-        return;
+    return length( p_loc ) - sphere_radius;
+}
 
-    mat = material_default;
+material mat_fractal( const vec3 p )
+{
+    material mat = material_default;
     mat.diffuse = mat.specular = vec3( 0.2, 0.2, 0.7 );
     mat.reflectivity = 0.3;
+    return mat;
+}
+
+
+/* Distance to the static objects, the room and the sphere, from bakedSdf.
+ * Interpolated distances are off by at most about a voxel diagonal, which is
+ * subtracted to keep them a lower bound. Near surfaces, where the marcher
+ * converges, and outside the box, the objects are evaluated analytically.
+ */
+#define SDF_ERROR_VOXELS 1.8
+#define SDF_REFINE_VOXELS 2.0
+#define STATIC_OBJECTS ( ( 1u << OBJECT_ROOM ) | ( 1u << OBJECT_SPHERE ) )
+
+float dist_static( const vec3 p )
+{
+    const float voxel = uniforms.sdfBoxMin.w;
+    if ( voxel > 0.0 )
+    {
+        const vec3 uvw = ( p - uniforms.sdfBoxMin.xyz ) / uniforms.sdfBoxSize.xyz;
+        if ( all( greaterThanEqual( uvw, vec3(0) ) ) && all( lessThanEqual( uvw, vec3(1) ) ) )
+        {
+            const float dist = texture( bakedSdf, uvw ).r - SDF_ERROR_VOXELS*voxel;
+            if ( dist > SDF_REFINE_VOXELS*voxel )
+                return dist;
+        }
+    }
+    return dist_static_analytic( p );
+}
+
+
+float dist_object( const int id, const vec3 p )
+{
+    switch ( id )
+    {
+    case OBJECT_BLOB: return dist_blob( p );
+    case OBJECT_ROOM: return dist_room( p );
+    case OBJECT_CRATE: return dist_crate( p );
+    case OBJECT_SPHERE: return dist_sphere( p );
+    case OBJECT_REFLECTOR: return dist_reflector( p );
+    case OBJECT_REFRACTOR: return dist_refractor( p );
+    case OBJECT_FRACTAL: return dist_fractal( p );
+    case OBJECT_FLAG: return dist_flag( p );
+    }
+    return MAX_DIST*2.0;
+}
+
+material mat_object( const int id, const vec3 p )
+{
+    switch ( id )
+    {
+    case OBJECT_BLOB: return mat_blob( p );
+    case OBJECT_ROOM: return mat_room( p );
+    case OBJECT_CRATE: return mat_crate( p );
+    case OBJECT_SPHERE: return mat_sphere( p );
+    case OBJECT_REFLECTOR: return mat_reflector( p );
+    case OBJECT_REFRACTOR: return mat_refractor( p );
+    case OBJECT_FRACTAL: return mat_fractal( p );
+    case OBJECT_FLAG: return mat_flag( p );
+    }
+    return material_default;
+}
+
+/* Primary rays stay in the cone of their screen tile, so they only march
+ * the objects of the tile, as listed by cull_tiles.comp. Other rays march all.
+ */
+bool march_tile_objects = false;
+uint tile_objects[TILE_MASK_WORDS];
+
+bool is_object_marched( const int id )
+{
+    return !march_tile_objects || ( tile_objects[id / 32] & ( 1u << ( id % 32 ) ) ) != 0u;
 }
 
-/* The distance function collecting all others.
+// Same as map_dist(), for the objects of the tile only. The room is in all tiles,
+// so the static objects are always marched.
+float map_dist_tile( in vec3 p )
+{
+    float min_dist = dist_static( p );
+    for ( int w = 0; w < TILE_MASK_WORDS; ++w )
+    {
+        uint mask = tile_objects[w];
+        if ( w == 0 )
+            mask &= ~STATIC_OBJECTS;
+        while ( mask != 0u )
+        {
+            const int bit = findLSB( mask );
+            mask &= mask - 1u;
+            min_dist = min( min_dist, dist_object( 32*w + bit, p ) );
+        }
+    }
+    return min_dist;
+}
+
+/* The distance function collecting all others. Called on every march step,
+ * so it only evaluates distances.
  *
  * Parameters:
  *  p   The point for which to find the nearest surface
- *  mat The material of the nearest surface
  *
  * Returns:
  *  The distance to the nearest surface.
  */
-float map(
-    in vec3 p,
-    out material mat
-){
+float map_dist( in vec3 p )
+{
+    if ( march_tile_objects )
+        return map_dist_tile( p );
+
     float min_dist = MAX_DIST*2.0;
 
-    check_blob( p, min_dist, mat );
-    check_room( p, min_dist, mat );
-    check_crate( p, min_dist, mat );
-    check_sphere( p, min_dist, mat );
+    min_dist = min( min_dist, dist_static( p ) );
+    min_dist = min( min_dist, dist_blob( p ) );
+    min_dist = min( min_dist, dist_crate( p ) );
 
     // Add your own objects here!
-    check_reflector( p, min_dist, mat );
-    check_refractor( p, min_dist, mat );
-    check_fractal( p, min_dist, mat );
-    check_flag( p, min_dist, mat );
+    min_dist = min( min_dist, dist_reflector( p ) );
+    min_dist = min( min_dist, dist_refractor( p ) );
+    min_dist = min( min_dist, dist_fractal( p ) );
+    min_dist = min( min_dist, dist_flag( p ) );
 
     return min_dist;
 }
 
+/* Material of the surface closest to point p. Called once per hit.
+ * On equal distances, the object with the lower OBJECT_* id wins.
+ */
+material map_material( in vec3 p )
+{
+    float min_dist = MAX_DIST*2.0;
+    int closest = -1;
+    for ( int id = 0; id < NUM_OBJECTS; ++id )
+    {
+        if ( !is_object_marched( id ) )
+            continue;
+        const float dist = dist_object( id, p );
+        if ( dist < min_dist )
+        {
+            min_dist = dist;
+            closest = id;
+        }
+    }
+    return mat_object( closest, p );
+}
+
 /* Calculates the normal of the surface closest to point p.
  *
  * Parameters:
  *  p   The point where the normal should be calculated
- *  mat The material information, produced as a byproduct
  *
  * Returns:
  *  The normal of the surface.
@@ -455,68 +600,180 @@ float map(
  * See https://www.iquilezles.org/www/articles/normalsSDF/normalsSDF.htm
  * if you're interested in how this works.
  */
-vec3 normal(vec3 p, out material mat)
+vec3 normal(vec3 p)
 {
     const vec2 k = vec2(1.0, -1.0);
     return normalize(
-        k.xyy * map(p + k.xyy * EPSILON, mat) +
-        k.yyx * map(p + k.yyx * EPSILON, mat) +
-        k.yxy * map(p + k.yxy * EPSILON, mat) +
-        k.xxx * map(p + k.xxx * EPSILON, mat)
+        k.xyy * map_dist(p + k.xyy * EPSILON) +
+        k.yyx * map_dist(p + k.yyx * EPSILON) +
+        k.yxy * map_dist(p + k.yxy * EPSILON) +
+        k.xxx * map_dist(p + k.xxx * EPSILON)
     );
 }
 
-/* Finds the closest intersection of the ray with the scene.
+// Steps and rays of march() in this invocation.
+uint march_steps = 0u;
+uint march_rays = 0u;
+
+/* Marches the ray until it hits a surface, with distances only.
+ * Enough for shadow rays, which need no normal and material.
  *
  * Parameters:
  *  o           Origin of the ray
  *  v           Direction of the ray
  *  max_dist    Maximum distance the ray can travel. Usually MAX_DIST.
  *  p           Location of the intersection
- *  n           Normal of the surface at the intersection point
- *  mat         Material of the intersected surface
  *  inside      Whether we are marching inside an object or not. Useful for
  *              refractions.
  *
  * Returns:
  *  true if a surface was hit, false otherwise.
  */
-bool intersect(
+bool march(
     in vec3 o,
     in vec3 v,
     in float max_dist,
     out vec3 p,
-    out vec3 n,
-    out material mat,
     bool inside
 ) {
     float t = MIN_DIST;
     float dir = inside ? -1.0 : 1.0;
     bool hit = false;
+    int i = 0;
+
+    if ( uniforms.marcher == 1 )
+    {
+        // Enhanced sphere tracing: over-relaxed steps. The unbounding spheres of consecutive
+        // points must overlap, otherwise the step may have skipped a surface. Then the step
+        // is redone from the previous point as a plain one, and the rest of the ray is plain.
+        float omega = RELAXATION;
+        float step_length = 0.0;
+        float previous_radius = 0.0;
+        for(; i < MARCH_MAX_STEPS; ++i)
+        {
+            p = o + t * v;
+            set_lod_footprint( t );
+            float dist = dir * map_dist(p);
+            float radius = abs(dist);
 
-    for(int i = 0; i < MARCH_MAX_STEPS; ++i)
+            if ( omega > 1.0 && radius + previous_radius < step_length )
+            {
+                t += previous_radius * STEP_RATIO - step_length;
+                omega = 1.0;
+                continue;
+            }
+
+            hit = radius < HIT_RATIO * t;
+
+            if(hit || t > max_dist) break;
+
+            step_length = dist * omega * STEP_RATIO;
+            previous_radius = radius;
+            t += step_length;
+        }
+    }
+    else
     {
-        p = o + t * v;
-        float dist = dir * map(p, mat);
+        for(; i < MARCH_MAX_STEPS; ++i)
+        {
+            p = o + t * v;
+            set_lod_footprint( t );
+            float dist = dir * map_dist(p);
 
-        hit = abs(dist) < HIT_RATIO * t;
+            hit = abs(dist) < HIT_RATIO * t;
 
-        if(hit || t > max_dist) break;
+            if(hit || t > max_dist) break;
 
-        t += dist * STEP_RATIO;
+            t += dist * STEP_RATIO;
+        }
     }
 
-    n = normal(p, mat);
+    march_steps += uint( min( i + 1, MARCH_MAX_STEPS ) );
+    march_rays += 1u;
 
     return hit;
 }
 
+/* Finds the closest intersection of the ray with the scene.
+ *
+ * Parameters:
+ *  o           Origin of the ray
+ *  v           Direction of the ray
+ *  max_dist    Maximum distance the ray can travel. Usually MAX_DIST.
+ *  p           Location of the intersection
+ *  n           Normal of the surface at the intersection point, if hit
+ *  mat         Material of the intersected surface, if hit
+ *  inside      Whether we are marching inside an object or not. Useful for
+ *              refractions.
+ *
+ * Returns:
+ *  true if a surface was hit, false otherwise.
+ */
+bool intersect(
+    in vec3 o,
+    in vec3 v,
+    in float max_dist,
+    out vec3 p,
+    out vec3 n,
+    out material mat,
+    bool inside
+) {
+    const bool hit = march( o, v, max_dist, p, inside );
+    if ( hit )
+    {
+        n = normal(p);
+        mat = map_material(p);
+    }
+    return hit;
+}
+
+
+/* Soft shadow from one march toward the light center, instead of a ray per
+ * light sample. At distance t along the ray, an occluder at distance h from it
+ * hides the light up to an angle of about h/t, against the angular radius of
+ * the light, light_radius/dist_to_light. The smallest ratio along the ray gives
+ * the lit fraction. See https://iquilezles.org/articles/rmshadows/
+ *
+ * The light is the square of the samples of the grid soft shadows, below the
+ * lamp. The march stops at its plane: the walls of the hole in the roof, beyond
+ * it, would otherwise count as occluders and darken fully lit points.
+ */
+float ConeShadowing( const in vec3 position )
+{
+    const int sqrt_num_light_samples = int( sqrt( num_light_samples ) );
+    const vec3 sample_extent = light_area_radius * ( 1.0 - 1.0 / float( sqrt_num_light_samples ) );
+    const float sample_plane = lamp_pos.y - sample_extent.y;
+
+    // Points above the sample plane march toward the center of the square instead.
+    const bool below = position.y < sample_plane;
+    const vec3 lightPos = below ? lamp_pos : vec3( lamp_pos.x, sample_plane, lamp_pos.z );
+    const float distToLight = length( lightPos - position );
+    const vec3 dirToLight = (lightPos - position) / distToLight;
+    const float k = distToLight / sample_extent.x;
+    const float max_t = below ? distToLight * ( sample_plane - position.y ) / ( lightPos.y - position.y ) : distToLight;
+
+    float lit = 1.0;
+    float t = MIN_DIST;
+    for ( int i = 0; i < MARCH_MAX_STEPS && t < max_t; ++i )
+    {
+        march_steps += 1u;
+        set_lod_footprint( t );
+        const float h = map_dist( position + t*dirToLight );
+        lit = min( lit, k*h/t );
+        if ( h < HIT_RATIO * t )
+            break;
+        t += h * STEP_RATIO;
+    }
+    march_rays += 1u;
+
+    return mix( 0.2, 1.0, smoothstep( 0.0, 1.0, clamp( lit, 0.0, 1.0 ) ) );
+}
+
 
 float GetShadowing( const in vec3 position )
 {
-    // Dummy parameters.
-    vec3 p_dummy, n_dummy;
-    material mat;
+    // Dummy parameter.
+    vec3 p_dummy;
 
     if ( uniforms.shadow == 0 )
     {
@@ -528,14 +785,18 @@ float GetShadowing( const in vec3 position )
         // Sharp shadow.
         const float distToLight = length( lamp_pos - position );
         const vec3 dirToLight = (lamp_pos - position) / distToLight;
-        if ( intersect( position + EPSILON*dirToLight, dirToLight - 2.0*EPSILON - lamp_delta_dist, distToLight, p_dummy, n_dummy, mat, false ) )
+        if ( march( position + EPSILON*dirToLight, dirToLight - 2.0*EPSILON - lamp_delta_dist, distToLight, p_dummy, false ) )
             return 0.2;
         else
             return 1.0;
     }
+    else if ( uniforms.shadow == 3 )
+    {
+        return ConeShadowing( position );
+    }
     else if ( uniforms.shadow == 2 )
     {
-        // Soft shadow.
+        // Soft shadow, from a grid of rays toward the area light.
         const int sqrt_num_light_samples = int( sqrt( num_light_samples ) );
         float shadowing = 0.0;
         for ( int ix = 0; ix < sqrt_num_light_samples; ++ix )
@@ -547,7 +808,7 @@ float GetShadowing( const in vec3 position )
                 const vec3 lightPos = lamp_pos + lambda*light_area_radius;
                 const float distToLight = length( lightPos - position );
                 const vec3 dirToLight = (lightPos - position) / distToLight;
-                if ( intersect( position + EPSILON*dirToLight, dirToLight - 2.0*EPSILON - lamp_delta_dist, distToLight, p_dummy, n_dummy, mat, false ) )
+                if ( march( position + EPSILON*dirToLight, dirToLight - 2.0*EPSILON - lamp_delta_dist, distToLight, p_dummy, false ) )
                     shadowing += 0.2;
                 else
                     shadowing += 1.0;
@@ -622,10 +883,15 @@ vec3 render( vec3 rayOri, vec3 rayDir )
 
     vec3 color = vec3(0);
 
-    // Compute intersection point along the view ray.
+    // Compute intersection point along the view ray, with the objects of its tile.
     vec3 p, n;
-    if ( intersect( rayOri, rayDir, MAX_DIST, p, n, mat, false ) )
+    march_tile_objects = uniforms.numTilesX > 0u;
+    const bool hit = intersect( rayOri, rayDir, MAX_DIST, p, n, mat, false );
+    march_tile_objects = false;
+    if ( hit )
     {
+        ray_cone_start = length( p - rayOri );
+
         color = GetSurfaceColor( p, n, mat, rayDir );
 
         // Reflection.
@@ -684,7 +950,7 @@ vec3 render( vec3 rayOri, vec3 rayDir )
             const vec3 tanDir = normalize( rayDir - n*cosIn );
             const vec3 rayDir_refr = -n*cosOut + tanDir*sinOut;
             // Dirty hack: skip one internal intersection.
-            intersect( p + EPSILON*rayDir_refr, rayDir_refr, MAX_DIST, p_refr, n_refr, mat_refr, true );
+            march( p + EPSILON*rayDir_refr, rayDir_refr, MAX_DIST, p_refr, true );
             if ( intersect( p_refr + EPSILON*rayDir_refr, rayDir_refr, MAX_DIST, p_refr, n_refr, mat_refr, false ) )
                 color_refr += GetSurfaceColor( p_refr, n_refr, mat_refr, rayDir_refr );
         }
@@ -712,5 +978,23 @@ void main()
     const vec3 rayTarget = ( uniforms.lookAt * vec4( uv.x * aspect, uv.y, 1.0, 1.0 ) ).xyz;
     const vec3 rayDir    = normalize( rayTarget - rayOri );
 
+    if ( uniforms.numTilesX > 0u )
+    {
+        const uvec2 tile = uvec2( gl_FragCoord.xy ) / TILE_SIZE;
+        const uint first = ( tile.y * uniforms.numTilesX + tile.x ) * TILE_MASK_WORDS;
+        for ( int w = 0; w < TILE_MASK_WORDS; ++w )
+            tile_objects[w] = tileObjects[first + w];
+    }
+
     outColor = vec4( render( rayOri, rayDir ), 1.0 );
+
+#ifdef COUNT_STEPS
+    // One atomic per counter and pixel. The high word counts wraps of the low word.
+    const uint steps = atomicAdd( marchCounters.stepsLow, march_steps );
+    if ( steps + march_steps < steps )
+        atomicAdd( marchCounters.stepsHigh, 1u );
+    const uint rays = atomicAdd( marchCounters.raysLow, march_rays );
+    if ( rays + march_rays < rays )
+        atomicAdd( marchCounters.raysHigh, 1u );
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,54 @@
+// Static part of the Assignment 2 scene: the lamp, and the objects that do not move.
+// Included by shader.frag, which marches them, and by bake_sdf.comp, which bakes their distances.
+
+
+// This lamp is positioned at the hole in the roof.
+// Consider it as a point light.
+const vec3 lamp_pos = vec3( 0.0, 3.1, 3.0 );
+const float lamp_delta_dist = 0.1; // distance to discard when tracing shadow rays.
+const vec3 light_area_radius = vec3( 0.5, 0.5, 0.5 );
+
+
+// Good resource for finding more building blocks for distance functions:
+// https://www.iquilezles.org/www/articles/distfunctions/distfunctions.htm
+
+/* Basic box distance field.
+ *
+ * Parameters:
+ *  p   Point for which to evaluate the distance field
+ *  b   "Radius" of the box
+ *
+ * Returns:
+ *  Distance to the box from point p.
+ */
+float box(vec3 p, vec3 b)
+{
+    vec3 d = abs(p) - b;
+    return min(max(d.x,max(d.y,d.z)),0.0) + length(max(d,0.0));
+}
+
+
+float dist_sphere( const vec3 p )
+{
+    const vec3 center = vec3( 1.5, -1.8, 4.0 );
+    const float radius = 1.2;
+
+    return length( p - center ) - radius;
+}
+
+float dist_room( const vec3 p )
+{
+    const vec3 dimensions = vec3( 3.0, 3.0, 6.0 );
+    const vec3 center = vec3( 0.0, 0.0, 0.0 );
+
+    return max(
+        -box( p - (lamp_pos-vec3(0,lamp_delta_dist,0)), light_area_radius ),
+        -box( p - center, dimensions )
+    );
+}
+
+// Distance to the closest static object.
+float dist_static_analytic( const vec3 p )
+{
+    return min( dist_room( p ), dist_sphere( p ) );
+}
@@ -0,0 +1,168 @@
+#ifndef MICROBENCHMARKS_BENCHMARK_H
+#define MICROBENCHMARKS_BENCHMARK_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+
+// Command line options in the form --key=value (or --flag).
+class BenchmarkOptions
+{
+public:
+
+    BenchmarkOptions( int argc, char** argv )
+    {
+        for ( int i = 1; i < argc; ++i )
+        {
+            std::string arg = argv[i];
+            if ( arg.rfind( "--", 0 ) != 0 )
+                continue;
+            arg = arg.substr( 2 );
+            const size_t eq = arg.find( '=' );
+            if ( eq == std::string::npos )
+                values[arg] = "1";
+            else
+                values[ arg.substr( 0, eq ) ] = arg.substr( eq + 1 );
+        }
+    }
+
+    bool Has( const std::string& key ) const { return values.count( key ) != 0; }
+
+    std::string GetString( const std::string& key, const std::string& defaultValue ) const
+    {
+        const auto it = values.find( key );
+        return ( it != values.end() ) ? it->second : defaultValue;
+    }
+
+    long long GetInt( const std::string& key, const long long defaultValue ) const
+    {
+        const auto it = values.find( key );
+        return ( it != values.end() ) ? std::atoll( it->second.c_str() ) : defaultValue;
+    }
+
+private:
+    std::map<std::string, std::string> values;
+};
+
+
+struct Timing
+{
+    double minSeconds = 0.0;
+    double medianSeconds = 0.0;
+    double meanSeconds = 0.0;
+    double stddevSeconds = 0.0;
+    // Half width of the 95% confidence interval of the mean.
+    double confidenceSeconds = 0.0;
+    int numRuns = 0;
+};
+
+
+// Two-sided 95% quantile of Student's t distribution with degreesOfFreedom.
+inline double StudentT95( const int degreesOfFreedom )
+{
+    static const double table[] = { 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086 };
+    if ( degreesOfFreedom < 1 )
+        return 0.0;
+    if ( degreesOfFreedom <= 20 )
+        return table[degreesOfFreedom - 1];
+    if ( degreesOfFreedom <= 30 )
+        return 2.042;
+    if ( degreesOfFreedom <= 60 )
+        return 2.000;
+    return 1.960;
+}
+
+
+// Runs func numWarmup times, then numRuns times, and summarizes the seconds it returns for the latter.
+// For measurements that exclude setup or cleanup in func.
+template< typename Func >
+Timing MeasureSamples( Func&& func, const int numWarmup, const int numRuns )
+{
+    for ( int i = 0; i < numWarmup; ++i )
+        func();
+
+    std::vector<double> seconds( numRuns );
+    for ( int i = 0; i < numRuns; ++i )
+        seconds[i] = func();
+
+    Timing timing;
+    timing.numRuns = numRuns;
+    if ( numRuns == 0 )
+        return timing;
+
+    std::sort( seconds.begin(), seconds.end() );
+    timing.minSeconds = seconds.front();
+    timing.medianSeconds = seconds[ numRuns / 2 ];
+    for ( const double s : seconds )
+        timing.meanSeconds += s;
+    timing.meanSeconds /= numRuns;
+    if ( numRuns > 1 )
+    {
+        double sumSquares = 0.0;
+        for ( const double s : seconds )
+            sumSquares += ( s - timing.meanSeconds ) * ( s - timing.meanSeconds );
+        timing.stddevSeconds = std::sqrt( sumSquares / ( numRuns - 1 ) );
+        timing.confidenceSeconds = StudentT95( numRuns - 1 ) * timing.stddevSeconds / std::sqrt( double( numRuns ) );
+    }
+    return timing;
+}
+
+
+// Runs func numWarmup times unmeasured, then numRuns times measured.
+template< typename Func >
+Timing Measure( Func&& func, const int numWarmup, const int numRuns )
+{
+    using Clock = std::chrono::steady_clock;
+
+    return MeasureSamples( [&]
+    {
+        const auto start = Clock::now();
+        func();
+        return std::chrono::duration<double>( Clock::now() - start ).count();
+    }, numWarmup, numRuns );
+}
+
+
+inline void PrintTiming( const std::string& name, const Timing& timing, const double itemsPerRun, const std::string& itemName )
+{
+    std::cout << name
+        << ": median " << 1e3 * timing.medianSeconds << " ms"
+        << ", min " << 1e3 * timing.minSeconds << " ms"
+        << ", mean " << 1e3 * timing.meanSeconds << " +- " << 1e3 * timing.confidenceSeconds << " ms"
+        << ", " << ( itemsPerRun / timing.medianSeconds ) * 1e-6 << " M" << itemName << "/s"
+        << " (" << timing.numRuns << " runs)" << std::endl;
+}
+
+
+// Per-operation latency, for runs of opsPerRun operations.
+inline void PrintLatency( const std::string& name, const Timing& timing, const double opsPerRun )
+{
+    std::cout << name
+        << ": median " << 1e6 * timing.medianSeconds / opsPerRun << " us"
+        << ", min " << 1e6 * timing.minSeconds / opsPerRun << " us"
+        << ", mean " << 1e6 * timing.meanSeconds / opsPerRun << " +- " << 1e6 * timing.confidenceSeconds / opsPerRun << " us"
+        << " (" << timing.numRuns << " runs of " << opsPerRun << ")" << std::endl;
+}
+
+
+// Benchmark suites.
+
+void RunMeshBenchmarks( const BenchmarkOptions& options );
+
+void RunParticleBenchmarks( const BenchmarkOptions& options );
+
+void RunRandomBenchmarks( const BenchmarkOptions& options );
+
+void RunTraceBenchmarks( const BenchmarkOptions& options );
+
+void RunVulkanBenchmarks( const BenchmarkOptions& options );
+
+
+#endif // MICROBENCHMARKS_BENCHMARK_H
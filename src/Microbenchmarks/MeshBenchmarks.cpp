@@ -0,0 +1,196 @@
+#include "Benchmark.h"
+#include "MeshIndexing.h"
+#include "MeshOptimizer.h"
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+#include <glm/gtx/hash.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+
+namespace {
+
+
+const std::string MODEL_PATH = std::string(ROOT_DIRECTORY) + "/media/viking_room.obj";
+
+
+// Unquantized 32-byte vertex, as Task4 used to upload it.
+struct Vertex {
+    glm::vec3 pos;
+    glm::vec3 color;
+    glm::vec2 texCoord;
+
+    bool operator==(const Vertex& other) const {
+        return pos == other.pos && color == other.color && texCoord == other.texCoord;
+    }
+};
+
+
+struct LegacyVertexHash {
+    size_t operator()(Vertex const& vertex) const {
+        return ((std::hash<glm::vec3>()(vertex.pos) ^ (std::hash<glm::vec3>()(vertex.color) << 1)) >> 1) ^ (std::hash<glm::vec2>()(vertex.texCoord) << 1);
+    }
+};
+
+
+// The deduplication that loadModel used before svk::BuildIndexedMesh.
+void BuildIndexedMeshLegacy( const std::vector<Vertex>& corners, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices )
+{
+    vertices.clear();
+    indices.clear();
+    std::unordered_map<Vertex, uint32_t, LegacyVertexHash> uniqueVertices{};
+    for ( const auto& vertex : corners )
+    {
+        if (uniqueVertices.count(vertex) == 0) {
+            uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
+            vertices.push_back(vertex);
+        }
+        indices.push_back(uniqueVertices[vertex]);
+    }
+}
+
+
+std::vector<Vertex> LoadModelCorners()
+{
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warn, err;
+
+    if ( !tinyobj::LoadObj( &attrib, &shapes, &materials, &warn, &err, MODEL_PATH.c_str() ) )
+        throw std::runtime_error( warn + err );
+
+    std::vector<Vertex> corners;
+    for ( const auto& shape : shapes )
+    {
+        for ( const auto& index : shape.mesh.indices )
+        {
+            Vertex vertex{};
+            vertex.pos = {
+                attrib.vertices[3 * index.vertex_index + 0],
+                attrib.vertices[3 * index.vertex_index + 1],
+                attrib.vertices[3 * index.vertex_index + 2]
+            };
+            vertex.texCoord = {
+                attrib.texcoords[2 * index.texcoord_index + 0],
+                1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
+            };
+            vertex.color = {1.0f, 1.0f, 1.0f};
+            corners.push_back( vertex );
+        }
+    }
+    return corners;
+}
+
+
+// Regular grid of quads, two triangles each, emitted as unindexed corners.
+std::vector<Vertex> GenerateGridCorners( const size_t numTriangles )
+{
+    const size_t numQuads = ( numTriangles + 1 ) / 2;
+    const size_t numX = std::max<size_t>( 1, size_t( std::sqrt( double( numQuads ) ) ) );
+    const size_t numY = ( numQuads + numX - 1 ) / numX;
+
+    const auto gridVertex = [&]( const size_t x, const size_t y )
+    {
+        Vertex vertex{};
+        vertex.texCoord = { float(x) / float(numX), float(y) / float(numY) };
+        vertex.pos = { vertex.texCoord.x, vertex.texCoord.y, 0.0f };
+        vertex.color = { 1.0f, 1.0f, 1.0f };
+        return vertex;
+    };
+
+    std::vector<Vertex> corners( 3 * numTriangles );
+    svk::ParallelFor( numQuads, [&]( const size_t begin, const size_t end )
+    {
+        for ( size_t quad = begin; quad < end; ++quad )
+        {
+            const size_t x = quad % numX;
+            const size_t y = quad / numX;
+            const Vertex quadCorners[6] = {
+                gridVertex( x, y ), gridVertex( x+1, y ), gridVertex( x, y+1 ),
+                gridVertex( x+1, y+1 ), gridVertex( x, y+1 ), gridVertex( x+1, y ),
+            };
+            for ( size_t i = 0; i < 6 && 6*quad + i < corners.size(); ++i )
+                corners[ 6*quad + i ] = quadCorners[i];
+        }
+    } );
+    return corners;
+}
+
+
+void BenchmarkDeduplication( const std::string& name, const std::vector<Vertex>& corners, const BenchmarkOptions& options )
+{
+    const int numRuns = int( options.GetInt( "runs", 5 ) );
+    const double numCorners = double( corners.size() );
+
+    std::cout << name << ": " << corners.size() / 3 << " triangles, " << svk::NumParallelThreads() << " threads" << std::endl;
+
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    const Timing timing = Measure( [&] { svk::BuildIndexedMesh( corners, vertices, indices ); }, 1, numRuns );
+    PrintTiming( "  svk::BuildIndexedMesh", timing, numCorners, "corners" );
+    std::cout << "  unique vertices: " << vertices.size() << std::endl;
+
+    if ( options.Has( "skip-legacy" ) )
+        return;
+
+    std::vector<Vertex> legacyVertices;
+    std::vector<uint32_t> legacyIndices;
+    const Timing legacyTiming = Measure( [&] { BuildIndexedMeshLegacy( corners, legacyVertices, legacyIndices ); }, 0, std::max( 1, numRuns / 2 ) );
+    PrintTiming( "  std::unordered_map", legacyTiming, numCorners, "corners" );
+    std::cout << "  speedup: " << legacyTiming.medianSeconds / timing.medianSeconds << "x" << std::endl;
+
+    const bool isSame = legacyIndices == indices
+        && legacyVertices.size() == vertices.size()
+        && memcmp( legacyVertices.data(), vertices.data(), vertices.size() * sizeof(Vertex) ) == 0;
+    std::cout << "  identical output: " << ( isSame ? "yes" : "NO" ) << std::endl;
+}
+
+
+void BenchmarkOptimization( const std::string& name, const std::vector<Vertex>& corners, const BenchmarkOptions& options )
+{
+    const int numRuns = int( options.GetInt( "runs", 5 ) );
+
+    std::vector<Vertex> sourceVertices;
+    std::vector<uint32_t> sourceIndices;
+    svk::BuildIndexedMesh( corners, sourceVertices, sourceIndices );
+    std::cout << name << ": " << sourceIndices.size() / 3 << " triangles, " << sourceVertices.size() << " vertices" << std::endl;
+
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    svk::MeshOptimizationReport report;
+    const Timing timing = Measure( [&]
+    {
+        vertices = sourceVertices;
+        indices = sourceIndices;
+        report = svk::OptimizeMesh( vertices, indices, offsetof(Vertex, pos) );
+    }, 0, numRuns );
+    PrintTiming( "  svk::OptimizeMesh", timing, double( indices.size() / 3 ), "triangles" );
+    std::cout << "  ACMR: " << report.before.acmr << " -> " << report.after.acmr << std::endl;
+    std::cout << "  ATVR: " << report.before.atvr << " -> " << report.after.atvr << std::endl;
+}
+
+
+} // namespace
+
+
+void RunMeshBenchmarks( const BenchmarkOptions& options )
+{
+    BenchmarkDeduplication( "mesh/dedup/viking_room", LoadModelCorners(), options );
+
+    const size_t numTriangles = size_t( options.GetInt( "triangles", 10000000 ) );
+    BenchmarkDeduplication( "mesh/dedup/grid", GenerateGridCorners( numTriangles ), options );
+
+    BenchmarkOptimization( "mesh/optimize/viking_room", LoadModelCorners(), options );
+    const size_t numOptimizeTriangles = size_t( options.GetInt( "optimize-triangles", 1000000 ) );
+    BenchmarkOptimization( "mesh/optimize/grid", GenerateGridCorners( numOptimizeTriangles ), options );
+}
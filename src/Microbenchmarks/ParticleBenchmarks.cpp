@@ -0,0 +1,147 @@
+#include "Benchmark.h"
+#include "Parallel.h"
+#include "ParticleIntegrator.h"
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+
+namespace {
+
+
+// Deterministic pseudo-random value from [-1,1].
+float HashValue( const size_t i, const uint32_t salt )
+{
+    uint32_t x = uint32_t( i ) * 0x9E3779B9u ^ salt;
+    x ^= x >> 16;
+    x *= 0x85EBCA6Bu;
+    x ^= x >> 13;
+    x *= 0xC2B2AE35u;
+    x ^= x >> 16;
+    return float( x ) / float( UINT32_MAX ) * 2.0f - 1.0f;
+}
+
+
+bool IsSame( const std::vector<float>& a, const std::vector<float>& b )
+{
+    return a.size() == b.size() && memcmp( a.data(), b.data(), a.size() * sizeof(float) ) == 0;
+}
+
+
+svk::ExplodeParticles GenerateExplosion( const size_t numParticles )
+{
+    // Just exploded: large speeds, no shift yet, as after a click in Task5.
+    svk::ExplodeParticles particles;
+    particles.Resize( numParticles );
+    for ( size_t i = 0; i < numParticles; ++i )
+    {
+        particles.speedX[i] = 5.0f * HashValue( i, 1 );
+        particles.speedY[i] = 5.0f * HashValue( i, 2 );
+    }
+    return particles;
+}
+
+
+svk::RigidBodies2D GenerateBodies( const size_t numBodies )
+{
+    svk::RigidBodies2D bodies;
+    bodies.Resize( numBodies );
+    for ( size_t i = 0; i < numBodies; ++i )
+    {
+        bodies.positionX[i] = 0.5f * HashValue( i, 3 );
+        bodies.positionY[i] = 0.5f * HashValue( i, 4 );
+        bodies.speedX[i] = 0.2f * HashValue( i, 5 );
+        bodies.speedY[i] = 0.2f * HashValue( i, 6 );
+        bodies.angle[i] = float( M_PI ) * HashValue( i, 7 );
+        bodies.angularSpeed[i] = 1.0f;
+    }
+    return bodies;
+}
+
+
+void BenchmarkExplosion( const BenchmarkOptions& options )
+{
+    const size_t numParticles = size_t( options.GetInt( "particles", 1000000 ) );
+    const int numRuns = int( options.GetInt( "runs", 5 ) );
+    const int numSteps = 10;
+    const float deltaTime = 1.0f / 60.0f;
+    const svk::ExplodeParameters parameters;
+
+    std::cout << "particles/explode: " << numParticles << " particles, " << numSteps << " steps per run, "
+        << svk::NumParallelThreads() << " threads" << std::endl;
+
+    svk::ExplodeParticles scalar, simd;
+    const Timing scalarTiming = Measure( [&]
+    {
+        scalar = GenerateExplosion( numParticles );
+        for ( int step = 0; step < numSteps; ++step )
+            svk::StepExplodeParticles( scalar, parameters, deltaTime, svk::SimdPath::Scalar );
+    }, 0, numRuns );
+    const Timing simdTiming = Measure( [&]
+    {
+        simd = GenerateExplosion( numParticles );
+        for ( int step = 0; step < numSteps; ++step )
+            svk::StepExplodeParticles( simd, parameters, deltaTime, svk::SimdPath::Best );
+    }, 0, numRuns );
+
+    // Timings include generation of the initial state, which is the same for both.
+    PrintTiming( "  scalar", scalarTiming, double( numParticles ) * numSteps, "particles" );
+    PrintTiming( std::string( "  " ) + svk::BestSimdPathName(), simdTiming, double( numParticles ) * numSteps, "particles" );
+    std::cout << "  speedup: " << scalarTiming.medianSeconds / simdTiming.medianSeconds << "x" << std::endl;
+
+    const bool isSame = IsSame( scalar.speedX, simd.speedX ) && IsSame( scalar.speedY, simd.speedY ) && IsSame( scalar.speedZ, simd.speedZ )
+        && IsSame( scalar.shiftX, simd.shiftX ) && IsSame( scalar.shiftY, simd.shiftY ) && IsSame( scalar.shiftZ, simd.shiftZ );
+    std::cout << "  identical output: " << ( isSame ? "yes" : "NO" ) << std::endl;
+    if ( !isSame )
+        throw std::runtime_error( "particles/explode: SIMD output differs from scalar" );
+}
+
+
+void BenchmarkRigidBodies( const BenchmarkOptions& options )
+{
+    const size_t numBodies = size_t( options.GetInt( "bodies", 1000000 ) );
+    const int numRuns = int( options.GetInt( "runs", 5 ) );
+    const int numSteps = 10;
+    const float deltaTime = 1.0f / 60.0f;
+
+    // Task1b triangle.
+    const std::vector<float> outline = { 0.0f, -0.2f,   0.2f, 0.2f,   -0.2f, 0.2f };
+
+    std::cout << "particles/rigid2d: " << numBodies << " bodies, " << numSteps << " steps per run, "
+        << svk::NumParallelThreads() << " threads" << std::endl;
+
+    svk::RigidBodies2D scalar, simd;
+    const Timing scalarTiming = Measure( [&]
+    {
+        scalar = GenerateBodies( numBodies );
+        for ( int step = 0; step < numSteps; ++step )
+            svk::StepRigidBodies2D( scalar, outline, deltaTime, svk::SimdPath::Scalar );
+    }, 0, numRuns );
+    const Timing simdTiming = Measure( [&]
+    {
+        simd = GenerateBodies( numBodies );
+        for ( int step = 0; step < numSteps; ++step )
+            svk::StepRigidBodies2D( simd, outline, deltaTime, svk::SimdPath::Best );
+    }, 0, numRuns );
+
+    PrintTiming( "  scalar", scalarTiming, double( numBodies ) * numSteps, "bodies" );
+    PrintTiming( std::string( "  " ) + svk::BestSimdPathName(), simdTiming, double( numBodies ) * numSteps, "bodies" );
+    std::cout << "  speedup: " << scalarTiming.medianSeconds / simdTiming.medianSeconds << "x" << std::endl;
+
+    const bool isSame = IsSame( scalar.positionX, simd.positionX ) && IsSame( scalar.positionY, simd.positionY )
+        && IsSame( scalar.speedX, simd.speedX ) && IsSame( scalar.speedY, simd.speedY ) && IsSame( scalar.angle, simd.angle );
+    std::cout << "  identical output: " << ( isSame ? "yes" : "NO" ) << std::endl;
+    if ( !isSame )
+        throw std::runtime_error( "particles/rigid2d: SIMD output differs from scalar" );
+}
+
+
+} // namespace
+
+
+void RunParticleBenchmarks( const BenchmarkOptions& options )
+{
+    BenchmarkExplosion( options );
+    BenchmarkRigidBodies( options );
+}
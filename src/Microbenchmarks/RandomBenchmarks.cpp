@@ -0,0 +1,109 @@
+#include "Benchmark.h"
+#include "Parallel.h"
+#include "Random.h"
+
+#include <cstring>
+#include <stdexcept>
+
+
+namespace {
+
+
+// Known-answer vectors of Philox4x32-10 from Random123 (kat_vectors).
+struct PhiloxAnswer
+{
+    uint32_t counter[4];
+    uint32_t key[2];
+    uint32_t result[4];
+};
+
+const PhiloxAnswer PhiloxAnswers[] = {
+    { { 0x00000000, 0x00000000, 0x00000000, 0x00000000 }, { 0x00000000, 0x00000000 },
+      { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 } },
+    { { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }, { 0xffffffff, 0xffffffff },
+      { 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd } },
+    { { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 }, { 0xa4093822, 0x299f31d0 },
+      { 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 } },
+};
+
+
+void CheckKnownAnswers()
+{
+    for ( const PhiloxAnswer& answer : PhiloxAnswers )
+    {
+        uint32_t result[4];
+        svk::Philox4x32( answer.counter, answer.key, result );
+        if ( memcmp( result, answer.result, sizeof(result) ) != 0 )
+            throw std::runtime_error( "Philox4x32 does not match the Random123 known-answer vectors" );
+
+        // RandomUint uses the upper counter words as zero, so only blocks with such counters are reachable through it.
+        if ( answer.counter[2] != 0 || answer.counter[3] != 0 )
+            continue;
+        const uint64_t seed = uint64_t( answer.key[0] ) | uint64_t( answer.key[1] ) << 32;
+        const uint64_t block = uint64_t( answer.counter[0] ) | uint64_t( answer.counter[1] ) << 32;
+        for ( uint32_t word = 0; word < 4; ++word )
+        {
+            if ( svk::RandomUint( seed, 4 * block + word ) != answer.result[word] )
+                throw std::runtime_error( "RandomUint does not match the Random123 known-answer vectors" );
+        }
+    }
+    std::cout << "random/philox: known-answer vectors match" << std::endl;
+}
+
+
+void BenchmarkFill( const BenchmarkOptions& options )
+{
+    const size_t count = size_t( options.GetInt( "values", 10000000 ) );
+    const int numRuns = int( options.GetInt( "runs", 5 ) );
+    const uint64_t seed = 0x0123456789abcdefull;
+
+    std::cout << "random/fill: " << count << " values, " << svk::NumParallelThreads() << " threads" << std::endl;
+
+    // Offsets that are not a multiple of 4 start in the middle of a Philox block.
+    for ( const uint64_t firstIndex : { uint64_t( 0 ), uint64_t( 3 ), uint64_t( 1 ) << 33 | 1 } )
+    {
+        std::vector<uint32_t> scalarUints( count ), batchUints( count );
+        std::vector<float> scalarFloats( count ), batchFloats( count );
+
+        const Timing scalarUintTiming = Measure( [&]
+        {
+            for ( size_t i = 0; i < count; ++i )
+                scalarUints[i] = svk::RandomUint( seed, firstIndex + i );
+        }, 0, numRuns );
+        const Timing batchUintTiming = Measure( [&]
+        {
+            svk::FillRandomUints( seed, firstIndex, batchUints.data(), count );
+        }, 0, numRuns );
+        const Timing scalarFloatTiming = Measure( [&]
+        {
+            for ( size_t i = 0; i < count; ++i )
+                scalarFloats[i] = svk::RandomFloat( seed, firstIndex + i );
+        }, 0, numRuns );
+        const Timing batchFloatTiming = Measure( [&]
+        {
+            svk::FillRandomFloats( seed, firstIndex, batchFloats.data(), count );
+        }, 0, numRuns );
+
+        std::cout << "  first index " << firstIndex << std::endl;
+        PrintTiming( "    RandomUint", scalarUintTiming, double( count ), "values" );
+        PrintTiming( "    FillRandomUints", batchUintTiming, double( count ), "values" );
+        PrintTiming( "    RandomFloat", scalarFloatTiming, double( count ), "values" );
+        PrintTiming( "    FillRandomFloats", batchFloatTiming, double( count ), "values" );
+
+        const bool isSame = scalarUints == batchUints
+            && memcmp( scalarFloats.data(), batchFloats.data(), count * sizeof(float) ) == 0;
+        std::cout << "    identical output: " << ( isSame ? "yes" : "NO" ) << std::endl;
+        if ( !isSame )
+            throw std::runtime_error( "FillRandomUints/FillRandomFloats do not match RandomUint/RandomFloat" );
+    }
+}
+
+
+} // namespace
+
+
+void RunRandomBenchmarks( const BenchmarkOptions& options )
+{
+    CheckKnownAnswers();
+    BenchmarkFill( options );
+}
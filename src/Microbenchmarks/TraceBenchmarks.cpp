@@ -0,0 +1,80 @@
+#include "Benchmark.h"
+#include "Trace.h"
+
+#include <thread>
+
+
+namespace {
+
+
+void BenchmarkClocks( const BenchmarkOptions& options )
+{
+    const int numReads = 1000000;
+    const int numRuns = int( options.GetInt( "runs", 10 ) );
+    const int numWarmup = int( options.GetInt( "warmup", 2 ) );
+
+    std::cout << "trace/clock: " << numReads << " reads per run" << std::endl;
+
+    volatile uint64_t sink = 0;
+    const Timing steadyTiming = Measure( [&]
+    {
+        for ( int i = 0; i < numReads; ++i )
+            sink = sink + svk::detail::TraceNowNs();
+    }, numWarmup, numRuns );
+    const Timing ticksTiming = Measure( [&]
+    {
+        for ( int i = 0; i < numReads; ++i )
+            sink = sink + svk::detail::TraceTicks();
+    }, numWarmup, numRuns );
+
+    PrintLatency( "  steady_clock", steadyTiming, numReads );
+    PrintLatency( "  TraceTicks", ticksTiming, numReads );
+}
+
+
+void BenchmarkScopes( const BenchmarkOptions& options )
+{
+    const int numScopes = int( options.GetInt( "scopes", 100000 ) );
+    const int numRuns = int( options.GetInt( "runs", 10 ) );
+    const int numWarmup = int( options.GetInt( "warmup", 2 ) );
+
+    std::cout << "trace/scope: " << numScopes << " scopes per run" << std::endl;
+
+    svk::StopTracing();
+    const Timing stoppedTiming = Measure( [&]
+    {
+        for ( int i = 0; i < numScopes; ++i )
+            svk::TraceScope scope( "stopped" );
+    }, numWarmup, numRuns );
+
+    // Each run records on a new thread, into new buffers as in a long trace, and stays below the
+    // per-thread event limit. StartTracing refills the spare chunks before each run, untimed.
+    const Timing recordingTiming = MeasureSamples( [&]
+    {
+        svk::StartTracing();
+        double seconds = 0.0;
+        std::thread thread( [&]
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for ( int i = 0; i < numScopes; ++i )
+                svk::TraceScope scope( "recording" );
+            seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+        } );
+        thread.join();
+        return seconds;
+    }, numWarmup, numRuns );
+    svk::StopTracing();
+
+    PrintLatency( "  stopped", stoppedTiming, numScopes );
+    PrintLatency( "  recording", recordingTiming, numScopes );
+}
+
+
+} // namespace
+
+
+void RunTraceBenchmarks( const BenchmarkOptions& options )
+{
+    BenchmarkClocks( options );
+    BenchmarkScopes( options );
+}
@@ -0,0 +1,502 @@
+#include "Benchmark.h"
+#include "Buffer.h"
+#include "CommandPool.h"
+#include "Image.h"
+#include "VulkanBase.h"
+#include "VulkanContext.h"
+
+#include <stb_image.h>
+
+#include <array>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+
+namespace {
+
+
+using Clock = std::chrono::steady_clock;
+
+
+const std::string TexturePath = std::string(ROOT_DIRECTORY) + "/media/texture.jpg";
+const std::string VertShaderPath = std::string(BINARIES_DIRECTORY) + "/Microbenchmarks/pipeline.vert.spv";
+const std::string FragShaderPath = std::string(BINARIES_DIRECTORY) + "/Microbenchmarks/pipeline.frag.spv";
+
+
+double SecondsSince( const Clock::time_point start )
+{
+    return std::chrono::duration<double>( Clock::now() - start ).count();
+}
+
+
+std::string SizeName( const VkDeviceSize size )
+{
+    if ( size >= 1024 * 1024 )
+        return std::to_string( size / ( 1024 * 1024 ) ) + " MB";
+    return std::to_string( size / 1024 ) + " KB";
+}
+
+
+// Headless context for the suite, so that it runs without a display.
+class VulkanSetup
+{
+public:
+    VulkanSetup()
+    {
+        svk::theVulkanContext().Init( PROJECT_NAME, nullptr, {}, {} );
+        commandPool.reset( new svk::CommandPool( svk::theVulkanContext().GraphicsFamily().value() ) );
+
+        VkPhysicalDeviceProperties properties{};
+        vkGetPhysicalDeviceProperties( svk::theVulkanContext().PhysicalDevice(), &properties );
+        std::cout << "vulkan: " << properties.deviceName << std::endl;
+    }
+
+    ~VulkanSetup()
+    {
+        vkDeviceWaitIdle( svk::theVulkanContext().LogicalDevice() );
+        commandPool.reset();
+        svk::theVulkanContext().Destroy();
+    }
+
+    std::unique_ptr<svk::CommandPool> commandPool;
+};
+
+
+void BenchmarkCreateBuffer( const BenchmarkOptions& options )
+{
+    const auto device = svk::theVulkanContext().LogicalDevice();
+    const int numRuns = int( options.GetInt( "runs", 30 ) );
+    const int numWarmup = int( options.GetInt( "warmup", 3 ) );
+    const int buffersPerRun = 16;
+
+    std::cout << "vulkan/createBuffer: buffer and memory creation, destruction not timed" << std::endl;
+
+    const VkMemoryPropertyFlags hostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    for ( const VkDeviceSize size : { VkDeviceSize( 4 * 1024 ), VkDeviceSize( 1024 * 1024 ), VkDeviceSize( 64 * 1024 * 1024 ) } )
+    {
+        for ( const VkMemoryPropertyFlags properties : { VkMemoryPropertyFlags( VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT ), hostVisible } )
+        {
+            std::array<VkBuffer, buffersPerRun> buffers;
+            std::array<VkDeviceMemory, buffersPerRun> memories;
+            const Timing timing = MeasureSamples( [&]
+            {
+                const auto start = Clock::now();
+                for ( int i = 0; i < buffersPerRun; ++i )
+                    svk::createBuffer( size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, properties, buffers[i], memories[i] );
+                const double seconds = SecondsSince( start );
+                for ( int i = 0; i < buffersPerRun; ++i )
+                {
+                    vkDestroyBuffer( device, buffers[i], nullptr );
+                    vkFreeMemory( device, memories[i], nullptr );
+                }
+                return seconds;
+            }, numWarmup, numRuns );
+
+            const std::string memoryName = ( properties == hostVisible ) ? "host-visible" : "device-local";
+            PrintLatency( "  " + SizeName( size ) + " " + memoryName, timing, buffersPerRun );
+        }
+    }
+}
+
+
+// Buffer::Upload, i.e. the staging path of device-local vertex buffers and the mapped path of host-visible ones.
+void BenchmarkUpload( const BenchmarkOptions& options, const svk::CommandPool& commandPool )
+{
+    const int numRuns = int( options.GetInt( "runs", 30 ) );
+    const int numWarmup = int( options.GetInt( "warmup", 3 ) );
+    const VkDeviceSize maxSize = VkDeviceSize( options.GetInt( "max-upload-mb", 256 ) ) * 1024 * 1024;
+
+    std::cout << "vulkan/upload: Buffer::Upload of vertex data, 1 KB to " << SizeName( maxSize ) << std::endl;
+
+    const VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    for ( VkDeviceSize size = 1024; size <= maxSize; size *= 4 )
+    {
+        // Non-zero, so that pages are touched before measuring.
+        const std::vector<uint8_t> data( size, 1 );
+
+        svk::Buffer deviceLocal( size, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+        const Timing stagedTiming = Measure( [&] { deviceLocal.Upload( commandPool, data.data(), size ); }, numWarmup, numRuns );
+        deviceLocal.Clear();
+
+        svk::Buffer hostVisible( size, usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+        const Timing mappedTiming = Measure( [&] { hostVisible.Upload( commandPool, data.data(), size ); }, numWarmup, numRuns );
+        hostVisible.Clear();
+
+        PrintTiming( "  " + SizeName( size ) + " staged", stagedTiming, double( size ), "B" );
+        PrintTiming( "  " + SizeName( size ) + " mapped", mappedTiming, double( size ), "B" );
+    }
+}
+
+
+// Image::CreateFromFile split into its decode and upload parts.
+void BenchmarkImage( const BenchmarkOptions& options, const svk::CommandPool& commandPool )
+{
+    const auto device = svk::theVulkanContext().LogicalDevice();
+    const int numRuns = int( options.GetInt( "runs", 30 ) );
+    const int numWarmup = int( options.GetInt( "warmup", 3 ) );
+
+    int width = 0, height = 0, channels = 0;
+    stbi_uc* pixels = stbi_load( TexturePath.c_str(), &width, &height, &channels, STBI_rgb_alpha );
+    if ( pixels == nullptr )
+        throw std::runtime_error( "Failed to load " + TexturePath );
+    const VkDeviceSize imageSize = VkDeviceSize( width ) * height * 4;
+    std::cout << "vulkan/image: " << TexturePath << ", " << width << "x" << height << std::endl;
+
+    const Timing decodeTiming = Measure( [&]
+    {
+        int w, h, c;
+        stbi_image_free( stbi_load( TexturePath.c_str(), &w, &h, &c, STBI_rgb_alpha ) );
+    }, numWarmup, numRuns );
+
+    // Same steps as CreateFromFile after stbi_load.
+    const Timing uploadTiming = Measure( [&]
+    {
+        VkBuffer stagingBuffer;
+        VkDeviceMemory stagingBufferMemory;
+        svk::createBuffer( imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory );
+        void* data;
+        vkMapMemory( device, stagingBufferMemory, 0, imageSize, 0, &data );
+        memcpy( data, pixels, size_t( imageSize ) );
+        vkUnmapMemory( device, stagingBufferMemory );
+
+        svk::Image image( uint32_t( width ), uint32_t( height ), VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_LAYOUT_UNDEFINED );
+        image.TransitionLayout( commandPool, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL );
+        svk::copyBufferToImage( commandPool, stagingBuffer, image.Handle(), uint32_t( width ), uint32_t( height ) );
+        image.TransitionLayout( commandPool, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL );
+
+        vkDestroyBuffer( device, stagingBuffer, nullptr );
+        vkFreeMemory( device, stagingBufferMemory, nullptr );
+    }, numWarmup, numRuns );
+
+    const Timing totalTiming = Measure( [&] { svk::Image::CreateFromFile( commandPool, TexturePath ); }, numWarmup, numRuns );
+
+    stbi_image_free( pixels );
+
+    const double numPixels = double( width ) * height;
+    PrintTiming( "  decode", decodeTiming, numPixels, "pixels" );
+    PrintTiming( "  upload", uploadTiming, numPixels, "pixels" );
+    PrintTiming( "  CreateFromFile", totalTiming, numPixels, "pixels" );
+}
+
+
+void BenchmarkCommandBuffers( const BenchmarkOptions& options, const svk::CommandPool& commandPool )
+{
+    const int numRuns = int( options.GetInt( "runs", 30 ) );
+    const int numWarmup = int( options.GetInt( "warmup", 3 ) );
+    const int buffersPerRun = 64;
+
+    std::cout << "vulkan/commandBuffer: CommandPool::CreateCommandBuffer, FreeCommandBuffer not timed" << std::endl;
+
+    std::vector<VkCommandBuffer> commandBuffers( buffersPerRun );
+    const Timing timing = MeasureSamples( [&]
+    {
+        const auto start = Clock::now();
+        for ( auto& commandBuffer : commandBuffers )
+            commandBuffer = commandPool.CreateCommandBuffer();
+        const double seconds = SecondsSince( start );
+        for ( auto& commandBuffer : commandBuffers )
+            commandPool.FreeCommandBuffer( commandBuffer );
+        return seconds;
+    }, numWarmup, numRuns );
+    PrintLatency( "  create", timing, buffersPerRun );
+}
+
+
+// Uniform buffer and combined image sampler, as in the apps.
+VkDescriptorSetLayout CreateDescriptorSetLayout()
+{
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = uint32_t( bindings.size() );
+    layoutInfo.pBindings = bindings.data();
+
+    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    if ( vkCreateDescriptorSetLayout( svk::theVulkanContext().LogicalDevice(), &layoutInfo, nullptr, &layout ) != VK_SUCCESS )
+        throw std::runtime_error( "Failed to create descriptor set layout." );
+    return layout;
+}
+
+
+void BenchmarkDescriptorUpdates( const BenchmarkOptions& options, const svk::CommandPool& commandPool )
+{
+    const auto device = svk::theVulkanContext().LogicalDevice();
+    const int numRuns = int( options.GetInt( "runs", 30 ) );
+    const int numWarmup = int( options.GetInt( "warmup", 3 ) );
+    const uint32_t numSets = 256;
+
+    std::cout << "vulkan/descriptors: vkUpdateDescriptorSets of " << numSets << " sets with a uniform buffer and a sampler" << std::endl;
+
+    const VkDescriptorSetLayout layout = CreateDescriptorSetLayout();
+
+    std::array<VkDescriptorPoolSize, 2> poolSizes{};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    poolSizes[0].descriptorCount = numSets;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[1].descriptorCount = numSets;
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = uint32_t( poolSizes.size() );
+    poolInfo.pPoolSizes = poolSizes.data();
+    poolInfo.maxSets = numSets;
+
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    if ( vkCreateDescriptorPool( device, &poolInfo, nullptr, &pool ) != VK_SUCCESS )
+        throw std::runtime_error( "Failed to create descriptor pool." );
+
+    const std::vector<VkDescriptorSetLayout> layouts( numSets, layout );
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = pool;
+    allocInfo.descriptorSetCount = numSets;
+    allocInfo.pSetLayouts = layouts.data();
+    std::vector<VkDescriptorSet> sets( numSets );
+    if ( vkAllocateDescriptorSets( device, &allocInfo, sets.data() ) != VK_SUCCESS )
+        throw std::runtime_error( "Failed to allocate descriptor sets." );
+
+    svk::Buffer uniforms( 256, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+    svk::Image image( 64, 64, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_LAYOUT_UNDEFINED );
+    image.TransitionLayout( commandPool, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL );
+
+    std::vector<VkWriteDescriptorSet> writes( 2 * numSets );
+    for ( uint32_t i = 0; i < numSets; ++i )
+    {
+        auto& bufferWrite = writes[2*i];
+        bufferWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        bufferWrite.dstSet = sets[i];
+        bufferWrite.dstBinding = 0;
+        bufferWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        bufferWrite.descriptorCount = 1;
+        bufferWrite.pBufferInfo = &uniforms.Info();
+
+        auto& imageWrite = writes[2*i + 1];
+        imageWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        imageWrite.dstSet = sets[i];
+        imageWrite.dstBinding = 1;
+        imageWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        imageWrite.descriptorCount = 1;
+        imageWrite.pImageInfo = &image.Info();
+    }
+
+    // One call per set, as SwapChain does, and all sets in one call.
+    const Timing perSetTiming = Measure( [&]
+    {
+        for ( uint32_t i = 0; i < numSets; ++i )
+            vkUpdateDescriptorSets( device, 2, &writes[2*i], 0, nullptr );
+    }, numWarmup, numRuns );
+    const Timing batchedTiming = Measure( [&]
+    {
+        vkUpdateDescriptorSets( device, uint32_t( writes.size() ), writes.data(), 0, nullptr );
+    }, numWarmup, numRuns );
+
+    PrintLatency( "  per set", perSetTiming, numSets );
+    PrintLatency( "  batched", batchedTiming, numSets );
+
+    vkDestroyDescriptorPool( device, pool, nullptr );
+    vkDestroyDescriptorSetLayout( device, layout, nullptr );
+}
+
+
+// Render pass of one color and one depth attachment, as in SwapChain.
+VkRenderPass CreateRenderPass()
+{
+    std::array<VkAttachmentDescription, 2> attachments{};
+    attachments[0].format = VK_FORMAT_B8G8R8A8_SRGB;
+    attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+    attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachments[0].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    attachments[1].format = VK_FORMAT_D32_SFLOAT;
+    attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
+    attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference colorAttachmentRef{ 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+    VkAttachmentReference depthAttachmentRef{ 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorAttachmentRef;
+    subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+    VkRenderPassCreateInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = uint32_t( attachments.size() );
+    renderPassInfo.pAttachments = attachments.data();
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    if ( vkCreateRenderPass( svk::theVulkanContext().LogicalDevice(), &renderPassInfo, nullptr, &renderPass ) != VK_SUCCESS )
+        throw std::runtime_error( "Failed to create render pass." );
+    return renderPass;
+}
+
+
+void BenchmarkPipelineCreation( const BenchmarkOptions& options )
+{
+    const auto device = svk::theVulkanContext().LogicalDevice();
+    const int numRuns = int( options.GetInt( "runs", 30 ) );
+    const int numWarmup = int( options.GetInt( "warmup", 3 ) );
+
+    std::cout << "vulkan/pipeline: vkCreateGraphicsPipelines of a textured, lit mesh pipeline" << std::endl;
+
+    const VkShaderModule vertShaderModule = svk::CreateShaderModule( device, svk::LoadShaderCode( VertShaderPath ) );
+    const VkShaderModule fragShaderModule = svk::CreateShaderModule( device, svk::LoadShaderCode( FragShaderPath ) );
+    const VkDescriptorSetLayout descriptorSetLayout = CreateDescriptorSetLayout();
+    const VkRenderPass renderPass = CreateRenderPass();
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    if ( vkCreatePipelineLayout( device, &pipelineLayoutInfo, nullptr, &pipelineLayout ) != VK_SUCCESS )
+        throw std::runtime_error( "Failed to create pipeline layout." );
+
+    std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages{};
+    shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    shaderStages[0].module = vertShaderModule;
+    shaderStages[0].pName = "main";
+    shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    shaderStages[1].module = fragShaderModule;
+    shaderStages[1].pName = "main";
+
+    // Position, normal and texture coordinates.
+    VkVertexInputBindingDescription binding{ 0, 8 * sizeof(float), VK_VERTEX_INPUT_RATE_VERTEX };
+    std::array<VkVertexInputAttributeDescription, 3> attributes = { {
+        { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0 },
+        { 1, 0, VK_FORMAT_R32G32B32_SFLOAT, 3 * sizeof(float) },
+        { 2, 0, VK_FORMAT_R32G32_SFLOAT, 6 * sizeof(float) },
+    } };
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInputInfo.vertexBindingDescriptionCount = 1;
+    vertexInputInfo.pVertexBindingDescriptions = &binding;
+    vertexInputInfo.vertexAttributeDescriptionCount = uint32_t( attributes.size() );
+    vertexInputInfo.pVertexAttributeDescriptions = attributes.data();
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkViewport viewport{ 0.0f, 0.0f, 1280.0f, 720.0f, 0.0f, 1.0f };
+    VkRect2D scissor{ { 0, 0 }, { 1280, 720 } };
+    VkPipelineViewportStateCreateInfo viewportState{};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.pViewports = &viewport;
+    viewportState.scissorCount = 1;
+    viewportState.pScissors = &scissor;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer{};
+    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+    rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+    VkPipelineMultisampleStateCreateInfo multisampling{};
+    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineDepthStencilStateCreateInfo depthStencil{};
+    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable = VK_TRUE;
+    depthStencil.depthWriteEnable = VK_TRUE;
+    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+
+    VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    VkPipelineColorBlendStateCreateInfo colorBlending{};
+    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending.attachmentCount = 1;
+    colorBlending.pAttachments = &colorBlendAttachment;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = uint32_t( shaderStages.size() );
+    pipelineInfo.pStages = shaderStages.data();
+    pipelineInfo.pVertexInputState = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState = &multisampling;
+    pipelineInfo.pDepthStencilState = &depthStencil;
+    pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.layout = pipelineLayout;
+    pipelineInfo.renderPass = renderPass;
+    pipelineInfo.subpass = 0;
+
+    // Destruction is not timed.
+    const auto measureCreation = [&]( const VkPipelineCache cache )
+    {
+        return MeasureSamples( [&]
+        {
+            VkPipeline pipeline = VK_NULL_HANDLE;
+            const auto start = Clock::now();
+            if ( vkCreateGraphicsPipelines( device, cache, 1, &pipelineInfo, nullptr, &pipeline ) != VK_SUCCESS )
+                throw std::runtime_error( "Failed to create graphics pipeline." );
+            const double seconds = SecondsSince( start );
+            vkDestroyPipeline( device, pipeline, nullptr );
+            return seconds;
+        }, numWarmup, numRuns );
+    };
+
+    const Timing uncachedTiming = measureCreation( VK_NULL_HANDLE );
+
+    // The warm-up runs fill the cache, so that the measured ones hit it.
+    VkPipelineCacheCreateInfo cacheInfo{};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    VkPipelineCache cache = VK_NULL_HANDLE;
+    if ( vkCreatePipelineCache( device, &cacheInfo, nullptr, &cache ) != VK_SUCCESS )
+        throw std::runtime_error( "Failed to create pipeline cache." );
+    const Timing cachedTiming = measureCreation( cache );
+
+    PrintLatency( "  no cache", uncachedTiming, 1 );
+    PrintLatency( "  warm cache", cachedTiming, 1 );
+    std::cout << "  speedup: " << uncachedTiming.medianSeconds / cachedTiming.medianSeconds << "x" << std::endl;
+
+    vkDestroyPipelineCache( device, cache, nullptr );
+    vkDestroyPipelineLayout( device, pipelineLayout, nullptr );
+    vkDestroyRenderPass( device, renderPass, nullptr );
+    vkDestroyDescriptorSetLayout( device, descriptorSetLayout, nullptr );
+    vkDestroyShaderModule( device, vertShaderModule, nullptr );
+    vkDestroyShaderModule( device, fragShaderModule, nullptr );
+}
+
+
+} // namespace
+
+
+void RunVulkanBenchmarks( const BenchmarkOptions& options )
+{
+    const VulkanSetup setup;
+    BenchmarkCreateBuffer( options );
+    BenchmarkUpload( options, *setup.commandPool );
+    BenchmarkImage( options, *setup.commandPool );
+    BenchmarkCommandBuffers( options, *setup.commandPool );
+    BenchmarkDescriptorUpdates( options, *setup.commandPool );
+    BenchmarkPipelineCreation( options );
+}
@@ -0,0 +1,76 @@
+#include "Benchmark.h"
+
+#include <functional>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+
+
+// Microbenchmarks for the building blocks in Utilities.
+//
+// Usage: Microbenchmarks [--suite=<name>] [suite-specific options]
+// Without --suite, all suites are run.
+//
+// Suites:
+//   mesh    Vertex deduplication and index buffer optimization on viking_room.obj and on synthetic meshes.
+//           --triangles=N   Triangle count of the synthetic deduplication mesh (default 10M).
+//           --optimize-triangles=N   Triangle count of the synthetic optimization mesh (default 1M).
+//           --runs=N        Measured repetitions (default 5).
+//           --skip-legacy   Do not run the std::unordered_map reference.
+//   particles   Scalar and SIMD integrators of ParticleIntegrator. Fails unless their output is identical.
+//           --particles=N   Explosion particle count (default 1M).
+//           --bodies=N      Rigid body count (default 1M).
+//           --runs=N        Measured repetitions (default 5).
+//   random  Philox4x32 against the Random123 known-answer vectors, and FillRandomUints/FillRandomFloats
+//           against RandomUint/RandomFloat at several first indices. Fails on any mismatch.
+//           --values=N      Values per fill (default 10M).
+//           --runs=N        Measured repetitions (default 5).
+//   trace   Cost of SVK_TRACE_SCOPE: timestamp reads, and scopes with tracing stopped and recording.
+//           Each recording run uses a new thread, timed from its first scope to its last.
+//           --scopes=N      Scopes per run (default 100k).
+//           --runs=N        Measured repetitions (default 10).
+//           --warmup=N      Unmeasured repetitions first (default 2).
+//   vulkan  Utilities Vulkan primitives on a headless context: createBuffer latency, Buffer::Upload throughput
+//           from 1 KB up, Image::CreateFromFile decode and upload, CommandPool::CreateCommandBuffer,
+//           descriptor set updates and pipeline creation with and without a pipeline cache.
+//           Mean +- is the 95% confidence interval of the mean. Use a Release build, without validation layers.
+//           --runs=N        Measured repetitions (default 30).
+//           --warmup=N      Unmeasured repetitions first (default 3).
+//           --max-upload-mb=N   Largest upload (default 256).
+
+
+int main( int argc, char** argv )
+{
+    const BenchmarkOptions options( argc, argv );
+
+    const std::map<std::string, std::function<void( const BenchmarkOptions& )>> suites = {
+        { "mesh", RunMeshBenchmarks },
+        { "particles", RunParticleBenchmarks },
+        { "random", RunRandomBenchmarks },
+        { "trace", RunTraceBenchmarks },
+        { "vulkan", RunVulkanBenchmarks },
+    };
+
+    try
+    {
+        const std::string suite = options.GetString( "suite", "" );
+        if ( suite.empty() )
+        {
+            for ( const auto& entry : suites )
+                entry.second( options );
+        }
+        else
+        {
+            const auto it = suites.find( suite );
+            if ( it == suites.end() )
+                throw std::runtime_error( "Unknown benchmark suite: " + suite );
+            it->second( options );
+        }
+    }
+    catch ( const std::exception& e )
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
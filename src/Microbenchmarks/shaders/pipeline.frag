@@ -0,0 +1,16 @@
+#version 450
+
+layout ( binding = 1 ) uniform sampler2D texSampler;
+
+layout ( location = 0 ) in vec3 fragNormal;
+layout ( location = 1 ) in vec2 fragTexCoord;
+
+layout ( location = 0 ) out vec4 outColor;
+
+void main()
+{
+    const vec3 lightDirection = normalize( vec3( 1.0, 2.0, 3.0 ) );
+    const float diffuse = max( dot( normalize( fragNormal ), lightDirection ), 0.0 );
+    const vec3 albedo = texture( texSampler, fragTexCoord ).rgb;
+    outColor = vec4( albedo * ( 0.1 + 0.9 * diffuse ), 1.0 );
+}
@@ -0,0 +1,22 @@
+#version 450
+
+layout ( binding = 0 ) uniform UniformBufferObject
+{
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+layout ( location = 0 ) in vec3 inPosition;
+layout ( location = 1 ) in vec3 inNormal;
+layout ( location = 2 ) in vec2 inTexCoord;
+
+layout ( location = 0 ) out vec3 fragNormal;
+layout ( location = 1 ) out vec2 fragTexCoord;
+
+void main()
+{
+    gl_Position = ubo.proj * ubo.view * ubo.model * vec4( inPosition, 1.0 );
+    fragNormal = mat3( ubo.model ) * inNormal;
+    fragTexCoord = inTexCoord;
+}
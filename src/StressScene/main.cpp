@@ -0,0 +1,286 @@
+#include "ApplicationBase.h"
+#include "Image.h"
+#include "MeshIndexing.h"
+#include "MeshOptimizer.h"
+#include "SceneGenerator.h"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <iostream>
+#include <cstring>
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+
+// Synthetic scenes that scale far beyond the course media, for benchmarking:
+// thousands of viking rooms or spheres of any triangle count, grids of textured quads,
+// and particle clouds of millions of quads. See svk::SceneOptions for the command line.
+// Instances are grouped by texture, and each texture is one draw item with its own material
+// descriptor set, so that the texture count also scales the number of draws and binds.
+
+
+const std::string MODEL_PATH = std::string(ROOT_DIRECTORY) + "/media/viking_room.obj";
+
+
+class AppExample : public svk::ApplicationBase
+{
+public:
+
+    explicit AppExample( const svk::SceneOptions& options ) :
+        options( options )
+    {}
+
+    virtual VkVertexInputBindingDescription getVertexBindingDescription() const override
+    {
+        return { 0, sizeof(svk::SceneVertex), VK_VERTEX_INPUT_RATE_VERTEX };
+    }
+
+    virtual std::vector<VkVertexInputBindingDescription> getVertexBindingDescriptions() const override
+    {
+        return {
+            { 0, sizeof(svk::SceneVertex), VK_VERTEX_INPUT_RATE_VERTEX },
+            { 1, sizeof(svk::SceneInstance), VK_VERTEX_INPUT_RATE_INSTANCE },
+        };
+    }
+
+    virtual std::vector<VkVertexInputAttributeDescription> getVertexAttributeDescriptions() const override
+    {
+        return {
+            { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(svk::SceneVertex, pos) },
+            { 1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(svk::SceneVertex, normal) },
+            { 2, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(svk::SceneVertex, texCoord) },
+            { 3, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(svk::SceneInstance, offset) },
+            { 4, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(svk::SceneInstance, rotation) },
+            { 5, 1, VK_FORMAT_R8G8B8A8_UNORM, offsetof(svk::SceneInstance, color) },
+        };
+    }
+
+    virtual std::vector<VkDescriptorSetLayoutBinding> getDescriptorBindings() const override
+    {
+        VkDescriptorSetLayoutBinding samplerLayoutBinding{};
+        samplerLayoutBinding.binding = 0;
+        samplerLayoutBinding.descriptorCount = 1;
+        samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        samplerLayoutBinding.pImmutableSamplers = nullptr;
+        samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        return { samplerLayoutBinding };
+    }
+
+    virtual std::vector<VkWriteDescriptorSet> getDescriptorWrites( const VkDescriptorSet& descriptorSet, const int swapEntryIndex ) const override
+    {
+        std::vector<VkWriteDescriptorSet> descriptorWrites(1);
+
+        descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[0].dstSet = descriptorSet;
+        descriptorWrites[0].dstBinding = 0;
+        descriptorWrites[0].dstArrayElement = 0;
+        descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrites[0].descriptorCount = 1;
+        descriptorWrites[0].pImageInfo = &textures[0]->Info();
+
+        return descriptorWrites;
+    }
+
+    virtual void InitRenderEntries( const svk::SwapChainInfo& swapChainInfo ) override
+    {
+        aspectRatio = swapChainInfo.extent.width / (float) swapChainInfo.extent.height;
+    }
+
+    // Materials are textures, and textures do not change, so their sets are shared by all swap chain entries.
+    virtual void BindMaterial( const VkCommandBuffer commandBuffer, const VkPipelineLayout pipelineLayout, const uint32_t material, const int swapEntryIndex ) override
+    {
+        vkCmdBindDescriptorSets( commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &materialSets[material], 0, nullptr );
+    }
+
+    virtual void InitSwapChain() override
+    {
+        swapchain->Init(
+            commandPool,
+            this,
+            mesh.vertices,
+            mesh.indices,
+            std::string(PROJECT_NAME) + "/shader.vert.spv",
+            std::string(PROJECT_NAME) + "/shader.frag.spv"
+        );
+        swapchain->SetInstanceData( 1, scene.instances );
+        createMaterialSets();
+    }
+
+    virtual void InitAppResources() override
+    {
+        switch ( options.kind )
+        {
+        case svk::SceneKind::Models: loadModel(); break;
+        case svk::SceneKind::Spheres: mesh = svk::MakeSphere( options.numTriangles ); break;
+        case svk::SceneKind::Quads:
+        case svk::SceneKind::Particles: mesh = svk::MakeQuad(); break;
+        }
+        scene = svk::MakeSceneInstances( options );
+
+        textures.resize( options.numTextures );
+        for ( uint32_t i = 0; i < options.numTextures; ++i )
+        {
+            const auto pixels = svk::MakeSceneTexture( options.textureSize, i, options.seed );
+            textures[i] = svk::Image::CreateFromPixels( *commandPool, options.textureSize, options.textureSize, pixels.data() );
+        }
+
+        std::cout << "Scene: " << options.Describe() << ", " << mesh.NumTriangles() << " triangles per object, "
+            << mesh.NumTriangles() * scene.instances.size() << " in total" << std::endl;
+    }
+
+    virtual void DestroyAppResources() override
+    {
+        const auto device = svk::theVulkanContext().LogicalDevice();
+        vkDestroyDescriptorPool( device, materialPool, nullptr );
+        materialPool = VK_NULL_HANDLE;
+        materialSets.clear();
+        textures.clear();
+    }
+
+    virtual void UpdateFrameData() override
+    {
+        SVK_TRACE_SCOPE( "AppExample::UpdateFrameData" );
+
+        // The camera orbits the scene, except for the quad grid, which faces it.
+        const float angle = options.kind == svk::SceneKind::Quads ? 0.0f : 0.2f * float( FrameTime() );
+        const glm::vec3 eye = glm::vec3( 3.2f * std::sin( angle ), 0.0f, 3.2f * std::cos( angle ) );
+        const glm::mat4 view = glm::lookAt( eye, glm::vec3( 0.0f ), glm::vec3( 0.0f, 1.0f, 0.0f ) );
+        glm::mat4 proj = glm::perspective( glm::radians( 45.0f ), aspectRatio, 0.1f, 10.0f );
+        proj[1][1] *= -1;
+        const glm::mat4 viewProj = proj * view;
+
+        std::vector<svk::DrawItem> drawItems;
+        drawItems.reserve( options.numTextures );
+        for ( uint32_t i = 0; i < options.numTextures; ++i )
+        {
+            svk::DrawItem item;
+            item.material = i;
+            item.firstInstance = scene.firstInstance[i];
+            item.numInstances = scene.firstInstance[i + 1] - scene.firstInstance[i];
+            memcpy( item.transform, &viewProj, sizeof(item.transform) );
+            if ( item.numInstances > 0 )
+                drawItems.push_back( item );
+        }
+        swapchain->SetDrawList( drawItems );
+    }
+
+
+    void createMaterialSets()
+    {
+        const auto device = svk::theVulkanContext().LogicalDevice();
+        const uint32_t numMaterials = uint32_t( textures.size() );
+
+        VkDescriptorPoolSize poolSize{};
+        poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        poolSize.descriptorCount = numMaterials;
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes = &poolSize;
+        poolInfo.maxSets = numMaterials;
+
+        if ( vkCreateDescriptorPool( device, &poolInfo, nullptr, &materialPool ) != VK_SUCCESS )
+            throw std::runtime_error( "failed to create material descriptor pool!" );
+
+        const std::vector<VkDescriptorSetLayout> layouts( numMaterials, swapchain->DescriptorSetLayout() );
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = materialPool;
+        allocInfo.descriptorSetCount = numMaterials;
+        allocInfo.pSetLayouts = layouts.data();
+
+        materialSets.resize( numMaterials );
+        if ( vkAllocateDescriptorSets( device, &allocInfo, materialSets.data() ) != VK_SUCCESS )
+            throw std::runtime_error( "failed to allocate material descriptor sets!" );
+
+        std::vector<VkWriteDescriptorSet> descriptorWrites( numMaterials );
+        for ( uint32_t i = 0; i < numMaterials; ++i )
+        {
+            descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptorWrites[i].dstSet = materialSets[i];
+            descriptorWrites[i].dstBinding = 0;
+            descriptorWrites[i].dstArrayElement = 0;
+            descriptorWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            descriptorWrites[i].descriptorCount = 1;
+            descriptorWrites[i].pImageInfo = &textures[i]->Info();
+        }
+        vkUpdateDescriptorSets( device, numMaterials, descriptorWrites.data(), 0, nullptr );
+    }
+
+    void loadModel()
+    {
+        SVK_TRACE_SCOPE( "AppExample::loadModel" );
+
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+        std::string warn, err;
+
+        if ( !tinyobj::LoadObj( &attrib, &shapes, &materials, &warn, &err, MODEL_PATH.c_str() ) )
+            throw std::runtime_error( warn + err );
+
+        std::vector<svk::SceneVertex> corners;
+        for ( const auto& shape : shapes )
+        {
+            for ( const auto& index : shape.mesh.indices )
+            {
+                svk::SceneVertex vertex{};
+                for ( int i = 0; i < 3; ++i )
+                {
+                    vertex.pos[i] = attrib.vertices[3 * index.vertex_index + i];
+                    vertex.normal[i] = index.normal_index >= 0 ? attrib.normals[3 * index.normal_index + i] : 0.0f;
+                }
+                vertex.texCoord[0] = attrib.texcoords[2 * index.texcoord_index + 0];
+                vertex.texCoord[1] = 1.0f - attrib.texcoords[2 * index.texcoord_index + 1];
+                corners.push_back( vertex );
+            }
+        }
+
+        svk::BuildIndexedMesh( corners, mesh.vertices, mesh.indices );
+        svk::OptimizeMesh( mesh.vertices, mesh.indices, offsetof(svk::SceneVertex, pos) );
+        svk::NormalizeMesh( mesh );
+    }
+
+
+    svk::SceneOptions options;
+    svk::SceneMesh mesh;
+    svk::SceneInstances scene;
+    std::vector<std::shared_ptr<svk::Image>> textures;
+
+    VkDescriptorPool materialPool = VK_NULL_HANDLE;
+    std::vector<VkDescriptorSet> materialSets; // Per texture.
+
+    float aspectRatio = 1.0f;
+};
+
+
+int main( int argc, char** argv )
+{
+    try
+    {
+        const auto options = svk::SceneOptions::FromCommandLine( argc, argv );
+        AppExample app( options );
+        app.ParseCommandLine( argc, argv );
+        app.Init(
+            1280, // width
+            720, // height
+            std::string(PROJECT_NAME) + " " + options.Describe(), // App name, also names the benchmark results.
+            { "VK_LAYER_KHRONOS_validation" },
+            { VK_KHR_SWAPCHAIN_EXTENSION_NAME }
+        );
+        app.MainLoop();
+        app.Destroy();
+    }
+    catch ( const std::exception& e )
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
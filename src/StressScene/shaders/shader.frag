@@ -0,0 +1,18 @@
+#version 450
+
+layout ( binding = 0 ) uniform sampler2D texSampler;
+
+layout ( location = 0 ) in vec2 fragTexCoord;
+layout ( location = 1 ) in vec3 fragNormal;
+layout ( location = 2 ) in vec3 fragColor;
+
+layout ( location = 0 ) out vec4 outColor;
+
+
+void main()
+{
+    // Two-sided, so that quads seen from behind are lit too.
+    const vec3 lightDirection = normalize( vec3( 0.4, 0.8, 0.6 ) );
+    float diffuse = abs( dot( normalize( fragNormal ), lightDirection ) );
+    outColor = vec4( texture( texSampler, fragTexCoord ).rgb * fragColor * ( 0.3 + 0.7 * diffuse ), 1.0 );
+}
@@ -0,0 +1,35 @@
+#version 450
+
+layout ( location = 0 ) in vec3 inPosition;
+layout ( location = 1 ) in vec3 inNormal;
+layout ( location = 2 ) in vec2 inTexCoord;
+layout ( location = 3 ) in vec4 inOffsetScale;
+layout ( location = 4 ) in vec4 inRotation;
+layout ( location = 5 ) in vec4 inColor;
+
+layout ( location = 0 ) out vec2 fragTexCoord;
+layout ( location = 1 ) out vec3 fragNormal;
+layout ( location = 2 ) out vec3 fragColor;
+
+// View projection, the same for all draw items.
+layout ( push_constant ) uniform PushConstants
+{
+    mat4 transform;
+} pc;
+
+
+// Rotation by a unit quaternion.
+vec3 rotate( vec4 q, vec3 v )
+{
+    return v + 2.0 * cross( q.xyz, cross( q.xyz, v ) + q.w * v );
+}
+
+
+void main()
+{
+    vec3 pos = rotate( inRotation, inPosition ) * inOffsetScale.w + inOffsetScale.xyz;
+    gl_Position = pc.transform * vec4( pos, 1.0 );
+    fragTexCoord = inTexCoord;
+    fragNormal = rotate( inRotation, inNormal );
+    fragColor = inColor.rgb;
+}
@@ -54,11 +54,12 @@ public:
 };
 
 
-int main()
+int main( int argc, char** argv )
 {
     AppExample app;
     try
     {
+        app.ParseCommandLine( argc, argv );
         app.Init(
             800, // width
             600, // height
@@ -1,9 +1,10 @@
 #include "ApplicationBase.h"
+#include "FixedStepSimulation.h"
+#include "ParticleIntegrator.h"
+#include "Random.h"
 
 #include <glm/glm.hpp>
 #include <iostream>
-#include <chrono>
-#include <random>
 
 
 // Task 1b: Triangle bouncing from edges.
@@ -25,17 +26,29 @@ struct Vertex {
 };
 
 
-const std::vector<Vertex> vertices_local = {
+const std::vector<Vertex> vertices = {
     { {  0.0f, -0.2f }, { 1.0f, 0.0f, 0.0f} },
     { {  0.2f,  0.2f }, { 0.0f, 1.0f, 0.0f} },
     { { -0.2f,  0.2f }, { 0.0f, 0.0f, 1.0f} },
 };
 
-std::vector<Vertex> vertices = vertices_local;
-
 const std::vector<uint32_t> indices = { 0, 2, 1 };
 
-const float _2Pi = float( 2.0 * M_PI );
+// Per-instance placement of the triangle.
+struct TriangleInstance {
+    glm::vec2 position;
+    float rotation;
+};
+
+// All triangles are drawn with a single instanced draw call.
+const uint32_t NumTriangles = 1;
+
+// Physics runs at a fixed rate, on its own thread or inside UpdateFrameData.
+const float SimulationStep = 1.0f / 120.0f;
+const bool UseSimulationThread = true;
+
+const float _Pi = float( M_PI );
+
 
 
 class AppExample : public svk::ApplicationBase
@@ -47,11 +60,21 @@ public:
         return { 0, sizeof(Vertex), VK_VERTEX_INPUT_RATE_VERTEX };
     }
 
+    virtual std::vector<VkVertexInputBindingDescription> getVertexBindingDescriptions() const override
+    {
+        return {
+            { 0, sizeof(Vertex), VK_VERTEX_INPUT_RATE_VERTEX },
+            { 1, sizeof(TriangleInstance), VK_VERTEX_INPUT_RATE_INSTANCE },
+        };
+    }
+
     virtual std::vector<VkVertexInputAttributeDescription> getVertexAttributeDescriptions() const override
     {
         return {
             { 0, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, pos) },
             { 1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, color) },
+            { 2, 1, VK_FORMAT_R32G32_SFLOAT, offsetof(TriangleInstance, position) },
+            { 3, 1, VK_FORMAT_R32_SFLOAT, offsetof(TriangleInstance, rotation) },
         };
     }
 
@@ -65,73 +88,94 @@ public:
             std::string(PROJECT_NAME) + "/shader.vert.spv",
             std::string(PROJECT_NAME) + "/shader.frag.spv"
         );
+
+        svk::DrawItem drawItem;
+        drawItem.numInstances = NumTriangles;
+        swapchain->SetDrawList( { drawItem } );
     }
 
     virtual void InitAppResources() override
     {
-        std::random_device rd;  // Will be used to obtain a seed for the random number engine
-        std::mt19937 gen( rd() ); // Standard mersenne_twister_engine seeded with rd()
-        std::uniform_real_distribution<> dis( -1.0, 1.0 );
+        // Three values from [0,1) per triangle.
+        std::vector<float> values( 3 * NumTriangles );
+        svk::FillRandomFloats( svk::RandomSeed(), 0, values.data(), values.size() );
 
-        rotPos = dis(gen) * M_PI;
-        rotSpeed = 1.0f;
+        svk::RigidBodies2D bodies;
+        bodies.Resize( NumTriangles );
+        for ( uint32_t i = 0; i < NumTriangles; ++i )
+        {
+            bodies.angle[i] = ( -1.0f + 2.0f*values[3*i] ) * M_PI;
+            bodies.angularSpeed[i] = 1.0f;
 
-        linSpeed.x = dis(gen) * 0.2f;
-        linSpeed.y = dis(gen) * 0.2f;
-    }
+            bodies.speedX[i] = ( -1.0f + 2.0f*values[3*i+1] ) * 0.2f;
+            bodies.speedY[i] = ( -1.0f + 2.0f*values[3*i+2] ) * 0.2f;
+        }
+        instances.resize( NumTriangles );
 
-    virtual void UpdateFrameData() override
-    {
-        static const auto startTime = std::chrono::high_resolution_clock::now();
-        static auto prevTime = startTime;
-        const auto currentTime = std::chrono::high_resolution_clock::now();
-        const float deltaTime = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - prevTime).count();
-        prevTime = currentTime;
-
-        rotPos += deltaTime * rotSpeed;
-        rotPos -= int( rotPos / _2Pi ) * _2Pi;
-        const float cosX = cosf( rotPos );
-        const float sinX = sinf( rotPos );
-
-        for ( int i = 0; i < 3; ++i )
+        outline.clear();
+        for ( const auto& vertex : vertices )
         {
-            glm::vec2& pos = vertices[i].pos;
-            const glm::vec2& pos_loc = vertices_local[i].pos;
+            outline.push_back( vertex.pos.x );
+            outline.push_back( vertex.pos.y );
+        }
+
+        // Rotates, moves and bounces all triangles from the edges.
+        simulation.Start( bodies, SimulationStep, [this]( svk::RigidBodies2D& state, const float deltaTime )
+        {
+            const float prevSpeedX = state.speedX[0];
+            const float prevSpeedY = state.speedY[0];
+
+            svk::StepRigidBodies2D( state, outline, deltaTime );
+
+            if ( NumTriangles == 1 && ( state.speedX[0] != prevSpeedX || state.speedY[0] != prevSpeedY ) )
+                std::cout << "bounce: " << state.positionX[0] << " " << state.positionY[0] << std::endl;
+        }, UseSimulationThread && !HasFixedFrameClock() );
+    }
 
-            linPos.x += linSpeed.x * deltaTime;
-            linPos.y += linSpeed.y * deltaTime;
+    virtual void DestroyAppResources() override
+    {
+        simulation.Stop();
+    }
 
-            pos.x = linPos.x + cosX*pos_loc.x - sinX*pos_loc.y;
-            pos.y = linPos.y + sinX*pos_loc.x + cosX*pos_loc.y;
+    virtual void UpdateFrameData() override
+    {
+        SVK_TRACE_SCOPE( "AppExample::UpdateFrameData" );
 
-            // Change speed direction on collision.
-            bool collided = false;
-            if ( pos.x >  1.0f ) { linSpeed.x = -std::abs( linSpeed.x ); collided = true; }
-            if ( pos.x < -1.0f ) { linSpeed.x =  std::abs( linSpeed.x ); collided = true; }
-            if ( pos.y >  1.0f ) { linSpeed.y = -std::abs( linSpeed.y ); collided = true; }
-            if ( pos.y < -1.0f ) { linSpeed.y =  std::abs( linSpeed.y ); collided = true; }
+        // Draw in between the last two simulation steps.
+        const float alpha = HasFixedFrameClock() ? simulation.Advance( FrameDeltaTime() ) : simulation.Sample();
+        const auto& prev = simulation.Previous();
+        const auto& curr = simulation.Current();
 
-            if ( collided )
-                std::cout << "bounce: " << pos.x << " " << pos.y << std::endl;
+        for ( uint32_t tri = 0; tri < NumTriangles; ++tri )
+        {
+            // Angle wraps around by a full turn at most once per step.
+            float angleDelta = curr.angle[tri] - prev.angle[tri];
+            if ( angleDelta > _Pi ) angleDelta -= 2.0f*_Pi;
+            if ( angleDelta < -_Pi ) angleDelta += 2.0f*_Pi;
+
+            instances[tri].position.x = prev.positionX[tri] + alpha * ( curr.positionX[tri] - prev.positionX[tri] );
+            instances[tri].position.y = prev.positionY[tri] + alpha * ( curr.positionY[tri] - prev.positionY[tri] );
+            instances[tri].rotation = prev.angle[tri] + alpha * angleDelta;
         }
 
-        swapchain->ReuploadVertexBuffer( vertices );
+        swapchain->SetInstanceData( 1, instances );
     }
 
-    // Linear position + speed.
-    glm::vec2 linPos = { 0.0f, 0.0f };
-    glm::vec2 linSpeed = { 0.0f, 0.0f };
-    // Rotational position + speed.
-    float rotPos = 0.0f;
-    float rotSpeed = 0.0f;
+    // Linear and rotational position + speed, per triangle.
+    svk::FixedStepSimulation<svk::RigidBodies2D> simulation;
+    // Triangle vertices as x,y pairs, for collisions.
+    std::vector<float> outline;
+
+    std::vector<TriangleInstance> instances;
 };
 
 
-int main()
+int main( int argc, char** argv )
 {
     AppExample app;
     try
     {
+        app.ParseCommandLine( argc, argv );
         app.Init(
             800, // width
             800, // height
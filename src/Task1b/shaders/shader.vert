@@ -2,11 +2,16 @@
 
 layout(location = 0) in vec2 inPosition;
 layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inInstancePosition;
+layout(location = 3) in float inInstanceRotation;
 
 layout(location = 0) out vec3 fragColor;
 
 
 void main() {
-    gl_Position = vec4(inPosition, 0.0, 1.0);
+    const float cosX = cos(inInstanceRotation);
+    const float sinX = sin(inInstanceRotation);
+    const vec2 pos = inInstancePosition + mat2(cosX, sinX, -sinX, cosX) * inPosition;
+    gl_Position = vec4(pos, 0.0, 1.0);
     fragColor = inColor;
 }
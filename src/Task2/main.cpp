@@ -1,10 +1,10 @@
 #include "ApplicationBase.h"
 
 #include <glm/glm.hpp>
-#include <glm/gtx/rotate_vector.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
-#include <chrono>
 #include <random>
+#include <cstring>
 
 
 // Task 2: Rotating rectangle.
@@ -16,26 +16,27 @@ struct Vertex {
 };
 
 
-const std::vector<Vertex> vertices_local = {
-    // Triangle.
+const std::vector<Vertex> triangleVertices = {
     { {  0.0f, -0.2f, 0.0f }, { 1.0f, 0.0f, 0.0f} },
     { {  0.2f,  0.2f, 0.0f }, { 0.0f, 1.0f, 0.0f} },
     { { -0.2f,  0.2f, 0.0f }, { 0.0f, 0.0f, 1.0f} },
-    // Rectangle.
+};
+
+const std::vector<uint32_t> triangleIndices = {
+    0, 2, 1,
+};
+
+const std::vector<Vertex> rectangleVertices = {
     { { -0.4f, -0.3f, 0.0f }, { 1.0f, 0.0f, 0.0f} },
     { {  0.4f, -0.3f, 0.0f }, { 0.0f, 1.0f, 0.0f} },
     { { -0.4f,  0.3f, 0.0f }, { 0.0f, 0.0f, 1.0f} },
     { {  0.4f,  0.3f, 0.0f }, { 0.6f, 0.6f, 0.6f} },
 };
 
-std::vector<Vertex> vertices = vertices_local;
-
-const std::vector<uint32_t> indices = {
-    // Triangle.
-    0, 2, 1,
-    // Rectangle.
-    4, 3, 5,   4, 5, 6,
-    3, 4, 5,   5, 4, 6,
+// Both sides, so the rectangle stays visible while rotating.
+const std::vector<uint32_t> rectangleIndices = {
+    1, 0, 2,   1, 2, 3,
+    0, 1, 2,   2, 1, 3,
 };
 
 const float _2Pi = float( 2.0 * M_PI );
@@ -66,11 +67,13 @@ public:
         swapchain->Init(
             commandPool,
             this,
-            vertices,
-            indices,
+            triangleVertices,
+            triangleIndices,
             std::string(PROJECT_NAME) + "/shader.vert.spv",
             std::string(PROJECT_NAME) + "/shader.frag.spv"
         );
+        triangleMesh = 0;
+        rectangleMesh = swapchain->RegisterMesh( rectangleVertices, rectangleIndices );
     }
 
     // Gives uniformly distributed random value from [-1,1] interval.
@@ -102,11 +105,9 @@ public:
 
     virtual void UpdateFrameData() override
     {
-        static const auto startTime = std::chrono::high_resolution_clock::now();
-        static auto prevTime = startTime;
-        const auto currentTime = std::chrono::high_resolution_clock::now();
-        const float deltaTime = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - prevTime).count();
-        prevTime = currentTime;
+        SVK_TRACE_SCOPE( "AppExample::UpdateFrameData" );
+
+        const float deltaTime = FrameDeltaTime();
 
         tri_rotPos += deltaTime * tri_rotSpeed;
         RegularizeAngularValue( tri_rotPos );
@@ -116,46 +117,43 @@ public:
         RegularizeAngularValue( rec_rotPos.y );
         RegularizeAngularValue( rec_rotPos.z );
 
-        // Triangle.
-        for ( int i = 0; i < 3; ++i )
-        {
-            glm::vec3& pos = vertices[i].pos;
-            const glm::vec3& pos_loc = vertices_local[i].pos;
-            const glm::vec2 pos2_loc = { pos_loc.x, pos_loc.y };
-
-            tri_linPos.x += tri_linSpeed.x * deltaTime;
-            tri_linPos.y += tri_linSpeed.y * deltaTime;
+        tri_linPos += tri_linSpeed * deltaTime;
 
-            glm::vec2 pos2 = tri_linPos + glm::rotate( pos2_loc, tri_rotPos );
+        // Triangle is moved and rotated around its center.
+        glm::mat4 triangleTransform = glm::translate( glm::mat4(1.0f), glm::vec3( tri_linPos.x, tri_linPos.y, 0.0f ) );
+        triangleTransform = glm::rotate( triangleTransform, tri_rotPos, glm::vec3( 0.0f, 0.0f, 1.0f ) );
 
-            // Change speed direction on collision.
-            bool collided = false;
-            if ( pos2.x >  1.0f ) { tri_linSpeed.x = -std::abs( tri_linSpeed.x ); collided = true; }
-            if ( pos2.x < -1.0f ) { tri_linSpeed.x =  std::abs( tri_linSpeed.x ); collided = true; }
-            if ( pos2.y >  1.0f ) { tri_linSpeed.y = -std::abs( tri_linSpeed.y ); collided = true; }
-            if ( pos2.y < -1.0f ) { tri_linSpeed.y =  std::abs( tri_linSpeed.y ); collided = true; }
-
-            pos = { pos2.x, pos2.y, 0.0f };
-        }
-
-        // Rectangle.
-        for ( int i = 0; i < 4; ++i )
+        // Change speed direction on collision.
+        for ( const auto& vertex : triangleVertices )
         {
-            glm::vec3& pos = vertices[3+i].pos;
-            const glm::vec3& pos_loc = vertices_local[3+i].pos;
-            pos = pos_loc;
-            pos = glm::rotateX( pos, rec_rotPos.x );
-            pos = glm::rotateY( pos, rec_rotPos.y );
-            pos = glm::rotateZ( pos, rec_rotPos.z );
+            const glm::vec4 pos = triangleTransform * glm::vec4( vertex.pos, 1.0f );
+            if ( pos.x >  1.0f ) tri_linSpeed.x = -std::abs( tri_linSpeed.x );
+            if ( pos.x < -1.0f ) tri_linSpeed.x =  std::abs( tri_linSpeed.x );
+            if ( pos.y >  1.0f ) tri_linSpeed.y = -std::abs( tri_linSpeed.y );
+            if ( pos.y < -1.0f ) tri_linSpeed.y =  std::abs( tri_linSpeed.y );
         }
+
+        // Rectangle is rotated around X, then Y, then Z axis.
+        glm::mat4 rectangleTransform = glm::rotate( glm::mat4(1.0f), rec_rotPos.z, glm::vec3( 0.0f, 0.0f, 1.0f ) );
+        rectangleTransform = glm::rotate( rectangleTransform, rec_rotPos.y, glm::vec3( 0.0f, 1.0f, 0.0f ) );
+        rectangleTransform = glm::rotate( rectangleTransform, rec_rotPos.x, glm::vec3( 1.0f, 0.0f, 0.0f ) );
+
         // Adjust rectangle rotation speed a little bit.
         rec_rotSpeed.x = std::clamp( rec_rotSpeed.x + deltaTime*MaxRotationSpeed*RandomValue(), -MaxRotationSpeed, MaxRotationSpeed );
         rec_rotSpeed.y = std::clamp( rec_rotSpeed.y + deltaTime*MaxRotationSpeed*RandomValue(), -MaxRotationSpeed, MaxRotationSpeed );
         rec_rotSpeed.z = std::clamp( rec_rotSpeed.z + deltaTime*MaxRotationSpeed*RandomValue(), -MaxRotationSpeed, MaxRotationSpeed );
 
-        swapchain->ReuploadVertexBuffer( vertices );
+        std::vector<svk::DrawItem> drawItems( 2 );
+        drawItems[0].mesh = triangleMesh;
+        memcpy( drawItems[0].transform, &triangleTransform, sizeof(drawItems[0].transform) );
+        drawItems[1].mesh = rectangleMesh;
+        memcpy( drawItems[1].transform, &rectangleTransform, sizeof(drawItems[1].transform) );
+        swapchain->SetDrawList( drawItems );
     }
 
+    uint32_t triangleMesh = 0;
+    uint32_t rectangleMesh = 0;
+
     // Linear position + speed.
     glm::vec2 tri_linPos = { 0.0f, 0.0f };
     glm::vec2 tri_linSpeed = { 0.0f, 0.0f };
@@ -169,11 +167,12 @@ public:
 };
 
 
-int main()
+int main( int argc, char** argv )
 {
     AppExample app;
     try
     {
+        app.ParseCommandLine( argc, argv );
         app.Init(
             800, // width
             800, // height
@@ -5,9 +5,13 @@ layout(location = 1) in vec3 inColor;
 
 layout(location = 0) out vec3 fragColor;
 
+layout(push_constant) uniform PushConstants {
+    mat4 transform;
+} pc;
+
 
 void main() {
-    gl_Position = vec4( inPosition, 1.0 );
+    gl_Position = pc.transform * vec4( inPosition, 1.0 );
 	gl_Position.z += 0.5;
     fragColor = inColor;
 }
@@ -9,9 +9,14 @@ layout ( location = 0 ) out vec3 fragColor;
 layout ( location = 1 ) out vec2 fragTexCoord;
 layout ( location = 2 ) out flat uint fragIsTexture;
 
+layout ( push_constant ) uniform PushConstants
+{
+    mat4 transform;
+} pc;
+
 void main()
 {
-    gl_Position = vec4( inPosition, 1.0 );
+    gl_Position = pc.transform * vec4( inPosition, 1.0 );
 	gl_Position.z += 0.5;
     fragColor = inColor;
 	fragTexCoord = inTexCoord;
@@ -1,16 +1,16 @@
 #include "ApplicationBase.h"
 #include "VulkanBase.h"
 #include "Image.h"
+#include "MeshIndexing.h"
+#include "MeshOptimizer.h"
+#include "VertexQuantization.h"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
-#define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtx/hash.hpp>
 
 #include <iostream>
-#include <chrono>
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
@@ -21,23 +21,17 @@
 // Although instead of 1600+ lines of initial code, my code is just 260.
 
 
-struct Vertex {
+// Vertex as loaded from the obj file.
+struct ModelVertex {
     glm::vec3 pos;
-    glm::vec3 color;
     glm::vec2 texCoord;
-
-    bool operator==(const Vertex& other) const {
-        return pos == other.pos && color == other.color && texCoord == other.texCoord;
-    }
 };
 
-namespace std {
-template<> struct hash<Vertex> {
-    size_t operator()(Vertex const& vertex) const {
-        return ((hash<glm::vec3>()(vertex.pos) ^ (hash<glm::vec3>()(vertex.color) << 1)) >> 1) ^ (hash<glm::vec2>()(vertex.texCoord) << 1);
-    }
+// Vertex as uploaded to the GPU: 12 bytes instead of 32.
+struct Vertex {
+    uint16_t pos[4];      // Unorm16 inside the model bounding box, see svk::PositionQuantization.
+    uint16_t texCoord[2]; // Half float.
 };
-}
 
 struct UniformBufferObject {
     alignas(16) glm::mat4 model;
@@ -64,6 +58,8 @@ private:
     std::shared_ptr<svk::Image> colorImage;
     std::vector<Vertex> vertices;
     std::vector<uint32_t> indices;
+    svk::PositionQuantization positionQuantization;
+    bool isMeshReported = false;
 
 public:
 
@@ -75,9 +71,8 @@ public:
     virtual std::vector<VkVertexInputAttributeDescription> getVertexAttributeDescriptions() const override
     {
         return {
-            { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, pos) },
-            { 1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, color) },
-            { 2, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, texCoord) },
+            { 0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(Vertex, pos) },
+            { 1, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(Vertex, texCoord) },
         };
     }
 
@@ -153,16 +148,18 @@ public:
 
     virtual void UpdateRenderEntry( const svk::SwapChainInfo& swapChainInfo, const svk::SwapChainEntry& swapChainEntry, const int swapEntryIndex ) override
     {
+        SVK_TRACE_SCOPE( "AppExample::UpdateRenderEntry" );
+
         const auto device = svk::theVulkanContext().LogicalDevice();
         auto& entry = renderEntries[swapEntryIndex];
 
-        static auto startTime = std::chrono::high_resolution_clock::now();
-
-        auto currentTime = std::chrono::high_resolution_clock::now();
-        float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+        const float time = float( FrameTime() );
 
         UniformBufferObject ubo{};
-        ubo.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        const glm::vec3 quantizationOffset = glm::vec3( positionQuantization.offset[0], positionQuantization.offset[1], positionQuantization.offset[2] );
+        const glm::vec3 quantizationScale = glm::vec3( positionQuantization.scale[0], positionQuantization.scale[1], positionQuantization.scale[2] );
+        const glm::mat4 dequantization = glm::scale( glm::translate( glm::mat4(1.0f), quantizationOffset ), quantizationScale );
+        ubo.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f)) * dequantization;
         ubo.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
         ubo.proj = glm::perspective(glm::radians(45.0f), swapChainInfo.extent.width / (float) swapChainInfo.extent.height, 0.1f, 10.0f);
         ubo.proj[1][1] *= -1;
@@ -185,6 +182,12 @@ public:
         );
     }
 
+    // --mesh-report prints the vertex cache and fetch statistics of the model before and after optimization.
+    void ParseModelOptions( int argc, char** argv )
+    {
+        isMeshReported = svk::HasCommandLineOption( argc, argv, "mesh-report" );
+    }
+
     virtual void InitAppResources() override
     {
         colorImage = svk::Image::CreateFromFile( *commandPool, TEXTURE_PATH );
@@ -199,6 +202,8 @@ public:
 
     void loadModel()
     {
+        SVK_TRACE_SCOPE( "AppExample::loadModel" );
+
         tinyobj::attrib_t attrib;
         std::vector<tinyobj::shape_t> shapes;
         std::vector<tinyobj::material_t> materials;
@@ -207,13 +212,18 @@ public:
         if ( !tinyobj::LoadObj( &attrib, &shapes, &materials, &warn, &err, MODEL_PATH.c_str() ) )
             throw std::runtime_error( warn + err );
 
-        std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+        size_t numCorners = 0;
+        for ( const auto& shape : shapes )
+            numCorners += shape.mesh.indices.size();
+
+        std::vector<ModelVertex> corners;
+        corners.reserve( numCorners );
 
         for (const auto& shape : shapes)
         {
             for ( const auto& index : shape.mesh.indices )
             {
-                Vertex vertex{};
+                ModelVertex vertex{};
 
                 vertex.pos = {
                     attrib.vertices[3 * index.vertex_index + 0],
@@ -226,25 +236,42 @@ public:
                     1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
                 };
 
-                vertex.color = {1.0f, 1.0f, 1.0f};
+                corners.push_back(vertex);
+            }
+        }
+
+        // Merge identical corners into shared vertices.
+        std::vector<ModelVertex> modelVertices;
+        svk::BuildIndexedMesh( corners, modelVertices, indices );
 
-                if (uniqueVertices.count(vertex) == 0) {
-                    uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-                    vertices.push_back(vertex);
-                }
+        // Reorder for vertex cache, overdraw and vertex fetch.
+        const auto report = svk::OptimizeMesh( modelVertices, indices, offsetof(ModelVertex, pos) );
+        if ( isMeshReported )
+        {
+            std::cout << "Mesh optimization: ACMR " << report.before.acmr << " -> " << report.after.acmr
+                << ", ATVR " << report.before.atvr << " -> " << report.after.atvr << std::endl;
+        }
 
-                indices.push_back(uniqueVertices[vertex]);
-            }
+        // Quantize. Dequantization of positions is applied through the model matrix.
+        positionQuantization = svk::ComputePositionQuantization( &modelVertices[0].pos, sizeof(ModelVertex), modelVertices.size() );
+        vertices.resize( modelVertices.size() );
+        for ( size_t i = 0; i < modelVertices.size(); ++i )
+        {
+            svk::QuantizePosition( positionQuantization, &modelVertices[i].pos.x, vertices[i].pos );
+            vertices[i].texCoord[0] = svk::FloatToHalf( modelVertices[i].texCoord.x );
+            vertices[i].texCoord[1] = svk::FloatToHalf( modelVertices[i].texCoord.y );
         }
     }
 };
 
 
-int main()
+int main( int argc, char** argv )
 {
     AppExample app;
     try
     {
+        app.ParseCommandLine( argc, argv );
+        app.ParseModelOptions( argc, argv );
         app.Init(
             800, // width
             800, // height
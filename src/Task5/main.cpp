@@ -1,17 +1,25 @@
 #include "ApplicationBase.h"
 #include "Image.h"
+#include "Buffer.h"
+#include "ComputePipeline.h"
+#include "VulkanBase.h"
+#include "ParticleIntegrator.h"
+#include "Random.h"
+#include "FixedStepSimulation.h"
 
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/rotate_vector.hpp>
 #include <iostream>
-#include <chrono>
-#include <random>
+#include <cstring>
 
 
 // Task 5: Some creative non-trivial feature.
 // When you mouse click on a rectangle, it will explode into hundreds of pieces.
 // These pieces have random starting velocity, controlled by hard-coded constants.
 // After explosion, small pieces will come back together again in time.
+// Explosion state lives in a GPU storage buffer and is integrated by a compute shader,
+// which is also read as per-instance vertex data.
 
 
 struct Vertex {
@@ -22,22 +30,6 @@ struct Vertex {
 const float recSizeX = 0.8f;
 const float recSizeY = 0.6f;
 
-std::vector<Vertex> vertices_local = {
-
-    { { -recSizeX*0.5, -recSizeY*0.5, 0.0f }, { 0.0f, 0.0f } },
-    { {  recSizeX*0.5, -recSizeY*0.5, 0.0f }, { 1.0f, 0.0f } },
-    { { -recSizeX*0.5,  recSizeY*0.5, 0.0f }, { 0.0f, 1.0f } },
-
-    { {  recSizeX*0.5,  recSizeY*0.5, 0.0f }, { 1.0f, 1.0f } },
-    { {  recSizeX*0.5, -recSizeY*0.5, 0.0f }, { 1.0f, 0.0f } },
-    { { -recSizeX*0.5,  recSizeY*0.5, 0.0f }, { 0.0f, 1.0f } },
-
-};
-
-std::vector<Vertex> vertices = vertices_local;
-
-std::vector<uint32_t> indices = { 1, 0, 2, 3, 4, 5, };
-
 // Local corners of rectangle in counter-clockwise order.
 const std::vector<glm::vec3> corners = {
     { -recSizeX*0.5, -recSizeY*0.5, 0.0f },
@@ -46,12 +38,19 @@ const std::vector<glm::vec3> corners = {
     { -recSizeX*0.5,  recSizeY*0.5, 0.0f },
 };
 
+// Lower-left and upper-right triangles of a unit grid cell.
 const std::vector<glm::vec3> vertices_base = {
     { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 },
     { 1, 1, 0 }, { 1, 0, 0 }, { 0, 1, 0 },
 };
 
-const std::vector<uint32_t> indices_base = { 1, 0, 2,   3, 4, 5, };
+const std::vector<uint32_t> indices_base = { 1, 0, 2,   0, 1, 2, };
+
+// Placement of a grid cell inside the rectangle, per instance.
+struct CellInstance {
+    glm::vec2 offset;
+    glm::vec2 texOffset;
+};
 
 
 const float _2Pi = float( 2.0 * M_PI );
@@ -60,15 +59,47 @@ const float MaxLinearSpeed = 0.5f;
 // In radians per second.
 const float MaxRotationSpeed = 0.8f;
 
+// Explosion constants, must match shaders/explode.comp.
 const float TrianglesPullToCenter = 2.0f; // Constant speed that pulls to center.
 const float TrianglesExplodeSpeedMin = 3.0f; // Min out-of-center starting speed.
 const float TrianglesExplodeSpeedMax = 5.0f; // Max out-of-center starting speed.
 const float TrianglesExplodeSpeedDeterioration = 2.0f; // How much speed deteriorates per second.
 
-std::vector<glm::vec3> TrianglesExplodeSpeed; // Out-of-center speed.
-std::vector<glm::vec3> TrianglesExplodeShift; // Relative position to center.
+// Explosion is integrated by the compute shader, or on the CPU by svk::StepExplodeParticles
+// when the graphics queue family has no compute, or with --cpu-simulation. Chosen in InitAppResources.
+bool isComputeSimulation = true;
+
+// Motion runs at a fixed rate, on its own thread or inside UpdateFrameData.
+// The compute shader runs the same number of fixed steps per frame.
+const float SimulationStep = 1.0f / 120.0f;
+const bool UseSimulationThread = true;
+const uint32_t MaxExplodeStepsPerFrame = 8;
+
+// Per triangle, matches TriangleState in shaders/explode.comp (std430).
+// Lower triangles of all cells come first, then upper ones.
+struct TriangleState {
+    glm::vec4 speed; // Out-of-center speed.
+    glm::vec4 shift; // Relative position to center.
+};
+
+// Push constants of shaders/explode.comp.
+struct ExplodeParams {
+    float deltaTime; // Of one step.
+    uint32_t numSteps;
+    uint32_t numTriangles;
+    uint32_t impulseSeed; // Explodes all triangles, if non-zero.
+};
+
+const uint32_t ExplodeGroupSize = 64;
+
 int numTriangles = 2;
 
+// Lower and upper triangles are two meshes, drawn with one instance per cell.
+// Cell instances are stored twice, since upper triangle instances follow the lower ones.
+std::vector<Vertex> lowerVertices, upperVertices;
+std::vector<uint32_t> lowerIndices, upperIndices;
+std::vector<CellInstance> cellInstances;
+
 
 // Create subdivision of rectangle.
 void PopulateTriangles()
@@ -78,23 +109,32 @@ void PopulateTriangles()
     const glm::vec3 delta = { recSizeX / float(numX), recSizeY / float(numY), 0.0f };
     const glm::vec3 start = { -recSizeX * 0.5, -recSizeY * 0.5, 0.0f };
     numTriangles = numX * numY * 2;
-    vertices_local.resize( numTriangles * 3 );
-    indices.resize( numTriangles * 3 );
+
+    lowerVertices.resize( 3 );
+    upperVertices.resize( 3 );
+    for ( int i = 0; i < 3; ++i )
+    {
+        lowerVertices[i].pos = delta * vertices_base[i];
+        lowerVertices[i].texCoord = { vertices_base[i].x / float(numX), vertices_base[i].y / float(numY) };
+        upperVertices[i].pos = delta * vertices_base[3+i];
+        upperVertices[i].texCoord = { vertices_base[3+i].x / float(numX), vertices_base[3+i].y / float(numY) };
+    }
+    lowerIndices.assign( indices_base.begin(), indices_base.begin() + 3 );
+    upperIndices.assign( indices_base.begin() + 3, indices_base.end() );
+
+    const int numCells = numX * numY;
+    cellInstances.resize( 2 * numCells );
     for ( int i_x = 0; i_x < numX; ++i_x )
     {
         for ( int i_y = 0; i_y < numY; ++i_y )
         {
-            for ( int i = 0; i < 6; ++i )
-            {
-                const int index = i + 6*i_x + 6*numX*i_y;
-                vertices_local[index].pos = start + delta*( glm::vec3(i_x,i_y,0) + vertices_base[i] );
-                vertices_local[index].texCoord.x = float( i_x + vertices_base[i].x ) / float(numX);
-                vertices_local[index].texCoord.y = float( i_y + vertices_base[i].y ) / float(numY);
-                indices[index] = 6*i_x + 6*numX*i_y + indices_base[i];
-            }
+            auto& cell = cellInstances[i_x + numX*i_y];
+            const glm::vec3 offset = start + delta*glm::vec3(i_x,i_y,0);
+            cell.offset = { offset.x, offset.y };
+            cell.texOffset = { float(i_x) / float(numX), float(i_y) / float(numY) };
+            cellInstances[numCells + i_x + numX*i_y] = cell;
         }
     }
-    vertices = vertices_local;
 }
 
 
@@ -102,18 +142,81 @@ const std::string TEXTURE_PATH = std::string(ROOT_DIRECTORY) + "/media/texture.j
 
 
 
-// Gives uniformly distributed random value from [0,1] interval.
-float RandomValue()
+void RegularizeAngularValue( float& angle )
 {
-    static std::random_device rd;  // Will be used to obtain a seed for the random number engine
-    static std::mt19937 gen( rd() ); // Standard mersenne_twister_engine seeded with rd()
-    static std::uniform_real_distribution<> dis( 0.0, 1.0 );
-    return dis( gen );
+    angle -= int( angle / _2Pi ) * _2Pi;
 }
 
-void RegularizeAngularValue( float& angle )
+
+// Simulated on the simulation thread.
+struct RectangleState {
+    // Linear position + speed.
+    glm::vec3 linPos = { 0.0f, 0.0f, 0.0f };
+    glm::vec3 linSpeed = { 0.0f, 0.0f, 0.0f };
+    // Rotational position + speed.
+    float rotPos = 0.0f;
+    float rotSpeed = 0.0f;
+
+    svk::RandomStream random;
+
+    // CPU explosion, if isComputeSimulation is false.
+    svk::ExplodeParticles particles;
+};
+
+
+void StepRectangle( RectangleState& state, const float deltaTime )
 {
-    angle -= int( angle / _2Pi ) * _2Pi;
+    auto& linSpeed = state.linSpeed;
+    auto& rotSpeed = state.rotSpeed;
+    auto& random = state.random;
+
+    // Adjust linear speed a little bit.
+    linSpeed.x = std::clamp( linSpeed.x + deltaTime*MaxLinearSpeed*random.NextFloat( -1.0f, 1.0f ), -MaxLinearSpeed, MaxLinearSpeed );
+    linSpeed.y = std::clamp( linSpeed.y + deltaTime*MaxLinearSpeed*random.NextFloat( -1.0f, 1.0f ), -MaxLinearSpeed, MaxLinearSpeed );
+    // Adjust rotation speed a little bit.
+    rotSpeed = std::clamp( rotSpeed + deltaTime*MaxRotationSpeed*random.NextFloat( -1.0f, 1.0f ), -MaxRotationSpeed, MaxRotationSpeed );
+
+    state.linPos += linSpeed * deltaTime;
+    state.rotPos += deltaTime * rotSpeed;
+    RegularizeAngularValue( state.rotPos );
+
+    // Check corners for collision.
+    for ( const auto& corner : corners )
+    {
+        glm::vec3 pos = corner;
+        pos = glm::rotateZ( pos, state.rotPos );
+        pos += state.linPos;
+
+        if ( pos.x >  1.0f ) linSpeed.x = -std::abs( linSpeed.x );
+        if ( pos.x < -1.0f ) linSpeed.x =  std::abs( linSpeed.x );
+        if ( pos.y >  1.0f ) linSpeed.y = -std::abs( linSpeed.y );
+        if ( pos.y < -1.0f ) linSpeed.y =  std::abs( linSpeed.y );
+    }
+
+    if ( !isComputeSimulation )
+    {
+        svk::ExplodeParameters parameters;
+        parameters.pullToCenter = TrianglesPullToCenter;
+        parameters.speedDeterioration = TrianglesExplodeSpeedDeterioration;
+        svk::StepExplodeParticles( state.particles, parameters, deltaTime );
+    }
+}
+
+
+// Adds random explode speed to all particles, with the same values as shaders/explode.comp.
+void ExplodeParticles( svk::ExplodeParticles& particles, const uint32_t seed )
+{
+    SVK_TRACE_SCOPE( "ExplodeParticles" );
+
+    std::vector<float> values( 2 * particles.Size() );
+    svk::FillRandomFloats( seed, 0, values.data(), values.size() );
+    for ( size_t tri_ind = 0; tri_ind < particles.Size(); ++tri_ind )
+    {
+        const float dir_angle = values[2*tri_ind] * _2Pi;
+        const float value = TrianglesExplodeSpeedMin + values[2*tri_ind + 1] * ( TrianglesExplodeSpeedMax - TrianglesExplodeSpeedMin );
+        particles.speedX[tri_ind] += value*cos(dir_angle);
+        particles.speedY[tri_ind] += value*sin(dir_angle);
+    }
 }
 
 
@@ -126,11 +229,23 @@ public:
         return { 0, sizeof(Vertex), VK_VERTEX_INPUT_RATE_VERTEX };
     }
 
+    virtual std::vector<VkVertexInputBindingDescription> getVertexBindingDescriptions() const override
+    {
+        return {
+            { 0, sizeof(Vertex), VK_VERTEX_INPUT_RATE_VERTEX },
+            { 1, sizeof(CellInstance), VK_VERTEX_INPUT_RATE_INSTANCE },
+            { 2, sizeof(TriangleState), VK_VERTEX_INPUT_RATE_INSTANCE },
+        };
+    }
+
     virtual std::vector<VkVertexInputAttributeDescription> getVertexAttributeDescriptions() const override
     {
         return {
             { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, pos) },
             { 1, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, texCoord) },
+            { 2, 1, VK_FORMAT_R32G32_SFLOAT, offsetof(CellInstance, offset) },
+            { 3, 1, VK_FORMAT_R32G32_SFLOAT, offsetof(CellInstance, texOffset) },
+            { 4, 2, VK_FORMAT_R32G32B32_SFLOAT, offsetof(TriangleState, shift) },
         };
     }
 
@@ -166,113 +281,181 @@ public:
         swapchain->Init(
             commandPool,
             this,
-            vertices,
-            indices,
+            lowerVertices,
+            lowerIndices,
             std::string(PROJECT_NAME) + "/shader.vert.spv",
             std::string(PROJECT_NAME) + "/shader.frag.spv"
         );
+        const uint32_t upperMesh = swapchain->RegisterMesh( upperVertices, upperIndices );
+
+        const uint32_t numCells = cellInstances.size() / 2;
+        swapchain->SetInstanceData( 1, cellInstances );
+        if ( isComputeSimulation )
+            swapchain->SetInstanceBuffer( 2, triangleStates.Handle(), numTriangles );
+        else
+            swapchain->SetInstanceData( 2, cpuStates );
+
+        drawItems.resize( 2 );
+        drawItems[0].mesh = 0;
+        drawItems[0].numInstances = numCells;
+        drawItems[1].mesh = upperMesh;
+        drawItems[1].firstInstance = numCells;
+        drawItems[1].numInstances = numCells;
+        swapchain->SetDrawList( drawItems );
+    }
+
+    // --cpu-simulation integrates the explosion on the CPU even if compute shaders are available.
+    void ParseSimulationOptions( int argc, char** argv )
+    {
+        isCpuSimulationForced = svk::HasCommandLineOption( argc, argv, "cpu-simulation" );
     }
 
     virtual void InitAppResources() override
     {
-        linSpeed.x = (-1.0f + 2.0f*RandomValue()) * MaxLinearSpeed;
-        linSpeed.y = (-1.0f + 2.0f*RandomValue()) * MaxLinearSpeed;
-        rotSpeed = (-1.0f + 2.0f*RandomValue()) * MaxRotationSpeed;
+        isComputeSimulation = !isCpuSimulationForced && svk::theVulkanContext().ComputeFamily().has_value();
+        std::cout << "Explosion: " << ( isComputeSimulation ? "compute shader" : "CPU" ) << std::endl;
+
+        RectangleState rectangle;
+        rectangle.random = svk::RandomStream( svk::RandomSeed() );
+        rectangle.linSpeed.x = rectangle.random.NextFloat( -1.0f, 1.0f ) * MaxLinearSpeed;
+        rectangle.linSpeed.y = rectangle.random.NextFloat( -1.0f, 1.0f ) * MaxLinearSpeed;
+        rectangle.rotSpeed = rectangle.random.NextFloat( -1.0f, 1.0f ) * MaxRotationSpeed;
+        clickRandom = svk::RandomStream( svk::RandomSeed() );
 
         PopulateTriangles();
 
-        TrianglesExplodeSpeed.resize( numTriangles );
-        TrianglesExplodeShift.resize( numTriangles );
-        for ( int i = 0; i < numTriangles; ++i )
+        const std::vector<TriangleState> initialStates( numTriangles, TriangleState{ glm::vec4(0.0f), glm::vec4(0.0f) } );
+        texture = svk::Image::CreateFromFile( *commandPool, TEXTURE_PATH );
+
+        if ( !isComputeSimulation )
         {
-            TrianglesExplodeSpeed[i] = glm::vec3( 0.0f, 0.0f, 0.0f );
-            TrianglesExplodeShift[i] = glm::vec3( 0.0f, 0.0f, 0.0f );
+            rectangle.particles.Resize( numTriangles );
+            cpuStates = initialStates;
         }
+        simulation.Start( rectangle, SimulationStep, StepRectangle, UseSimulationThread && !HasFixedFrameClock() );
+        if ( !isComputeSimulation )
+            return;
 
-        texture = svk::Image::CreateFromFile( *commandPool, TEXTURE_PATH );
-
-        glfwSetMouseButtonCallback( window, mouse_button_callback );
+        triangleStates.Reset(
+            initialStates.size() * sizeof(TriangleState),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+        );
+        triangleStates.Upload( *commandPool, initialStates.data(), triangleStates.Size() );
+
+        VkDescriptorSetLayoutBinding statesBinding{};
+        statesBinding.binding = 0;
+        statesBinding.descriptorCount = 1;
+        statesBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        statesBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        explodePipeline.Reset( std::string(PROJECT_NAME) + "/explode.comp.spv", { statesBinding }, sizeof(ExplodeParams) );
+
+        VkWriteDescriptorSet statesWrite{};
+        statesWrite.dstBinding = 0;
+        statesWrite.descriptorCount = 1;
+        statesWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        statesWrite.pBufferInfo = &triangleStates.Info();
+        explodePipeline.UpdateDescriptorSet( 0, { statesWrite } );
     }
 
     virtual void DestroyAppResources() override
     {
+        simulation.Stop();
         texture.reset();
+        explodePipeline.Clear();
+        triangleStates.Clear();
     }
 
     virtual void UpdateFrameData() override
     {
-        static const auto startTime = std::chrono::high_resolution_clock::now();
-        static auto prevTime = startTime;
-        const auto currentTime = std::chrono::high_resolution_clock::now();
-        const float deltaTime = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - prevTime).count();
-        prevTime = currentTime;
-
-        // Adjust linear speed a little bit.
-        linSpeed.x = std::clamp( linSpeed.x + deltaTime*MaxLinearSpeed*(-1.0f + 2.0f*RandomValue()), -MaxLinearSpeed, MaxLinearSpeed );
-        linSpeed.y = std::clamp( linSpeed.y + deltaTime*MaxLinearSpeed*(-1.0f + 2.0f*RandomValue()), -MaxLinearSpeed, MaxLinearSpeed );
-        // Adjust rotation speed a little bit.
-        rotSpeed = std::clamp( rotSpeed + deltaTime*MaxRotationSpeed*(-1.0f + 2.0f*RandomValue()), -MaxRotationSpeed, MaxRotationSpeed );
-
-        linPos += linSpeed * deltaTime;
-        rotPos += deltaTime * rotSpeed;
-        RegularizeAngularValue( rotPos );
-
-        // Check corners for collision.
-        for ( const auto& corner : corners )
-        {
-            glm::vec3 pos = corner;
-            pos = glm::rotateZ( pos, rotPos );
-            pos += linPos;
-
-            bool collided = false;
-            if ( pos.x >  1.0f ) { linSpeed.x = -std::abs( linSpeed.x ); collided = true; }
-            if ( pos.x < -1.0f ) { linSpeed.x =  std::abs( linSpeed.x ); collided = true; }
-            if ( pos.y >  1.0f ) { linSpeed.y = -std::abs( linSpeed.y ); collided = true; }
-            if ( pos.y < -1.0f ) { linSpeed.y =  std::abs( linSpeed.y ); collided = true; }
-        }
+        SVK_TRACE_SCOPE( "AppExample::UpdateFrameData" );
+
+        const float deltaTime = FrameDeltaTime();
+
+        // Draw in between the last two simulation steps.
+        const float alpha = HasFixedFrameClock() ? simulation.Advance( deltaTime ) : simulation.Sample();
+        const auto& prev = simulation.Previous();
+        const auto& curr = simulation.Current();
+
+        // Angle wraps around by a full turn at most once per step.
+        float rotDelta = curr.rotPos - prev.rotPos;
+        if ( rotDelta > 0.5f*_2Pi ) rotDelta -= _2Pi;
+        if ( rotDelta < -0.5f*_2Pi ) rotDelta += _2Pi;
+        linPos = prev.linPos + alpha * ( curr.linPos - prev.linPos );
+        rotPos = prev.rotPos + alpha * rotDelta;
+
+        // Triangles are moved by the compute shader recorded with this frame, in fixed steps, or on the CPU.
+        explodeStepTime = std::min( explodeStepTime + deltaTime, MaxExplodeStepsPerFrame * SimulationStep );
+        explodeNumSteps = uint32_t( explodeStepTime / SimulationStep );
+        explodeStepTime -= explodeNumSteps * SimulationStep;
+        if ( !isComputeSimulation )
+            UpdateCpuStates( prev.particles, curr.particles, alpha );
+
+        // Rectangle transform is shared by all triangles, explode shift is per instance.
+        glm::mat4 transform = glm::translate( glm::mat4(1.0f), linPos );
+        transform = glm::rotate( transform, rotPos, glm::vec3( 0.0f, 0.0f, 1.0f ) );
+
+        for ( auto& item : drawItems )
+            memcpy( item.transform, &transform, sizeof(item.transform) );
+        swapchain->SetDrawList( drawItems );
+    }
+
+    void UpdateCpuStates( const svk::ExplodeParticles& prev, const svk::ExplodeParticles& curr, const float alpha )
+    {
+        SVK_TRACE_SCOPE( "AppExample::UpdateCpuStates" );
 
-        // Move triangles.
-        for ( int tri_ind = 0; tri_ind < numTriangles; ++tri_ind )
+        for ( int i = 0; i < numTriangles; ++i )
         {
-            auto& explodeSpeed = TrianglesExplodeSpeed[tri_ind];
-            auto& explodeShift = TrianglesExplodeShift[tri_ind];
-            // Deteriorate explode speed.
-            float speedNorm = glm::length( explodeSpeed );
-            const glm::vec3 speedDir = (speedNorm > 0.01f) ? (explodeSpeed/speedNorm) : glm::vec3(0,0,0);
-            const float deterioration = ( 1.0f + glm::length( explodeShift ) ) * TrianglesExplodeSpeedDeterioration;
-            speedNorm = std::max( 0.0f, speedNorm - deltaTime*deterioration );
-            explodeSpeed = speedNorm * speedDir;
-            // Apply explode speed, then pull to center.
-            explodeShift += explodeSpeed * deltaTime;
-            float centerDist = glm::length( explodeShift );
-            const glm::vec3 shiftDir = (centerDist > 0.0001f) ? (explodeShift / centerDist) : glm::vec3(0,0,0);
-            centerDist = std::max( 0.0f, centerDist - deltaTime*TrianglesPullToCenter );
-            explodeShift = centerDist * shiftDir;
-            // Apply transform to each triangle vertex.
-            for ( int i = 0; i < 3; ++i )
-            {
-                glm::vec3 pos = vertices_local[3*tri_ind+i].pos;
-                pos = glm::rotateZ( pos, rotPos );
-                pos += linPos;
-                pos += explodeShift;
-                vertices[3*tri_ind+i].pos = pos;
-            }
+            const glm::vec3 prevShift = { prev.shiftX[i], prev.shiftY[i], prev.shiftZ[i] };
+            const glm::vec3 currShift = { curr.shiftX[i], curr.shiftY[i], curr.shiftZ[i] };
+            cpuStates[i].speed = { curr.speedX[i], curr.speedY[i], curr.speedZ[i], 0.0f };
+            cpuStates[i].shift = glm::vec4( prevShift + alpha * ( currShift - prevShift ), 0.0f );
         }
-
-        swapchain->ReuploadVertexBuffer( vertices );
+        swapchain->SetInstanceData( 2, cpuStates );
     }
 
-    static void mouse_button_callback( GLFWwindow* window, int button, int action, int mods )
+    virtual void RecordPreRenderPassCommands( const VkCommandBuffer commandBuffer, const int swapEntryIndex ) override
     {
-        auto app = reinterpret_cast<AppExample*>( glfwGetWindowUserPointer( window ) );
+        SVK_TRACE_SCOPE( "AppExample::RecordPreRenderPassCommands" );
+
+        if ( !isComputeSimulation )
+            return;
+
+        // States are shared by all frames in flight: wait until previous frames are done with them.
+        svk::cmdBufferBarrier(
+            commandBuffer, triangleStates.Handle(),
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+        );
+
+        ExplodeParams params;
+        params.deltaTime = SimulationStep;
+        params.numSteps = explodeNumSteps;
+        params.numTriangles = numTriangles;
+        params.impulseSeed = pendingImpulseSeed;
+        pendingImpulseSeed = 0;
+
+        explodePipeline.Bind( commandBuffer );
+        explodePipeline.PushConstants( commandBuffer, &params, sizeof(params) );
+        explodePipeline.Dispatch( commandBuffer, svk::ComputePipeline::GroupCount( numTriangles, ExplodeGroupSize ) );
+        explodeNumSteps = 0;
+
+        svk::cmdBufferBarrier(
+            commandBuffer, triangleStates.Handle(),
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT
+        );
+    }
 
-        if ( button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS )
+    virtual void OnInputEvent( const svk::InputEvent& event ) override
+    {
+        if ( event.type == svk::InputEventType::MouseButton && event.code == GLFW_MOUSE_BUTTON_LEFT && event.action == GLFW_PRESS )
         {
-            double xpos, ypos;
-            glfwGetCursorPos( window, &xpos, &ypos );
+            const double xpos = event.x;
+            const double ypos = event.y;
 
-            int width, height;
-            glfwGetFramebufferSize( window, &width, &height );
+            const int width = input.FramebufferWidth();
+            const int height = input.FramebufferHeight();
 
             glm::vec2 clickPos = glm::vec2(0.5+xpos,0.5+ypos) / glm::vec2(width,height);
             clickPos = -glm::vec2(1.0f,1.0f) + 2.0f*clickPos;
@@ -284,8 +467,8 @@ public:
             for ( int i = 0; i < 4; ++i )
             {
                 glm::vec3 pos = corners[i];
-                pos = glm::rotateZ( pos, app->rotPos );
-                pos += app->linPos;
+                pos = glm::rotateZ( pos, rotPos );
+                pos += linPos;
                 cur_corners[i] = { pos.x, pos.y };
             }
 
@@ -301,36 +484,49 @@ public:
 
             if ( isInside )
             {
-                // Explode triangles.
-                for ( int tri_ind = 0; tri_ind < numTriangles; ++tri_ind )
-                {
-                    const float dir_angle = RandomValue() * _2Pi;
-                    const glm::vec3 dir = { cos(dir_angle), sin(dir_angle), 0.0f };
-                    const float value = TrianglesExplodeSpeedMin + RandomValue() * ( TrianglesExplodeSpeedMax - TrianglesExplodeSpeedMin );
-                    TrianglesExplodeSpeed[tri_ind] += value*dir;
-                }
+                // Explode triangles with the next dispatch, or the next CPU step. Zero seed means no impulse.
+                const uint32_t seed = clickRandom.NextUint() | 1u;
+                if ( isComputeSimulation )
+                    pendingImpulseSeed = seed;
+                else
+                    simulation.Post( [seed]( RectangleState& state ) { ExplodeParticles( state.particles, seed ); } );
             }
         }
     }
 
-    // Linear position + speed.
+    svk::FixedStepSimulation<RectangleState> simulation;
+    // Interpolated position and rotation, as drawn.
     glm::vec3 linPos = { 0.0f, 0.0f, 0.0f };
-    glm::vec3 linSpeed = { 0.0f, 0.0f, 0.0f };
-    // Rotational position + speed.
     float rotPos = 0.0f;
-    float rotSpeed = 0.0f;
+
+    svk::RandomStream clickRandom;
+
+    // Lower and upper triangles of all cells.
+    std::vector<svk::DrawItem> drawItems;
 
     // Texture.
     std::shared_ptr<svk::Image> texture;
+
+    // Explosion simulation.
+    svk::Buffer triangleStates;
+    svk::ComputePipeline explodePipeline;
+    float explodeStepTime = 0.0f; // Not yet simulated time.
+    uint32_t explodeNumSteps = 0;
+    uint32_t pendingImpulseSeed = 0;
+    bool isCpuSimulationForced = false;
+    // Instance data of the CPU simulation.
+    std::vector<TriangleState> cpuStates;
 };
 
 
 
-int main()
+int main( int argc, char** argv )
 {
     AppExample app;
     try
     {
+        app.ParseCommandLine( argc, argv );
+        app.ParseSimulationOptions( argc, argv );
         app.Init(
             800, // width
             800, // height
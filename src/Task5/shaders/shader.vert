@@ -2,12 +2,21 @@
 
 layout ( location = 0 ) in vec3 inPosition;
 layout ( location = 1 ) in vec2 inTexCoord;
+layout ( location = 2 ) in vec2 inCellOffset;
+layout ( location = 3 ) in vec2 inCellTexOffset;
+layout ( location = 4 ) in vec3 inExplodeShift;
 
 layout(location = 0) out vec2 fragTexCoord;
 
+layout ( push_constant ) uniform PushConstants
+{
+    mat4 transform;
+} pc;
+
 
 void main()
 {
-    gl_Position = vec4( inPosition, 1.0 );
-    fragTexCoord = inTexCoord;
+    gl_Position = pc.transform * vec4( inPosition + vec3( inCellOffset, 0.0 ), 1.0 );
+    gl_Position.xyz += inExplodeShift;
+    fragTexCoord = inTexCoord + inCellTexOffset;
 }
@@ -145,6 +145,8 @@ public:
 
     virtual void UpdateRenderEntry( const svk::SwapChainInfo& swapChainInfo, const svk::SwapChainEntry& swapChainEntry, const int swapEntryIndex ) override
     {
+        SVK_TRACE_SCOPE( "AppExample::UpdateRenderEntry" );
+
         const auto device = svk::theVulkanContext().LogicalDevice();
         auto& entry = renderEntries[swapEntryIndex];
 
@@ -189,11 +191,12 @@ public:
 };
 
 
-int main()
+int main( int argc, char** argv )
 {
     AppExample app;
     try
     {
+        app.ParseCommandLine( argc, argv );
         app.Init(
             WIDTH,
             HEIGHT,
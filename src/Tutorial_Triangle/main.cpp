@@ -56,11 +56,12 @@ public:
 };
 
 
-int main()
+int main( int argc, char** argv )
 {
     AppExample app;
     try
     {
+        app.ParseCommandLine( argc, argv );
         app.Init(
             WIDTH,
             HEIGHT,
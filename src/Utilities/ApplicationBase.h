@@ -4,17 +4,74 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#include "CommandLine.h"
 #include "CommandPool.h"
+#include "FrameBenchmark.h"
+#include "GpuProfiler.h"
+#include "Input.h"
+#include "PresentPolicy.h"
 #include "SwapChain.h"
+#include "Trace.h"
 #include "VulkanContext.h"
 
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <thread>
+
 
 namespace svk {
 
+// Window, Vulkan context and swap chain of an app, with its main loop.
+// By default the main thread only pumps window events, and a render thread owns
+// UpdateFrameData, acquire, submit and present, so OS event storms and window drags
+// do not stall frames. Input reaches the render thread through a lock-free queue:
+// use OnInputEvent and the input state instead of GLFW input calls, which are main thread only.
+// Animate with FrameTime and FrameDeltaTime, which follow a fixed frame clock in benchmark runs.
 class ApplicationBase : public RenderEntryManager
 {
 public:
 
+    // Present policy options, see PresentPolicy::FromCommandLine, and
+    // --gpu-profile[=file.csv|file.json] to print GPU times once a second and optionally save them,
+    // --trace=file.json to save a CPU trace, if built with SVK_ENABLE_TRACING,
+    // benchmark options, see FrameBenchmark, and --headless to render without a window, for benchmarks.
+    // Call before Init.
+    void ParseCommandLine( int argc, char** argv )
+    {
+        auto presentPolicy = PresentPolicy::FromCommandLine( argc, argv );
+        benchmark = FrameBenchmark::FromCommandLine( argc, argv );
+        isHeadless = HasCommandLineOption( argc, argv, "headless" );
+        if ( isHeadless && !benchmark.IsEnabled() )
+            throw std::runtime_error( "--headless needs --benchmark, there is no window to close." );
+        // Benchmarks measure the frame time, not the display refresh, unless a present mode is given.
+        if ( benchmark.IsEnabled() && !HasCommandLineOption( argc, argv, "present-mode" ) )
+            presentPolicy.presentModes = { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR };
+        theVulkanContext().SetPresentPolicy( presentPolicy );
+
+        if ( HasCommandLineOption( argc, argv, "gpu-profile" ) )
+        {
+            gpuProfiler = std::make_shared<GpuProfiler>();
+            const std::string outputPath = FindCommandLineOption( argc, argv, "gpu-profile" );
+            if ( !outputPath.empty() )
+                gpuProfiler->SetOutputFile( outputPath );
+        }
+        // GPU frame times of the benchmark.
+        if ( benchmark.IsEnabled() && !gpuProfiler )
+            gpuProfiler = std::make_shared<GpuProfiler>();
+
+        tracePath = FindCommandLineOption( argc, argv, "trace" );
+        if ( !tracePath.empty() )
+        {
+            if ( !IsTracingCompiledIn() )
+                std::cerr << "--trace: Tracing is not compiled in, configure with -DSVK_ENABLE_TRACING=ON." << std::endl;
+            SVK_TRACE_THREAD_NAME( "main" );
+            StartTracing();
+        }
+    }
+
+
     virtual void Init(
         const uint32_t width,
         const uint32_t height,
@@ -23,7 +80,15 @@ public:
         const std::vector<const char*>& deviceExtensions
     )
     {
-        InitWindow( width, height, appName );
+        this->appName = appName;
+        if ( benchmark.IsEnabled() )
+        {
+            InitWindow( benchmark.Width(), benchmark.Height(), appName );
+        }
+        else
+        {
+            InitWindow( width, height, appName );
+        }
         InitVulkan( appName, validationLayers, deviceExtensions );
     }
 
@@ -33,11 +98,38 @@ public:
         const uint32_t height,
         const std::string& appName )
     {
+        if ( isHeadless )
+        {
+            InputEvent event;
+            event.type = InputEventType::FramebufferSize;
+            event.x = width;
+            event.y = height;
+            input.Apply( event );
+            return;
+        }
+
         glfwInit();
         glfwWindowHint( GLFW_CLIENT_API, GLFW_NO_API );
+        // Benchmarks run at a fixed resolution.
+        glfwWindowHint( GLFW_RESIZABLE, benchmark.IsEnabled() ? GLFW_FALSE : GLFW_TRUE );
         window = glfwCreateWindow( width, height, appName.c_str(), nullptr, nullptr );
         glfwSetWindowUserPointer( window, this );
         glfwSetFramebufferSizeCallback( window, ApplicationBaseResizeCallback );
+        glfwSetKeyCallback( window, ApplicationBaseKeyCallback );
+        glfwSetMouseButtonCallback( window, ApplicationBaseMouseButtonCallback );
+        glfwSetCursorPosCallback( window, ApplicationBaseCursorPosCallback );
+
+        // Initial state, as events only report changes.
+        InputEvent event;
+        event.type = InputEventType::CursorPos;
+        glfwGetCursorPos( window, &event.x, &event.y );
+        input.Apply( event );
+        int framebufferWidth = 0, framebufferHeight = 0;
+        glfwGetFramebufferSize( window, &framebufferWidth, &framebufferHeight );
+        event.type = InputEventType::FramebufferSize;
+        event.x = framebufferWidth;
+        event.y = framebufferHeight;
+        input.Apply( event );
     }
 
 
@@ -52,6 +144,8 @@ public:
         commandPool.reset( new CommandPool( context.GraphicsFamily().value() ) );
         InitAppResources();
         swapchain.reset( new SwapChain() );
+        swapchain->SetFramebufferSize( uint32_t( input.FramebufferWidth() ), uint32_t( input.FramebufferHeight() ) );
+        swapchain->SetProfiler( gpuProfiler );
         InitSwapChain();
     }
 
@@ -67,13 +161,82 @@ public:
     virtual void MainLoop()
     {
         const auto device = theVulkanContext().LogicalDevice();
-        while ( !glfwWindowShouldClose( window ) )
+        frameLimiter = FrameLimiter( theVulkanContext().GetPresentPolicy().maxFrameRate );
+
+        // On the calling thread, without waiting for events.
+        if ( benchmark.IsEnabled() )
         {
-            glfwPollEvents();
-            UpdateFrameData();
-            swapchain->DrawFrame();
+            benchmark.Run( [this]
+            {
+                if ( window != nullptr )
+                    glfwPollEvents();
+                RenderFrame();
+            }, gpuProfiler.get() );
+            benchmark.Report( appName );
+            return;
+        }
+
+        if ( !useRenderThread )
+        {
+            while ( !glfwWindowShouldClose( window ) )
+            {
+                if ( swapchain->IsMinimized() )
+                    glfwWaitEvents();
+                else
+                    glfwPollEvents();
+                RenderFrame();
+            }
+            vkDeviceWaitIdle( device );
+            if ( gpuProfiler )
+                std::cout << std::endl;
+            return;
         }
+
+        isRendering = true;
+        renderException = nullptr;
+        std::thread renderThread( [this] { SVK_TRACE_THREAD_NAME( "render" ); RenderLoop(); } );
+
+        while ( !glfwWindowShouldClose( window ) && isRendering )
+            glfwWaitEvents();
+
+        isRendering = false;
+        renderThread.join();
         vkDeviceWaitIdle( device );
+        if ( gpuProfiler )
+            std::cout << std::endl;
+
+        if ( renderException )
+            std::rethrow_exception( renderException );
+    }
+
+
+    // Applies pending input, then updates and draws one frame. Called on the render thread.
+    virtual void RenderFrame()
+    {
+        SVK_TRACE_SCOPE( "RenderFrame" );
+
+        // Before input is polled, so that waiting does not add to input latency.
+        {
+            SVK_TRACE_SCOPE( "FrameLimiter" );
+            frameLimiter.Wait();
+        }
+        AdvanceFrameClock();
+        PollInput();
+
+        if ( swapchain->IsMinimized() )
+            return;
+        {
+            SVK_TRACE_SCOPE( "UpdateFrameData" );
+            UpdateFrameData();
+        }
+        swapchain->DrawFrame();
+
+        // GPU times stay on one console line, rewritten once a second.
+        if ( gpuProfiler && !benchmark.IsEnabled() && std::chrono::steady_clock::now() - lastProfileReport > std::chrono::seconds( 1 ) )
+        {
+            lastProfileReport = std::chrono::steady_clock::now();
+            std::cout << "\r" << gpuProfiler->SummaryLine() << "    " << std::flush;
+        }
     }
 
 
@@ -83,14 +246,32 @@ public:
     }
 
 
+    // Called on the render thread for each window event, before UpdateFrameData of the frame.
+    virtual void OnInputEvent( const InputEvent& event )
+    {
+        return;
+    }
+
+
     virtual void Destroy()
     {
+        if ( !tracePath.empty() )
+        {
+            StopTracing();
+            WriteTraceFile( tracePath );
+        }
         swapchain.reset();
+        if ( gpuProfiler )
+            gpuProfiler->Clear();
         DestroyAppResources();
         commandPool.reset();
         theVulkanContext().Destroy();
-        glfwDestroyWindow(window);
-        glfwTerminate();
+        if ( window != nullptr )
+        {
+            glfwDestroyWindow(window);
+            glfwTerminate();
+            window = nullptr;
+        }
     }
 
 
@@ -102,14 +283,158 @@ public:
 
     static void ApplicationBaseResizeCallback( GLFWwindow* window, int width, int height )
     {
-        auto app = reinterpret_cast<ApplicationBase*>( glfwGetWindowUserPointer( window ) );
-        app->swapchain->SetResizeFlag();
+        InputEvent event;
+        event.type = InputEventType::FramebufferSize;
+        event.x = width;
+        event.y = height;
+        PushInputEvent( window, event );
+    }
+
+
+    static void ApplicationBaseKeyCallback( GLFWwindow* window, int key, int scancode, int action, int mods )
+    {
+        InputEvent event;
+        event.type = InputEventType::Key;
+        event.code = key;
+        event.action = action;
+        event.mods = mods;
+        PushInputEvent( window, event );
     }
 
+
+    static void ApplicationBaseMouseButtonCallback( GLFWwindow* window, int button, int action, int mods )
+    {
+        InputEvent event;
+        event.type = InputEventType::MouseButton;
+        event.code = button;
+        event.action = action;
+        event.mods = mods;
+        glfwGetCursorPos( window, &event.x, &event.y );
+        PushInputEvent( window, event );
+    }
+
+
+    static void ApplicationBaseCursorPosCallback( GLFWwindow* window, double xpos, double ypos )
+    {
+        InputEvent event;
+        event.type = InputEventType::CursorPos;
+        event.x = xpos;
+        event.y = ypos;
+        PushInputEvent( window, event );
+    }
+
+
 protected:
+
+    // Seconds since the first frame, at the start of the current frame.
+    double FrameTime() const { return frameTime; }
+    // Seconds since the first frame, now. Same as FrameTime with a fixed frame clock.
+    double ClockTime() const
+    {
+        if ( HasFixedFrameClock() )
+            return frameTime;
+        return std::chrono::duration<double>( std::chrono::steady_clock::now() - clockStart ).count();
+    }
+    // Seconds from the start of the previous frame to the current one, 0 on the first frame.
+    float FrameDeltaTime() const { return frameDeltaTime; }
+    // The frame clock advances by a fixed step per frame, e.g. in benchmarks.
+    // Simulations should then not run on a thread, see FixedStepSimulation::Advance.
+    bool HasFixedFrameClock() const { return benchmark.IsEnabled(); }
+
+    // Applies the input events received so far to the input state and passes them to OnInputEvent.
+    // Called at the start of each frame; call again from LatchRenderEntry to latch the latest input.
+    void PollInput()
+    {
+        SVK_TRACE_SCOPE( "PollInput" );
+
+        InputEvent event;
+        while ( inputQueue.Pop( event ) )
+        {
+            input.Apply( event );
+            if ( event.type == InputEventType::FramebufferSize )
+            {
+                swapchain->SetFramebufferSize( uint32_t( event.x ), uint32_t( event.y ) );
+                swapchain->SetResizeFlag();
+            }
+            OnInputEvent( event );
+        }
+    }
+
+
+    void AdvanceFrameClock()
+    {
+        if ( HasFixedFrameClock() )
+        {
+            frameDeltaTime = ( frameIndex > 0 ) ? float( benchmark.FrameSeconds() ) : 0.0f;
+            frameTime = frameIndex * benchmark.FrameSeconds();
+        }
+        else
+        {
+            const auto now = std::chrono::steady_clock::now();
+            if ( frameIndex == 0 )
+                clockStart = now;
+            const double time = std::chrono::duration<double>( now - clockStart ).count();
+            frameDeltaTime = float( time - frameTime );
+            frameTime = time;
+        }
+        ++frameIndex;
+    }
+
+
+    void RenderLoop()
+    {
+        try
+        {
+            while ( isRendering )
+            {
+                RenderFrame();
+                // Nothing to draw while minimized, wait for the restore event.
+                if ( swapchain->IsMinimized() )
+                    std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+            }
+        }
+        catch ( ... )
+        {
+            renderException = std::current_exception();
+        }
+        isRendering = false;
+        glfwPostEmptyEvent();
+    }
+
+
+    // Events are dropped if the render thread falls a full queue behind.
+    static void PushInputEvent( GLFWwindow* window, const InputEvent& event )
+    {
+        auto app = reinterpret_cast<ApplicationBase*>( glfwGetWindowUserPointer( window ) );
+        app->inputQueue.Push( event );
+    }
+
     GLFWwindow* window = nullptr;
     std::shared_ptr<SwapChain> swapchain;
     std::shared_ptr<CommandPool> commandPool;
+    // Null unless enabled on the command line.
+    std::shared_ptr<GpuProfiler> gpuProfiler;
+
+    // If false, MainLoop pumps events and renders on the calling thread.
+    bool useRenderThread = true;
+    // Input state of the render thread, after the events applied so far.
+    InputState input;
+
+private:
+    std::string appName;
+    FrameBenchmark benchmark;
+    bool isHeadless = false;
+    FrameLimiter frameLimiter;
+    // Frame clock.
+    std::chrono::steady_clock::time_point clockStart;
+    uint64_t frameIndex = 0;
+    double frameTime = 0.0;
+    float frameDeltaTime = 0.0f;
+    std::chrono::steady_clock::time_point lastProfileReport;
+    std::string tracePath;
+    InputQueue inputQueue;
+    std::atomic<bool> isRendering{ false };
+    std::exception_ptr renderException;
 
 
 };
@@ -0,0 +1,94 @@
+#include "Buffer.h"
+
+#include "VulkanBase.h"
+#include "VulkanContext.h"
+#include "CommandPool.h"
+#include "Trace.h"
+
+#include <cstring>
+#include <stdexcept>
+
+
+namespace svk {
+
+
+Buffer::Buffer( const VkDeviceSize size, const VkBufferUsageFlags usage, const VkMemoryPropertyFlags memoryUsage )
+{
+    Reset( size, usage, memoryUsage );
+}
+
+
+Buffer::~Buffer()
+{
+    Clear();
+}
+
+
+void Buffer::Reset( const VkDeviceSize size, const VkBufferUsageFlags usage, const VkMemoryPropertyFlags memoryUsage )
+{
+    const auto device = theVulkanContext().LogicalDevice();
+
+    Clear();
+    if ( size == 0 )
+        throw std::runtime_error( "Buffer: Buffer has zero size." );
+
+    this->size = size;
+    createBuffer( size, usage, memoryUsage, buffer, deviceMemory );
+    info = { buffer, 0, size };
+
+    if ( memoryUsage & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT )
+    {
+        if ( vkMapMemory( device, deviceMemory, 0, size, 0, &mapped ) != VK_SUCCESS )
+            throw std::runtime_error( "Buffer: Failed to map buffer memory." );
+    }
+}
+
+
+void Buffer::Clear()
+{
+    const auto device = theVulkanContext().LogicalDevice();
+
+    if ( buffer != VK_NULL_HANDLE )
+        vkDestroyBuffer( device, buffer, nullptr );
+    if ( deviceMemory != VK_NULL_HANDLE )
+        vkFreeMemory( device, deviceMemory, nullptr );
+
+    size = 0;
+    buffer = VK_NULL_HANDLE;
+    deviceMemory = VK_NULL_HANDLE;
+    info = { VK_NULL_HANDLE, 0, 0 };
+    mapped = nullptr;
+}
+
+
+void Buffer::Upload( const CommandPool& commandPool, const void* data, const VkDeviceSize size, const VkDeviceSize offset )
+{
+    SVK_TRACE_SCOPE( "Buffer::Upload" );
+
+    const auto device = theVulkanContext().LogicalDevice();
+
+    if ( offset + size > this->size )
+        throw std::runtime_error( "Buffer: Upload is out of buffer range." );
+    if ( size == 0 )
+        return;
+
+    if ( mapped != nullptr )
+    {
+        memcpy( static_cast<char*>( mapped ) + offset, data, size );
+        return;
+    }
+
+    VkBuffer stagingBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory stagingBufferMemory = VK_NULL_HANDLE;
+    void* stagingData = nullptr;
+    createBuffer( size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory );
+    vkMapMemory( device, stagingBufferMemory, 0, size, 0, &stagingData );
+    memcpy( stagingData, data, size );
+    vkUnmapMemory( device, stagingBufferMemory );
+    copyBuffer( commandPool, stagingBuffer, buffer, size, offset );
+    vkDestroyBuffer( device, stagingBuffer, nullptr );
+    vkFreeMemory( device, stagingBufferMemory, nullptr );
+}
+
+
+} // namespace svk
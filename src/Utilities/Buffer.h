@@ -0,0 +1,66 @@
+#ifndef SVK_BUFFER_H
+#define SVK_BUFFER_H
+
+#include <vulkan/vulkan.h>
+
+
+namespace svk {
+
+
+class CommandPool;
+
+
+// Buffer with its own memory, e.g. a storage buffer shared by compute and graphics pipelines.
+class Buffer
+{
+public:
+
+    Buffer( const Buffer& ) = delete;
+
+    Buffer() = default;
+
+    Buffer(
+        const VkDeviceSize size,
+        const VkBufferUsageFlags usage,
+        const VkMemoryPropertyFlags memoryUsage = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+    );
+
+    ~Buffer();
+
+
+    void Reset(
+        const VkDeviceSize size,
+        const VkBufferUsageFlags usage,
+        const VkMemoryPropertyFlags memoryUsage = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+    );
+
+    void Clear();
+
+
+    // Host-visible (and coherent) buffers are written through the persistent mapping,
+    // device-local ones through a staging buffer (usage must include TRANSFER_DST).
+    void Upload( const CommandPool& commandPool, const void* data, const VkDeviceSize size, const VkDeviceSize offset = 0 );
+
+
+    VkDeviceSize Size() const { return size; }
+
+    const VkBuffer& Handle() const { return buffer; }
+    const VkDeviceMemory& DeviceMemory() const { return deviceMemory; }
+    const VkDescriptorBufferInfo& Info() const { return info; }
+
+    // Null for device-local buffers.
+    void* Mapped() const { return mapped; }
+
+
+private:
+    VkDeviceSize size = 0;
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceMemory deviceMemory = VK_NULL_HANDLE;
+    VkDescriptorBufferInfo info = { VK_NULL_HANDLE, 0, 0 };
+    void* mapped = nullptr;
+};
+
+
+} // namespace svk
+
+#endif // SVK_BUFFER_H
@@ -0,0 +1,34 @@
+#include "CommandLine.h"
+
+
+namespace svk {
+
+
+std::string FindCommandLineOption( int argc, char** argv, const std::string& key )
+{
+    const std::string prefix = "--" + key + "=";
+    std::string value;
+    for ( int i = 1; i < argc; ++i )
+    {
+        const std::string arg = argv[i];
+        if ( arg.rfind( prefix, 0 ) == 0 )
+            value = arg.substr( prefix.size() );
+    }
+    return value;
+}
+
+
+bool HasCommandLineOption( int argc, char** argv, const std::string& key )
+{
+    const std::string flag = "--" + key;
+    for ( int i = 1; i < argc; ++i )
+    {
+        const std::string arg = argv[i];
+        if ( arg == flag || arg.rfind( flag + "=", 0 ) == 0 )
+            return true;
+    }
+    return false;
+}
+
+
+} // namespace svk
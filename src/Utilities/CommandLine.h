@@ -0,0 +1,19 @@
+#ifndef SVK_COMMANDLINE_H
+#define SVK_COMMANDLINE_H
+
+#include <string>
+
+
+namespace svk {
+
+
+// Value of the last option --key=value, or an empty string if it is not given.
+std::string FindCommandLineOption( int argc, char** argv, const std::string& key );
+
+// True if --key or --key=value is given.
+bool HasCommandLineOption( int argc, char** argv, const std::string& key );
+
+
+} // namespace svk
+
+#endif // SVK_COMMANDLINE_H
@@ -1,5 +1,6 @@
 #include "CommandPool.h"
 #include "VulkanContext.h"
+#include "Trace.h"
 #include <stdexcept>
 
 
@@ -25,6 +26,8 @@ void CommandPool::Reset( const uint32_t familyIndex )
     VkCommandPoolCreateInfo poolInfo {};
     poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
     poolInfo.queueFamilyIndex = familyIndex;
+    // Swap chain command buffers are re-recorded every frame.
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
     if ( vkCreateCommandPool( device, &poolInfo, nullptr, &commandPool ) != VK_SUCCESS )
         throw std::runtime_error( "failed to create command pool!" );
 }
@@ -41,6 +44,8 @@ void CommandPool::Clear()
 
 VkCommandBuffer CommandPool::CreateCommandBuffer() const
 {
+    SVK_TRACE_SCOPE( "CommandPool::CreateCommandBuffer" );
+
     const auto device = theVulkanContext().LogicalDevice();
 
     VkCommandBufferAllocateInfo allocInfo{};
@@ -58,6 +63,8 @@ VkCommandBuffer CommandPool::CreateCommandBuffer() const
 
 void CommandPool::FreeCommandBuffer( VkCommandBuffer& commandBuffer ) const
 {
+    SVK_TRACE_SCOPE( "CommandPool::FreeCommandBuffer" );
+
     const auto device = theVulkanContext().LogicalDevice();
     if ( commandBuffer != VK_NULL_HANDLE )
         vkFreeCommandBuffers( device, commandPool, 1, &commandBuffer );
@@ -67,6 +74,8 @@ void CommandPool::FreeCommandBuffer( VkCommandBuffer& commandBuffer ) const
 
 void CommandPool::BeginCommandBuffer( const VkCommandBuffer commandBuffer, const bool isSingleUse )
 {
+    SVK_TRACE_SCOPE( "CommandPool::BeginCommandBuffer" );
+
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     beginInfo.flags = 0;
@@ -81,6 +90,8 @@ void CommandPool::BeginCommandBuffer( const VkCommandBuffer commandBuffer, const
 
 void CommandPool::EndCommandBuffer( const VkCommandBuffer commandBuffer )
 {
+    SVK_TRACE_SCOPE( "CommandPool::EndCommandBuffer" );
+
     if ( vkEndCommandBuffer( commandBuffer ) != VK_SUCCESS )
         throw std::runtime_error( "CommandPool: Failed to end command buffer." );
 }
@@ -0,0 +1,172 @@
+#include "ComputePipeline.h"
+
+#include "VulkanBase.h"
+#include "VulkanContext.h"
+
+#include <stdexcept>
+
+
+namespace svk {
+
+
+ComputePipeline::ComputePipeline( const std::string& shaderPath, const std::vector<VkDescriptorSetLayoutBinding>& bindings, const uint32_t pushConstantSize, const uint32_t numDescriptorSets, const VkPipelineCache pipelineCache )
+{
+    Reset( shaderPath, bindings, pushConstantSize, numDescriptorSets, pipelineCache );
+}
+
+
+ComputePipeline::~ComputePipeline()
+{
+    Clear();
+}
+
+
+void ComputePipeline::Reset( const std::string& shaderPath, const std::vector<VkDescriptorSetLayoutBinding>& bindings, const uint32_t pushConstantSize, const uint32_t numDescriptorSets, const VkPipelineCache pipelineCache )
+{
+    const auto device = theVulkanContext().LogicalDevice();
+
+    // Dispatches are recorded into graphics command buffers.
+    if ( !theVulkanContext().ComputeFamily().has_value() )
+        throw std::runtime_error( "ComputePipeline: The graphics queue family does not support compute." );
+
+    Clear();
+    this->pushConstantSize = pushConstantSize;
+
+    // Descriptor set layout.
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>( bindings.size() );
+    layoutInfo.pBindings = bindings.data();
+
+    if ( vkCreateDescriptorSetLayout( device, &layoutInfo, nullptr, &descriptorSetLayout ) != VK_SUCCESS )
+        throw std::runtime_error( "ComputePipeline: Failed to create descriptor set layout." );
+
+    // Pipeline layout.
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = pushConstantSize;
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+    if ( pushConstantSize > 0 )
+    {
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    }
+
+    if ( vkCreatePipelineLayout( device, &pipelineLayoutInfo, nullptr, &pipelineLayout ) != VK_SUCCESS )
+        throw std::runtime_error( "ComputePipeline: Failed to create pipeline layout." );
+
+    // Pipeline.
+    const auto shaderCode = LoadShaderCode( shaderPath );
+    VkShaderModule shaderModule = CreateShaderModule( device, shaderCode );
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = shaderModule;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.layout = pipelineLayout;
+
+    const VkResult result = vkCreateComputePipelines( device, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline );
+    vkDestroyShaderModule( device, shaderModule, nullptr );
+    if ( result != VK_SUCCESS )
+        throw std::runtime_error( "ComputePipeline: Failed to create compute pipeline: " + shaderPath );
+
+    // Descriptor sets.
+    if ( bindings.empty() || numDescriptorSets == 0 )
+        return;
+
+    std::vector<VkDescriptorPoolSize> poolSizes( bindings.size() );
+    for ( size_t i = 0; i < bindings.size(); ++i )
+    {
+        poolSizes[i].type = bindings[i].descriptorType;
+        poolSizes[i].descriptorCount = bindings[i].descriptorCount * numDescriptorSets;
+    }
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = static_cast<uint32_t>( poolSizes.size() );
+    poolInfo.pPoolSizes = poolSizes.data();
+    poolInfo.maxSets = numDescriptorSets;
+
+    if ( vkCreateDescriptorPool( device, &poolInfo, nullptr, &descriptorPool ) != VK_SUCCESS )
+        throw std::runtime_error( "ComputePipeline: Failed to create descriptor pool." );
+
+    std::vector<VkDescriptorSetLayout> layouts( numDescriptorSets, descriptorSetLayout );
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = numDescriptorSets;
+    allocInfo.pSetLayouts = layouts.data();
+
+    descriptorSets.resize( numDescriptorSets );
+    if ( vkAllocateDescriptorSets( device, &allocInfo, descriptorSets.data() ) != VK_SUCCESS )
+        throw std::runtime_error( "ComputePipeline: Failed to allocate descriptor sets." );
+}
+
+
+void ComputePipeline::Clear()
+{
+    const auto device = theVulkanContext().LogicalDevice();
+
+    if ( descriptorPool != VK_NULL_HANDLE )
+        vkDestroyDescriptorPool( device, descriptorPool, nullptr );
+    if ( pipeline != VK_NULL_HANDLE )
+        vkDestroyPipeline( device, pipeline, nullptr );
+    if ( pipelineLayout != VK_NULL_HANDLE )
+        vkDestroyPipelineLayout( device, pipelineLayout, nullptr );
+    if ( descriptorSetLayout != VK_NULL_HANDLE )
+        vkDestroyDescriptorSetLayout( device, descriptorSetLayout, nullptr );
+
+    pushConstantSize = 0;
+    descriptorSetLayout = VK_NULL_HANDLE;
+    pipelineLayout = VK_NULL_HANDLE;
+    pipeline = VK_NULL_HANDLE;
+    descriptorPool = VK_NULL_HANDLE;
+    descriptorSets.clear();
+}
+
+
+void ComputePipeline::UpdateDescriptorSet( const uint32_t setIndex, std::vector<VkWriteDescriptorSet> descriptorWrites ) const
+{
+    const auto device = theVulkanContext().LogicalDevice();
+
+    for ( auto& write : descriptorWrites )
+    {
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = descriptorSets.at( setIndex );
+    }
+    vkUpdateDescriptorSets( device, static_cast<uint32_t>( descriptorWrites.size() ), descriptorWrites.data(), 0, nullptr );
+}
+
+
+void ComputePipeline::Bind( const VkCommandBuffer commandBuffer, const uint32_t setIndex ) const
+{
+    vkCmdBindPipeline( commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline );
+    if ( !descriptorSets.empty() )
+        vkCmdBindDescriptorSets( commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSets.at( setIndex ), 0, nullptr );
+}
+
+
+void ComputePipeline::PushConstants( const VkCommandBuffer commandBuffer, const void* data, const uint32_t size ) const
+{
+    if ( size > pushConstantSize )
+        throw std::runtime_error( "ComputePipeline: Push constants exceed the declared size." );
+    vkCmdPushConstants( commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, size, data );
+}
+
+
+void ComputePipeline::Dispatch( const VkCommandBuffer commandBuffer, const uint32_t groupCountX, const uint32_t groupCountY, const uint32_t groupCountZ ) const
+{
+    if ( groupCountX == 0 || groupCountY == 0 || groupCountZ == 0 )
+        return;
+    vkCmdDispatch( commandBuffer, groupCountX, groupCountY, groupCountZ );
+}
+
+
+} // namespace svk
@@ -0,0 +1,84 @@
+#ifndef SVK_COMPUTEPIPELINE_H
+#define SVK_COMPUTEPIPELINE_H
+
+#include <vulkan/vulkan.h>
+#include <string>
+#include <vector>
+
+
+namespace svk {
+
+
+// Compute shader with its own descriptor set layout, given by the app in the same form
+// as RenderEntryManager::getDescriptorBindings, and a pool of descriptor sets for it.
+// Typical use, e.g. from RenderEntryManager::RecordPreRenderPassCommands:
+//     pipeline.Bind( commandBuffer, swapEntryIndex );
+//     pipeline.PushConstants( commandBuffer, &params, sizeof(params) );
+//     pipeline.Dispatch( commandBuffer, ComputePipeline::GroupCount( numItems, 64 ) );
+//     cmdBufferBarrier( ... ) before the results are consumed.
+class ComputePipeline
+{
+public:
+
+    ComputePipeline( const ComputePipeline& ) = delete;
+
+    ComputePipeline() = default;
+
+    ComputePipeline(
+        const std::string& shaderPath,
+        const std::vector<VkDescriptorSetLayoutBinding>& bindings,
+        const uint32_t pushConstantSize = 0,
+        const uint32_t numDescriptorSets = 1,
+        const VkPipelineCache pipelineCache = VK_NULL_HANDLE
+    );
+
+    ~ComputePipeline();
+
+
+    void Reset(
+        const std::string& shaderPath,
+        const std::vector<VkDescriptorSetLayoutBinding>& bindings,
+        const uint32_t pushConstantSize = 0,
+        const uint32_t numDescriptorSets = 1,
+        const VkPipelineCache pipelineCache = VK_NULL_HANDLE
+    );
+
+    void Clear();
+
+
+    // Writes resources to a descriptor set. dstSet of the writes is filled in here.
+    void UpdateDescriptorSet( const uint32_t setIndex, std::vector<VkWriteDescriptorSet> descriptorWrites ) const;
+
+    void Bind( const VkCommandBuffer commandBuffer, const uint32_t setIndex = 0 ) const;
+
+    void PushConstants( const VkCommandBuffer commandBuffer, const void* data, const uint32_t size ) const;
+
+    void Dispatch( const VkCommandBuffer commandBuffer, const uint32_t groupCountX, const uint32_t groupCountY = 1, const uint32_t groupCountZ = 1 ) const;
+
+    // Number of workgroups to cover numInvocations.
+    static uint32_t GroupCount( const uint32_t numInvocations, const uint32_t groupSize )
+    {
+        return ( numInvocations + groupSize - 1 ) / groupSize;
+    }
+
+
+    VkPipeline Handle() const { return pipeline; }
+    VkPipelineLayout Layout() const { return pipelineLayout; }
+    VkDescriptorSetLayout DescriptorSetLayout() const { return descriptorSetLayout; }
+    VkDescriptorSet DescriptorSet( const uint32_t setIndex ) const { return descriptorSets.at( setIndex ); }
+    uint32_t NumDescriptorSets() const { return static_cast<uint32_t>( descriptorSets.size() ); }
+
+
+private:
+    uint32_t pushConstantSize = 0;
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    std::vector<VkDescriptorSet> descriptorSets;
+};
+
+
+} // namespace svk
+
+#endif // SVK_COMPUTEPIPELINE_H
@@ -0,0 +1,204 @@
+#ifndef SVK_FIXEDSTEPSIMULATION_H
+#define SVK_FIXEDSTEPSIMULATION_H
+
+#include "Trace.h"
+#include "TripleBuffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace svk {
+
+
+// Steps an app state at a fixed rate, independent of the frame rate.
+// With a thread, steps run on their own thread, and each step publishes the last two states
+// through a TripleBuffer; otherwise the steps that are due are run inside Sample().
+// Either way, the renderer draws Previous() and Current() blended by the factor Sample() returns,
+// so motion is smooth at any frame rate, one step behind the simulation.
+//
+//     simulation.Start( initialState, 1.0f / 120.0f, []( State& state, const float dt ) { ... } );
+//     const float alpha = simulation.Sample();
+//     draw( mix( simulation.Previous(), simulation.Current(), alpha ) );
+template< typename State >
+class FixedStepSimulation
+{
+public:
+    using StepFunction = std::function<void( State& state, const float deltaTime )>;
+    using Command = std::function<void( State& state )>;
+
+    FixedStepSimulation() = default;
+
+    FixedStepSimulation( const FixedStepSimulation& ) = delete;
+
+    ~FixedStepSimulation()
+    {
+        Stop();
+    }
+
+
+    void Start( const State& initialState, const float stepSeconds, StepFunction step, const bool useThread = true )
+    {
+        Stop();
+
+        this->stepSeconds = stepSeconds;
+        this->step = std::move( step );
+        state = initialState;
+        previous = initialState;
+        current = initialState;
+        accumulator = 0.0;
+        lastSampleTime = Clock::now();
+
+        auto& snapshot = snapshots.WriteBuffer();
+        snapshot.previous = initialState;
+        snapshot.current = initialState;
+        snapshot.time = lastSampleTime;
+        snapshots.Publish();
+        snapshots.Update();
+
+        if ( useThread )
+        {
+            isRunning = true;
+            thread = std::thread( [this] { ThreadLoop(); } );
+        }
+    }
+
+
+    void Stop()
+    {
+        if ( !thread.joinable() )
+            return;
+        isRunning = false;
+        thread.join();
+    }
+
+
+    // Runs command on the simulation state before the next step, e.g. to apply input.
+    void Post( Command command )
+    {
+        std::lock_guard<std::mutex> lock( commandMutex );
+        commands.push_back( std::move( command ) );
+    }
+
+
+    // Picks up the latest states and returns the blend factor in [0,1] from Previous() to Current() for now.
+    // Previous() and Current() stay valid until the next call.
+    float Sample()
+    {
+        const auto now = Clock::now();
+
+        if ( thread.joinable() )
+        {
+            snapshots.Update();
+            const auto& snapshot = snapshots.ReadBuffer();
+            const double sinceStep = std::chrono::duration<double>( now - snapshot.time ).count();
+            return float( std::min( std::max( sinceStep / stepSeconds, 0.0 ), 1.0 ) );
+        }
+
+        const double elapsedSeconds = std::chrono::duration<double>( now - lastSampleTime ).count();
+        lastSampleTime = now;
+        return Advance( elapsedSeconds );
+    }
+
+    // Inline stepping by elapsedSeconds instead of the clock, e.g. by a fixed frame time for repeatable runs.
+    // Returns the blend factor like Sample(). Only without a thread.
+    float Advance( const double elapsedSeconds )
+    {
+        // Long stalls are not caught up, to avoid a spiral of ever longer frames.
+        accumulator += elapsedSeconds;
+        accumulator = std::min( accumulator, MaxStepsPerSample * double( stepSeconds ) );
+        while ( accumulator >= stepSeconds )
+        {
+            SVK_TRACE_SCOPE( "SimulationStep" );
+            previous = current;
+            RunCommands( current );
+            step( current, stepSeconds );
+            accumulator -= stepSeconds;
+        }
+        return float( accumulator / stepSeconds );
+    }
+
+    const State& Previous() const { return thread.joinable() ? snapshots.ReadBuffer().previous : previous; }
+    const State& Current() const { return thread.joinable() ? snapshots.ReadBuffer().current : current; }
+
+    float StepSeconds() const { return stepSeconds; }
+
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Snapshot
+    {
+        State previous;
+        State current;
+        Clock::time_point time; // When current was reached.
+    };
+
+    static constexpr int MaxStepsPerSample = 8;
+
+    void RunCommands( State& target )
+    {
+        std::vector<Command> pending;
+        {
+            std::lock_guard<std::mutex> lock( commandMutex );
+            pending.swap( commands );
+        }
+        for ( auto& command : pending )
+            command( target );
+    }
+
+    void ThreadLoop()
+    {
+        const auto stepDuration = std::chrono::duration_cast<Clock::duration>( std::chrono::duration<double>( stepSeconds ) );
+        auto nextStepTime = Clock::now() + stepDuration;
+        SVK_TRACE_THREAD_NAME( "simulation" );
+
+        while ( isRunning )
+        {
+            std::this_thread::sleep_until( nextStepTime );
+
+            SVK_TRACE_SCOPE( "SimulationStep" );
+            auto& snapshot = snapshots.WriteBuffer();
+            snapshot.previous = state;
+            RunCommands( state );
+            step( state, stepSeconds );
+            snapshot.current = state;
+            snapshot.time = nextStepTime;
+            snapshots.Publish();
+
+            // Skip steps after a long stall instead of running them back to back.
+            nextStepTime += stepDuration;
+            const auto now = Clock::now();
+            if ( now > nextStepTime + MaxStepsPerSample * stepDuration )
+                nextStepTime = now;
+        }
+    }
+
+    float stepSeconds = 1.0f / 120.0f;
+    StepFunction step;
+
+    // Simulation thread.
+    std::thread thread;
+    std::atomic<bool> isRunning{ false };
+    State state;
+    TripleBuffer<Snapshot> snapshots;
+
+    // Inline stepping.
+    State previous;
+    State current;
+    double accumulator = 0.0;
+    Clock::time_point lastSampleTime;
+
+    std::mutex commandMutex;
+    std::vector<Command> commands;
+};
+
+
+} // namespace svk
+
+#endif // SVK_FIXEDSTEPSIMULATION_H
@@ -0,0 +1,300 @@
+#include "FrameBenchmark.h"
+
+#include "CommandLine.h"
+#include "GpuProfiler.h"
+#include "ReportFormat.h"
+#include "VulkanContext.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+
+namespace svk {
+
+
+namespace {
+
+
+FrameTimeStats Summarize( std::vector<double> milliseconds )
+{
+    FrameTimeStats stats;
+    if ( milliseconds.empty() )
+        return stats;
+
+    std::sort( milliseconds.begin(), milliseconds.end() );
+    stats.numSamples = milliseconds.size();
+    for ( const double value : milliseconds )
+        stats.averageMs += value;
+    stats.averageMs /= milliseconds.size();
+    stats.p50Ms = Percentile( milliseconds, 0.50 );
+    stats.p95Ms = Percentile( milliseconds, 0.95 );
+    stats.p99Ms = Percentile( milliseconds, 0.99 );
+    stats.maxMs = milliseconds.back();
+    return stats;
+}
+
+
+std::string StatsJson( const FrameTimeStats& stats )
+{
+    std::ostringstream json;
+    json << std::fixed << std::setprecision( 4 )
+        << "{ \"samples\": " << stats.numSamples
+        << ", \"mean\": " << stats.averageMs
+        << ", \"p50\": " << stats.p50Ms
+        << ", \"p95\": " << stats.p95Ms
+        << ", \"p99\": " << stats.p99Ms
+        << ", \"max\": " << stats.maxMs << " }";
+    return json.str();
+}
+
+
+// Number "key" of the object "object" (top level if empty), in the JSON written by FrameBenchmark. NaN if missing.
+double FindJsonNumber( const std::string& json, const std::string& object, const std::string& key )
+{
+    size_t begin = 0;
+    size_t end = json.size();
+    if ( !object.empty() )
+    {
+        begin = json.find( "\"" + object + "\":" );
+        if ( begin == std::string::npos )
+            return std::nan( "" );
+        end = json.find( '}', begin );
+    }
+
+    const std::string pattern = "\"" + key + "\":";
+    const size_t position = json.find( pattern, begin );
+    if ( position == std::string::npos || position > end )
+        return std::nan( "" );
+    return std::strtod( json.c_str() + position + pattern.size(), nullptr );
+}
+
+
+std::string FindJsonString( const std::string& json, const std::string& key )
+{
+    const std::string pattern = "\"" + key + "\": \"";
+    const size_t position = json.find( pattern );
+    if ( position == std::string::npos )
+        return {};
+    const size_t begin = position + pattern.size();
+    return json.substr( begin, json.find( '"', begin ) - begin );
+}
+
+
+void PrintStats( const std::string& name, const FrameTimeStats& stats )
+{
+    std::cout << "  " << std::left << std::setw( 10 ) << name << std::right
+        << " mean " << stats.averageMs
+        << " | p50 " << stats.p50Ms
+        << " | p95 " << stats.p95Ms
+        << " | p99 " << stats.p99Ms
+        << " | max " << stats.maxMs << " ms" << std::endl;
+}
+
+
+} // namespace
+
+
+FrameBenchmark FrameBenchmark::FromCommandLine( int argc, char** argv )
+{
+    FrameBenchmark benchmark;
+    if ( !HasCommandLineOption( argc, argv, "benchmark" ) )
+        return benchmark;
+
+    const std::string numFrames = FindCommandLineOption( argc, argv, "benchmark" );
+    benchmark.numFrames = numFrames.empty() ? 1000 : uint32_t( std::atoi( numFrames.c_str() ) );
+    if ( benchmark.numFrames == 0 )
+        throw std::runtime_error( "FrameBenchmark: --benchmark needs at least one frame." );
+
+    const std::string numWarmupFrames = FindCommandLineOption( argc, argv, "benchmark-warmup" );
+    if ( !numWarmupFrames.empty() )
+        benchmark.numWarmupFrames = uint32_t( std::atoi( numWarmupFrames.c_str() ) );
+
+    const std::string resolution = FindCommandLineOption( argc, argv, "benchmark-resolution" );
+    if ( !resolution.empty() )
+    {
+        unsigned int width = 0, height = 0;
+        if ( std::sscanf( resolution.c_str(), "%ux%u", &width, &height ) != 2 || width == 0 || height == 0 )
+            throw std::runtime_error( "FrameBenchmark: --benchmark-resolution must be WIDTHxHEIGHT, got " + resolution );
+        benchmark.width = width;
+        benchmark.height = height;
+    }
+
+    const std::string frameSeconds = FindCommandLineOption( argc, argv, "benchmark-frame-time" );
+    if ( !frameSeconds.empty() )
+        benchmark.frameSeconds = std::atof( frameSeconds.c_str() );
+
+    benchmark.outputPath = FindCommandLineOption( argc, argv, "benchmark-output" );
+    benchmark.baselinePath = FindCommandLineOption( argc, argv, "benchmark-baseline" );
+
+    const std::string tolerance = FindCommandLineOption( argc, argv, "benchmark-tolerance" );
+    if ( !tolerance.empty() )
+        benchmark.tolerance = std::atof( tolerance.c_str() );
+
+    return benchmark;
+}
+
+
+void FrameBenchmark::Run( const std::function<void()>& renderFrame, GpuProfiler* profiler )
+{
+    using Clock = std::chrono::steady_clock;
+
+    if ( profiler != nullptr )
+        profiler->SetHistorySize( numFrames );
+
+    for ( uint32_t i = 0; i < numWarmupFrames; ++i )
+        renderFrame();
+    if ( profiler != nullptr )
+        profiler->ResetStats();
+
+    // Time from the end of one frame to the end of the next, i.e. including waits for the GPU.
+    std::vector<double> milliseconds( numFrames );
+    const auto start = Clock::now();
+    auto frameEnd = start;
+    for ( uint32_t i = 0; i < numFrames; ++i )
+    {
+        renderFrame();
+        const auto now = Clock::now();
+        milliseconds[i] = std::chrono::duration<double, std::milli>( now - frameEnd ).count();
+        frameEnd = now;
+    }
+    framesPerSecond = numFrames / std::chrono::duration<double>( frameEnd - start ).count();
+
+    vkDeviceWaitIdle( theVulkanContext().LogicalDevice() );
+
+    cpuFrame = Summarize( milliseconds );
+    gpuFrame = FrameTimeStats();
+    if ( profiler != nullptr )
+    {
+        profiler->ReadBack();
+        for ( const auto& region : profiler->Stats() )
+        {
+            if ( region.name != "frame" )
+                continue;
+            gpuFrame.numSamples = region.numSamples;
+            gpuFrame.averageMs = region.averageMs;
+            gpuFrame.p50Ms = region.p50Ms;
+            gpuFrame.p95Ms = region.p95Ms;
+            gpuFrame.p99Ms = region.p99Ms;
+            gpuFrame.maxMs = region.maxMs;
+        }
+    }
+}
+
+
+void FrameBenchmark::Report( const std::string& appName ) const
+{
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties( theVulkanContext().PhysicalDevice(), &properties );
+
+    std::cout << std::fixed << std::setprecision( 3 );
+    std::cout << appName << " on " << properties.deviceName << ", " << width << "x" << height
+        << ", " << numFrames << " frames after " << numWarmupFrames << " warm-up frames" << std::endl;
+    PrintStats( "CPU frame", cpuFrame );
+    if ( gpuFrame.numSamples > 0 )
+        PrintStats( "GPU frame", gpuFrame );
+    std::cout << "  throughput " << framesPerSecond << " frames/s" << std::endl;
+    std::cout.unsetf( std::ios::floatfield );
+
+    if ( !outputPath.empty() )
+    {
+        std::ofstream file( outputPath );
+        if ( !file )
+            throw std::runtime_error( "FrameBenchmark: Failed to open " + outputPath );
+        file << toJson( appName, properties.deviceName );
+    }
+
+    if ( !baselinePath.empty() )
+        compareWithBaseline();
+}
+
+
+std::string FrameBenchmark::toJson( const std::string& appName, const std::string& deviceName ) const
+{
+    std::ostringstream json;
+    json << std::fixed << std::setprecision( 6 );
+    json << "{\n";
+    json << "  \"app\": " << JsonString( appName ) << ",\n";
+    json << "  \"device\": " << JsonString( deviceName ) << ",\n";
+    json << "  \"width\": " << width << ",\n";
+    json << "  \"height\": " << height << ",\n";
+    json << "  \"frames\": " << numFrames << ",\n";
+    json << "  \"warmupFrames\": " << numWarmupFrames << ",\n";
+    json << "  \"frameClockSeconds\": " << frameSeconds << ",\n";
+    json << "  \"framesPerSecond\": " << std::setprecision( 3 ) << framesPerSecond << ",\n";
+    json << "  \"cpuFrameMs\": " << StatsJson( cpuFrame );
+    if ( gpuFrame.numSamples > 0 )
+        json << ",\n  \"gpuFrameMs\": " << StatsJson( gpuFrame );
+    json << "\n}\n";
+    return json.str();
+}
+
+
+void FrameBenchmark::compareWithBaseline() const
+{
+    std::ifstream file( baselinePath );
+    if ( !file )
+        throw std::runtime_error( "FrameBenchmark: Failed to open baseline " + baselinePath );
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    const std::string baseline = buffer.str();
+
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties( theVulkanContext().PhysicalDevice(), &properties );
+    const std::string baselineDevice = FindJsonString( baseline, "device" );
+    if ( baselineDevice != properties.deviceName )
+        std::cout << "  Warning: the baseline was measured on " << baselineDevice << std::endl;
+
+    struct Metric
+    {
+        const char* object;
+        const char* key;
+        double value;
+        bool isHigherBetter;
+    };
+    std::vector<Metric> metrics = {
+        { "cpuFrameMs", "p50", cpuFrame.p50Ms, false },
+        { "cpuFrameMs", "p95", cpuFrame.p95Ms, false },
+        { "", "framesPerSecond", framesPerSecond, true },
+    };
+    if ( gpuFrame.numSamples > 0 )
+    {
+        metrics.push_back( { "gpuFrameMs", "p50", gpuFrame.p50Ms, false } );
+        metrics.push_back( { "gpuFrameMs", "p95", gpuFrame.p95Ms, false } );
+    }
+
+    std::cout << "  Against " << baselinePath << ", tolerance " << 100.0 * tolerance << "%:" << std::endl;
+    std::cout << std::fixed << std::setprecision( 3 );
+    int numRegressions = 0;
+    for ( const auto& metric : metrics )
+    {
+        const double reference = FindJsonNumber( baseline, metric.object, metric.key );
+        if ( std::isnan( reference ) || reference <= 0.0 )
+            continue;
+
+        // Relative slowdown, positive when worse.
+        const double slowdown = metric.isHigherBetter ? reference / metric.value - 1.0 : metric.value / reference - 1.0;
+        const bool isRegression = slowdown > tolerance;
+        numRegressions += isRegression ? 1 : 0;
+
+        const std::string name = std::string( metric.object ) + ( *metric.object != '\0' ? "." : "" ) + metric.key;
+        std::cout << "    " << std::left << std::setw( 16 ) << name << std::right
+            << " " << reference << " -> " << metric.value
+            << " (" << std::showpos << 100.0 * slowdown << std::noshowpos << "% slower)"
+            << ( isRegression ? "  REGRESSION" : "" ) << std::endl;
+    }
+    std::cout.unsetf( std::ios::floatfield );
+
+    if ( numRegressions > 0 )
+        throw std::runtime_error( "FrameBenchmark: " + std::to_string( numRegressions ) + " metrics regressed against " + baselinePath );
+}
+
+
+} // namespace svk
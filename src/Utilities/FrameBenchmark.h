@@ -0,0 +1,82 @@
+#ifndef SVK_FRAMEBENCHMARK_H
+#define SVK_FRAMEBENCHMARK_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+
+namespace svk {
+
+
+class GpuProfiler;
+
+
+// Percentiles of per-frame times, in milliseconds.
+struct FrameTimeStats
+{
+    size_t numSamples = 0;
+    double averageMs = 0.0;
+    double p50Ms = 0.0;
+    double p95Ms = 0.0;
+    double p99Ms = 0.0;
+    double maxMs = 0.0;
+};
+
+
+// Repeatable app runs: a fixed number of frames at a fixed resolution, with a frame clock that
+// advances by a fixed step per frame. Reports CPU frame time, GPU frame time and throughput
+// to the console and as JSON, and optionally fails on regressions against a baseline JSON.
+//
+//     --benchmark[=frames]             Measured frames (default 1000), after the warm-up frames.
+//     --benchmark-warmup=frames        Unmeasured frames first (default 100).
+//     --benchmark-resolution=WxH       Framebuffer size (default 1280x720).
+//     --benchmark-frame-time=seconds   Frame clock step (default 1/60).
+//     --benchmark-output=file.json     Results file.
+//     --benchmark-baseline=file.json   Results to compare with.
+//     --benchmark-tolerance=fraction   Allowed slowdown of p50 and p95 against the baseline (default 0.1).
+class FrameBenchmark
+{
+public:
+    static FrameBenchmark FromCommandLine( int argc, char** argv );
+
+    bool IsEnabled() const { return numFrames > 0; }
+
+    uint32_t Width() const { return width; }
+    uint32_t Height() const { return height; }
+    double FrameSeconds() const { return frameSeconds; }
+
+    // Renders the warm-up and measured frames, then waits for the device.
+    // GPU frame times come from the "frame" region of the profiler, if any.
+    void Run( const std::function<void()>& renderFrame, GpuProfiler* profiler );
+
+    // Prints the results and writes them to the output file, then compares them with the baseline.
+    // Throws if a time regressed by more than the tolerance.
+    void Report( const std::string& appName ) const;
+
+
+private:
+    std::string toJson( const std::string& appName, const std::string& deviceName ) const;
+
+    void compareWithBaseline() const;
+
+    uint32_t numFrames = 0;
+    uint32_t numWarmupFrames = 100;
+    uint32_t width = 1280;
+    uint32_t height = 720;
+    double frameSeconds = 1.0 / 60.0;
+    std::string outputPath;
+    std::string baselinePath;
+    double tolerance = 0.1;
+
+    // Results of Run.
+    FrameTimeStats cpuFrame;
+    FrameTimeStats gpuFrame;
+    double framesPerSecond = 0.0;
+};
+
+
+} // namespace svk
+
+#endif // SVK_FRAMEBENCHMARK_H
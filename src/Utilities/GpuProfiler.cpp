@@ -0,0 +1,408 @@
+#include "GpuProfiler.h"
+#include "ReportFormat.h"
+#include "VulkanContext.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+
+namespace svk {
+
+
+namespace {
+
+
+// Order of the results follows the bit order of the flags.
+const VkQueryPipelineStatisticFlags StatisticsFlags =
+    VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+const uint32_t NumStatistics = 3;
+
+const size_t NoRegion = std::numeric_limits<size_t>::max();
+
+
+} // namespace
+
+
+GpuProfiler::~GpuProfiler()
+{
+    destroyQueryPools();
+}
+
+
+void GpuProfiler::Reset( const uint32_t numFrameSlots )
+{
+    destroyQueryPools();
+    if ( !IsSupported() )
+        return;
+
+    const auto device = theVulkanContext().LogicalDevice();
+
+    slots.resize( numFrameSlots );
+    for ( auto& slot : slots )
+    {
+        VkQueryPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        poolInfo.queryCount = 2 * MaxRegionsPerFrame;
+        if ( vkCreateQueryPool( device, &poolInfo, nullptr, &slot.timestampPool ) != VK_SUCCESS )
+            throw std::runtime_error( "GpuProfiler: Failed to create timestamp query pool." );
+
+        if ( theVulkanContext().IsPipelineStatisticsSupported() )
+        {
+            poolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+            poolInfo.queryCount = MaxRegionsPerFrame;
+            poolInfo.pipelineStatistics = StatisticsFlags;
+            if ( vkCreateQueryPool( device, &poolInfo, nullptr, &slot.statisticsPool ) != VK_SUCCESS )
+                throw std::runtime_error( "GpuProfiler: Failed to create pipeline statistics query pool." );
+        }
+    }
+}
+
+
+void GpuProfiler::Clear()
+{
+    destroyQueryPools();
+    if ( !outputPath.empty() && !regions.empty() )
+        writeJson();
+    outputPath.clear();
+    csvFile.close();
+}
+
+
+bool GpuProfiler::IsSupported() const
+{
+    return theVulkanContext().TimestampValidMask() != 0 && theVulkanContext().TimestampPeriod() > 0.0f;
+}
+
+
+void GpuProfiler::BeginFrame( const VkCommandBuffer commandBuffer, const uint32_t frameSlot )
+{
+    currentSlot = nullptr;
+    openRegions.clear();
+    isStatisticsQueryOpen = false;
+    if ( frameSlot >= slots.size() )
+        return;
+
+    auto& slot = slots[frameSlot];
+    readBack( slot );
+
+    vkCmdResetQueryPool( commandBuffer, slot.timestampPool, 0, 2 * MaxRegionsPerFrame );
+    if ( slot.statisticsPool != VK_NULL_HANDLE )
+        vkCmdResetQueryPool( commandBuffer, slot.statisticsPool, 0, MaxRegionsPerFrame );
+
+    slot.recorded.clear();
+    slot.numStatisticsQueries = 0;
+    slot.frameNumber = frameCounter++;
+    currentSlot = &slot;
+}
+
+
+void GpuProfiler::BeginRegion( const VkCommandBuffer commandBuffer, const std::string& name, const bool withStatistics )
+{
+    if ( currentSlot == nullptr || currentSlot->recorded.size() == MaxRegionsPerFrame )
+    {
+        openRegions.push_back( NoRegion );
+        return;
+    }
+
+    const uint32_t index = uint32_t( currentSlot->recorded.size() );
+    RecordedRegion recorded;
+    recorded.region = findRegion( name );
+    vkCmdWriteTimestamp( commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, currentSlot->timestampPool, 2 * index );
+
+    if ( withStatistics && currentSlot->statisticsPool != VK_NULL_HANDLE && !isStatisticsQueryOpen )
+    {
+        recorded.statisticsQuery = int( currentSlot->numStatisticsQueries++ );
+        vkCmdBeginQuery( commandBuffer, currentSlot->statisticsPool, uint32_t( recorded.statisticsQuery ), 0 );
+        isStatisticsQueryOpen = true;
+    }
+
+    currentSlot->recorded.push_back( recorded );
+    openRegions.push_back( index );
+}
+
+
+void GpuProfiler::EndRegion( const VkCommandBuffer commandBuffer )
+{
+    if ( openRegions.empty() )
+        throw std::runtime_error( "GpuProfiler: EndRegion without BeginRegion." );
+    const size_t index = openRegions.back();
+    openRegions.pop_back();
+    if ( index == NoRegion )
+        return;
+
+    auto& recorded = currentSlot->recorded[index];
+    if ( recorded.statisticsQuery >= 0 )
+    {
+        vkCmdEndQuery( commandBuffer, currentSlot->statisticsPool, uint32_t( recorded.statisticsQuery ) );
+        isStatisticsQueryOpen = false;
+    }
+    vkCmdWriteTimestamp( commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, currentSlot->timestampPool, uint32_t( 2 * index + 1 ) );
+    recorded.isOpen = false;
+}
+
+
+void GpuProfiler::ReadBack()
+{
+    for ( auto& slot : slots )
+    {
+        readBack( slot );
+        slot.recorded.clear();
+    }
+}
+
+
+void GpuProfiler::ResetStats()
+{
+    for ( auto& region : regions )
+    {
+        region.numSamples = 0;
+        region.hasStatistics = false;
+    }
+    firstCountedFrame = frameCounter;
+}
+
+
+void GpuProfiler::SetHistorySize( const size_t numFrames )
+{
+    historySize = std::max( numFrames, size_t( 1 ) );
+    for ( auto& region : regions )
+    {
+        region.milliseconds.clear();
+        region.statistics.clear();
+    }
+    ResetStats();
+}
+
+
+std::vector<GpuRegionStats> GpuProfiler::Stats() const
+{
+    std::vector<GpuRegionStats> result;
+    for ( const auto& region : regions )
+    {
+        if ( region.numSamples == 0 )
+            continue;
+
+        const size_t count = std::min( region.numSamples, historySize );
+        std::vector<double> sorted( region.milliseconds.begin(), region.milliseconds.begin() + count );
+        std::sort( sorted.begin(), sorted.end() );
+
+        GpuRegionStats stats;
+        stats.name = region.name;
+        stats.numSamples = count;
+        for ( const double value : sorted )
+            stats.averageMs += value;
+        stats.averageMs /= count;
+        stats.p50Ms = Percentile( sorted, 0.50 );
+        stats.p95Ms = Percentile( sorted, 0.95 );
+        stats.p99Ms = Percentile( sorted, 0.99 );
+        stats.maxMs = sorted.back();
+
+        // Samples without statistics are NaN.
+        size_t numStatisticsSamples = 0;
+        double sums[NumStatistics] = {};
+        for ( size_t i = 0; i < count && region.hasStatistics; ++i )
+        {
+            if ( std::isnan( region.statistics[NumStatistics * i] ) )
+                continue;
+            for ( uint32_t k = 0; k < NumStatistics; ++k )
+                sums[k] += region.statistics[NumStatistics * i + k];
+            ++numStatisticsSamples;
+        }
+        if ( numStatisticsSamples > 0 )
+        {
+            stats.hasStatistics = true;
+            stats.vertexInvocations = sums[0] / numStatisticsSamples;
+            stats.fragmentInvocations = sums[1] / numStatisticsSamples;
+            stats.computeInvocations = sums[2] / numStatisticsSamples;
+        }
+
+        result.push_back( stats );
+    }
+    return result;
+}
+
+
+bool GpuProfiler::LatestSample( const std::string& name, double& milliseconds, size_t& numSamples ) const
+{
+    for ( const auto& region : regions )
+    {
+        if ( region.name != name || region.numSamples == 0 )
+            continue;
+        milliseconds = region.milliseconds[( region.numSamples - 1 ) % historySize];
+        numSamples = region.numSamples;
+        return true;
+    }
+    return false;
+}
+
+
+std::string GpuProfiler::SummaryLine() const
+{
+    std::ostringstream line;
+    line << std::fixed << std::setprecision( 2 );
+
+    const auto stats = Stats();
+    for ( size_t i = 0; i < stats.size(); ++i )
+    {
+        const auto& region = stats[i];
+        line << ( i == 0 ? "GPU " : " | " ) << region.name << " " << region.averageMs << " ms";
+        if ( i == 0 )
+            line << " (p95 " << region.p95Ms << ")";
+        if ( region.hasStatistics && region.fragmentInvocations > 0.0 )
+            line << ", " << region.fragmentInvocations * 1e-6 << "M frag";
+        if ( region.hasStatistics && region.computeInvocations > 0.0 )
+            line << ", " << region.computeInvocations * 1e-6 << "M comp";
+    }
+    return line.str();
+}
+
+
+void GpuProfiler::SetOutputFile( const std::string& path )
+{
+    csvFile.close();
+    outputPath.clear();
+
+    const std::string jsonExtension = ".json";
+    if ( path.size() >= jsonExtension.size() && path.compare( path.size() - jsonExtension.size(), jsonExtension.size(), jsonExtension ) == 0 )
+    {
+        outputPath = path;
+        return;
+    }
+
+    csvFile.open( path );
+    if ( !csvFile )
+        throw std::runtime_error( "GpuProfiler: Failed to open " + path );
+    csvFile << "frame,region,milliseconds,vertex_invocations,fragment_invocations,compute_invocations\n";
+}
+
+
+void GpuProfiler::destroyQueryPools()
+{
+    const auto device = theVulkanContext().LogicalDevice();
+    for ( auto& slot : slots )
+    {
+        if ( slot.timestampPool != VK_NULL_HANDLE )
+            vkDestroyQueryPool( device, slot.timestampPool, nullptr );
+        if ( slot.statisticsPool != VK_NULL_HANDLE )
+            vkDestroyQueryPool( device, slot.statisticsPool, nullptr );
+    }
+    slots.clear();
+    currentSlot = nullptr;
+    openRegions.clear();
+}
+
+
+void GpuProfiler::readBack( FrameSlot& slot )
+{
+    const auto& recorded = slot.recorded;
+    if ( recorded.empty() || slot.frameNumber < firstCountedFrame )
+        return;
+    // Unbalanced regions leave timestamps unwritten, which would never become available.
+    for ( const auto& region : recorded )
+    {
+        if ( region.isOpen )
+            return;
+    }
+
+    const auto device = theVulkanContext().LogicalDevice();
+
+    std::vector<uint64_t> timestamps( 2 * recorded.size() );
+    if ( vkGetQueryPoolResults( device, slot.timestampPool, 0, uint32_t( timestamps.size() ),
+            timestamps.size() * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT ) != VK_SUCCESS )
+        return;
+
+    std::vector<uint64_t> statistics( NumStatistics * slot.numStatisticsQueries );
+    if ( slot.numStatisticsQueries > 0 &&
+        vkGetQueryPoolResults( device, slot.statisticsPool, 0, slot.numStatisticsQueries,
+            statistics.size() * sizeof(uint64_t), statistics.data(), NumStatistics * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT ) != VK_SUCCESS )
+        return;
+
+    const uint64_t validMask = theVulkanContext().TimestampValidMask();
+    const double msPerTick = theVulkanContext().TimestampPeriod() * 1e-6;
+
+    for ( size_t i = 0; i < recorded.size(); ++i )
+    {
+        auto& region = regions[ recorded[i].region ];
+        if ( region.milliseconds.empty() )
+        {
+            region.milliseconds.resize( historySize );
+            region.statistics.resize( NumStatistics * historySize );
+        }
+
+        const size_t sample = region.numSamples % historySize;
+        const double milliseconds = double( ( timestamps[2*i + 1] - timestamps[2*i] ) & validMask ) * msPerTick;
+        region.milliseconds[sample] = milliseconds;
+
+        const int query = recorded[i].statisticsQuery;
+        for ( uint32_t k = 0; k < NumStatistics; ++k )
+            region.statistics[NumStatistics * sample + k] = ( query >= 0 ) ? double( statistics[NumStatistics * query + k] ) : std::nan( "" );
+        region.hasStatistics = region.hasStatistics || query >= 0;
+        ++region.numSamples;
+
+        if ( csvFile.is_open() )
+        {
+            csvFile << slot.frameNumber << "," << region.name << "," << milliseconds;
+            for ( uint32_t k = 0; k < NumStatistics; ++k )
+            {
+                csvFile << ",";
+                if ( query >= 0 )
+                    csvFile << statistics[NumStatistics * query + k];
+            }
+            csvFile << "\n";
+        }
+    }
+}
+
+
+uint32_t GpuProfiler::findRegion( const std::string& name )
+{
+    for ( uint32_t i = 0; i < regions.size(); ++i )
+    {
+        if ( regions[i].name == name )
+            return i;
+    }
+    regions.emplace_back();
+    regions.back().name = name;
+    return uint32_t( regions.size() - 1 );
+}
+
+
+void GpuProfiler::writeJson() const
+{
+    std::ofstream file( outputPath );
+    if ( !file )
+        throw std::runtime_error( "GpuProfiler: Failed to open " + outputPath );
+
+    const auto stats = Stats();
+    file << "{\n  \"regions\": [";
+    for ( size_t i = 0; i < stats.size(); ++i )
+    {
+        const auto& region = stats[i];
+        file << ( i == 0 ? "\n" : ",\n" )
+            << "    { \"name\": " << JsonString( region.name )
+            << ", \"samples\": " << region.numSamples
+            << ", \"average_ms\": " << region.averageMs
+            << ", \"p50_ms\": " << region.p50Ms
+            << ", \"p95_ms\": " << region.p95Ms
+            << ", \"p99_ms\": " << region.p99Ms
+            << ", \"max_ms\": " << region.maxMs;
+        if ( region.hasStatistics )
+        {
+            file << ", \"vertex_invocations\": " << region.vertexInvocations
+                << ", \"fragment_invocations\": " << region.fragmentInvocations
+                << ", \"compute_invocations\": " << region.computeInvocations;
+        }
+        file << " }";
+    }
+    file << "\n  ]\n}\n";
+}
+
+
+} // namespace svk
@@ -0,0 +1,150 @@
+#ifndef SVK_GPUPROFILER_H
+#define SVK_GPUPROFILER_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+namespace svk {
+
+
+// Rolling statistics of a profiled region, over its last frames, see GpuProfiler::SetHistorySize.
+struct GpuRegionStats
+{
+    std::string name;
+    size_t numSamples = 0;
+    double averageMs = 0.0;
+    double p50Ms = 0.0;
+    double p95Ms = 0.0;
+    double p99Ms = 0.0;
+    double maxMs = 0.0;
+
+    // Averages per frame, if the region gathers pipeline statistics.
+    bool hasStatistics = false;
+    double vertexInvocations = 0.0;
+    double fragmentInvocations = 0.0;
+    double computeInvocations = 0.0;
+};
+
+
+// GPU time of command buffer regions, from vkCmdWriteTimestamp, and shader invocation counts,
+// from pipeline statistics queries. Each frame slot has its own queries, and its results are read
+// back without waiting when the slot is recorded again, i.e. once the GPU is done with it.
+//
+//     profiler.BeginFrame( commandBuffer, swapEntryIndex ); // Outside a render pass.
+//     profiler.BeginRegion( commandBuffer, "shading", true );
+//     ...
+//     profiler.EndRegion( commandBuffer );
+//
+// Regions nest. Pipeline statistics queries cannot, so they are gathered only by regions
+// requesting them while no other statistics region is open.
+class GpuProfiler
+{
+public:
+    static const uint32_t MaxRegionsPerFrame = 32;
+    static const size_t DefaultHistorySize = 256;
+
+    GpuProfiler() = default;
+
+    GpuProfiler( const GpuProfiler& ) = delete;
+
+    // Destroys the queries. Call Clear before, while the device is alive, to write the JSON summary.
+    ~GpuProfiler();
+
+    // (Re)creates the queries of numFrameSlots slots. Statistics gathered so far are kept.
+    void Reset( const uint32_t numFrameSlots );
+
+    // Writes the JSON summary, if requested, and destroys the queries.
+    void Clear();
+
+    // Timestamps are supported by the graphics queue.
+    bool IsSupported() const;
+
+    void BeginFrame( const VkCommandBuffer commandBuffer, const uint32_t frameSlot );
+
+    void BeginRegion( const VkCommandBuffer commandBuffer, const std::string& name, const bool withStatistics = false );
+
+    void EndRegion( const VkCommandBuffer commandBuffer );
+
+    // Reads the results of all recorded frames. Call once the device is idle, e.g. before Stats at exit.
+    void ReadBack();
+
+    // Drops the samples gathered so far, including those of frames still in flight, e.g. of warm-up frames.
+    void ResetStats();
+
+    // Number of last frames the statistics cover, e.g. all frames of a benchmark. Drops the samples gathered so far.
+    void SetHistorySize( const size_t numFrames );
+
+    // Regions in order of first appearance.
+    std::vector<GpuRegionStats> Stats() const;
+
+    // Time of the last frame read back for a region, and the number of its samples so far, which changes
+    // with each new sample. E.g. for feedback on quality settings, without the cost of Stats every frame.
+    // False until the region has a sample.
+    bool LatestSample( const std::string& name, double& milliseconds, size_t& numSamples ) const;
+
+    // One line for the console, e.g. "GPU frame 2.31 ms (p95 2.80) | render pass 2.20 ms, 1.92M frag".
+    std::string SummaryLine() const;
+
+    // Path ending with .json: summary of all regions, written by Clear.
+    // Otherwise CSV: one row per region and frame, written as results arrive.
+    void SetOutputFile( const std::string& path );
+
+
+private:
+    struct RecordedRegion
+    {
+        uint32_t region = 0; // Index in regions.
+        int statisticsQuery = -1;
+        bool isOpen = true;
+    };
+
+    struct FrameSlot
+    {
+        VkQueryPool timestampPool = VK_NULL_HANDLE;
+        VkQueryPool statisticsPool = VK_NULL_HANDLE;
+        uint64_t frameNumber = 0;
+        std::vector<RecordedRegion> recorded; // Region i uses timestamps 2i and 2i+1.
+        uint32_t numStatisticsQueries = 0;
+    };
+
+    struct Region
+    {
+        std::string name;
+        // Ring buffers of the last historySize samples.
+        std::vector<double> milliseconds;
+        std::vector<double> statistics; // Three values per sample, if hasStatistics.
+        size_t numSamples = 0;
+        bool hasStatistics = false;
+    };
+
+    void destroyQueryPools();
+
+    void readBack( FrameSlot& slot );
+
+    uint32_t findRegion( const std::string& name );
+
+    void writeJson() const;
+
+    std::vector<FrameSlot> slots;
+    FrameSlot* currentSlot = nullptr;
+    std::vector<size_t> openRegions; // Indices into currentSlot->recorded.
+    bool isStatisticsQueryOpen = false;
+    uint64_t frameCounter = 0;
+    uint64_t firstCountedFrame = 0;
+    size_t historySize = DefaultHistorySize;
+
+    std::vector<Region> regions;
+
+    std::string outputPath;
+    std::ofstream csvFile;
+};
+
+
+} // namespace svk
+
+#endif // SVK_GPUPROFILER_H
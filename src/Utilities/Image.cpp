@@ -3,6 +3,7 @@
 #include "VulkanBase.h"
 #include "VulkanContext.h"
 #include "CommandPool.h"
+#include "Trace.h"
 
 #include <stdexcept>
 
@@ -33,17 +34,33 @@ Image::~Image()
 
 std::shared_ptr<Image> Image::CreateFromFile( const CommandPool& commandPool, const std::string& filepath )
 {
-    const auto device = theVulkanContext().LogicalDevice();
-    std::shared_ptr<Image> image( new Image() );
+    SVK_TRACE_SCOPE( "Image::CreateFromFile" );
 
     int texWidth, texHeight, texChannels;
-    stbi_uc* pixels = stbi_load( filepath.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha );
-    VkDeviceSize imageSize = texWidth * texHeight * 4;
+    stbi_uc* pixels = nullptr;
+    {
+        SVK_TRACE_SCOPE( "stbi_load" );
+        pixels = stbi_load( filepath.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha );
+    }
 
     if (!pixels) {
         throw std::runtime_error( "Failed to load texture image: " + filepath );
     }
 
+    const auto image = CreateFromPixels( commandPool, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), pixels );
+    stbi_image_free(pixels);
+
+    return image;
+}
+
+
+std::shared_ptr<Image> Image::CreateFromPixels( const CommandPool& commandPool, const uint32_t width, const uint32_t height, const void* pixels )
+{
+    const auto device = theVulkanContext().LogicalDevice();
+    std::shared_ptr<Image> image( new Image() );
+
+    VkDeviceSize imageSize = VkDeviceSize( width ) * height * 4;
+
     VkBuffer stagingBuffer;
     VkDeviceMemory stagingBufferMemory;
     createBuffer( imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory );
@@ -53,12 +70,10 @@ std::shared_ptr<Image> Image::CreateFromFile( const CommandPool& commandPool, co
     memcpy(data, pixels, static_cast<size_t>(imageSize));
     vkUnmapMemory(device, stagingBufferMemory);
 
-    stbi_image_free(pixels);
-
-    image->Reset( texWidth, texHeight, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_TILING_OPTIMAL, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+    image->Reset( width, height, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_TILING_OPTIMAL, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
 
     image->TransitionLayout( commandPool, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL );
-    copyBufferToImage( commandPool, stagingBuffer, image->Handle(), static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight) );
+    copyBufferToImage( commandPool, stagingBuffer, image->Handle(), width, height );
     image->TransitionLayout( commandPool, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL );
 
     vkDestroyBuffer(device, stagingBuffer, nullptr);
@@ -73,6 +88,7 @@ void Image::Reset( const uint32_t width, const uint32_t height, const VkFormat f
     Clear();
     this->width = width;
     this->height = height;
+    this->depth = 1;
     image = CreateImageHandle( width, height, format, imageUsage, tiling );
     deviceMemory = CreateBindedDeviceMemory( image, memoryUsage );
     info.imageLayout = layout;
@@ -81,6 +97,20 @@ void Image::Reset( const uint32_t width, const uint32_t height, const VkFormat f
 }
 
 
+void Image::Reset3D( const uint32_t width, const uint32_t height, const uint32_t depth, const VkFormat format, const VkImageUsageFlags imageUsage, const VkImageLayout layout, const VkSamplerAddressMode addressMode, const VkMemoryPropertyFlags memoryUsage )
+{
+    Clear();
+    this->width = width;
+    this->height = height;
+    this->depth = depth;
+    image = CreateImageHandle( width, height, format, imageUsage, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_TYPE_3D, depth );
+    deviceMemory = CreateBindedDeviceMemory( image, memoryUsage );
+    info.imageLayout = layout;
+    info.imageView = CreateImageView( image, format, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_VIEW_TYPE_3D );
+    info.sampler = CreateSampler( addressMode );
+}
+
+
 void Image::Clear()
 {
     const auto device = theVulkanContext().LogicalDevice();
@@ -96,22 +126,23 @@ void Image::Clear()
 
     width = 0;
     height = 0;
+    depth = 0;
     image = VK_NULL_HANDLE;
     deviceMemory = VK_NULL_HANDLE;
     info = { VK_NULL_HANDLE, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED };
 }
 
 
-VkImage Image::CreateImageHandle( const uint32_t width, const uint32_t height, const VkFormat format, const VkImageUsageFlags imageUsage, const VkImageTiling tiling )
+VkImage Image::CreateImageHandle( const uint32_t width, const uint32_t height, const VkFormat format, const VkImageUsageFlags imageUsage, const VkImageTiling tiling, const VkImageType imageType, const uint32_t depth )
 {
     const auto device = theVulkanContext().LogicalDevice();
 
     VkImageCreateInfo imageInfo{};
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.imageType = imageType;
     imageInfo.extent.width = width;
     imageInfo.extent.height = height;
-    imageInfo.extent.depth = 1;
+    imageInfo.extent.depth = depth;
     imageInfo.mipLevels = 1;
     imageInfo.arrayLayers = 1;
     imageInfo.format = format;
@@ -129,14 +160,14 @@ VkImage Image::CreateImageHandle( const uint32_t width, const uint32_t height, c
 }
 
 
-VkImageView Image::CreateImageView( VkImage image, VkFormat format, VkImageAspectFlags aspectFlags )
+VkImageView Image::CreateImageView( VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, const VkImageViewType viewType )
 {
     const auto device = theVulkanContext().LogicalDevice();
 
     VkImageViewCreateInfo viewInfo{};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
     viewInfo.image = image;
-    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.viewType = viewType;
     viewInfo.format = format;
     viewInfo.subresourceRange.aspectMask = aspectFlags;
     viewInfo.subresourceRange.baseMipLevel = 0;
@@ -152,7 +183,7 @@ VkImageView Image::CreateImageView( VkImage image, VkFormat format, VkImageAspec
 }
 
 
-VkSampler Image::CreateSampler()
+VkSampler Image::CreateSampler( const VkSamplerAddressMode addressMode )
 {
     const auto device = theVulkanContext().LogicalDevice();
     const auto physicalDevice = theVulkanContext().PhysicalDevice();
@@ -164,9 +195,9 @@ VkSampler Image::CreateSampler()
     samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
     samplerInfo.magFilter = VK_FILTER_LINEAR;
     samplerInfo.minFilter = VK_FILTER_LINEAR;
-    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeU = addressMode;
+    samplerInfo.addressModeV = addressMode;
+    samplerInfo.addressModeW = addressMode;
     samplerInfo.anisotropyEnable = VK_TRUE;
     samplerInfo.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
     samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
@@ -206,15 +237,63 @@ VkDeviceMemory Image::CreateBindedDeviceMemory( VkImage image, const VkMemoryPro
 }
 
 
+namespace {
+
+// Accesses and stages that use an image in the given layout.
+void GetLayoutAccess( const VkImageLayout layout, VkAccessFlags& access, VkPipelineStageFlags& stage )
+{
+    switch ( layout )
+    {
+    case VK_IMAGE_LAYOUT_UNDEFINED:
+        access = 0;
+        stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        break;
+    case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+        access = VK_ACCESS_TRANSFER_WRITE_BIT;
+        stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        break;
+    case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+        access = VK_ACCESS_TRANSFER_READ_BIT;
+        stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        break;
+    case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+        access = VK_ACCESS_SHADER_READ_BIT;
+        stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        break;
+    case VK_IMAGE_LAYOUT_GENERAL:
+        access = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        break;
+    default:
+        throw std::invalid_argument("unsupported layout transition!");
+    }
+}
+
+} // namespace
+
+
 void Image::TransitionLayout( const CommandPool& commandPool, VkImageLayout newLayout )
 {
-    const VkImageLayout oldLayout = info.imageLayout;
-    if ( oldLayout == newLayout )
+    if ( info.imageLayout == newLayout )
         return;
 
     VkCommandBuffer commandBuffer = commandPool.CreateCommandBuffer();
     CommandPool::BeginCommandBuffer( commandBuffer, true );
 
+    TransitionLayout( commandBuffer, newLayout );
+
+    CommandPool::EndCommandBuffer( commandBuffer );
+    theVulkanContext().SubmitGraphicsQueue( commandBuffer );
+    commandPool.FreeCommandBuffer( commandBuffer );
+}
+
+
+void Image::TransitionLayout( const VkCommandBuffer commandBuffer, VkImageLayout newLayout )
+{
+    const VkImageLayout oldLayout = info.imageLayout;
+    if ( oldLayout == newLayout )
+        return;
+
     VkImageMemoryBarrier barrier{};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.oldLayout = oldLayout;
@@ -230,22 +309,8 @@ void Image::TransitionLayout( const CommandPool& commandPool, VkImageLayout newL
 
     VkPipelineStageFlags sourceStage;
     VkPipelineStageFlags destinationStage;
-
-    if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-        sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    } else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-        sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    } else {
-        throw std::invalid_argument("unsupported layout transition!");
-    }
+    GetLayoutAccess( oldLayout, barrier.srcAccessMask, sourceStage );
+    GetLayoutAccess( newLayout, barrier.dstAccessMask, destinationStage );
 
     vkCmdPipelineBarrier(
         commandBuffer,
@@ -256,10 +321,6 @@ void Image::TransitionLayout( const CommandPool& commandPool, VkImageLayout newL
         1, &barrier
     );
 
-    CommandPool::EndCommandBuffer( commandBuffer );
-    theVulkanContext().SubmitGraphicsQueue( commandBuffer );
-    commandPool.FreeCommandBuffer( commandBuffer );
-
     info.imageLayout = newLayout;
 }
 
@@ -36,6 +36,9 @@ public:
 
     static std::shared_ptr<Image> CreateFromFile( const CommandPool& commandPool, const std::string& filepath );
 
+    // Sampled sRGB image from tightly packed RGBA8 pixels.
+    static std::shared_ptr<Image> CreateFromPixels( const CommandPool& commandPool, const uint32_t width, const uint32_t height, const void* pixels );
+
     void Reset(
         const uint32_t width,
         const uint32_t height,
@@ -47,27 +50,45 @@ public:
         const VkImageAspectFlags aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT
     );
 
+    // 3D image, e.g. a volume of baked values, sampled with the given addressing on all axes.
+    void Reset3D(
+        const uint32_t width,
+        const uint32_t height,
+        const uint32_t depth,
+        const VkFormat format,
+        const VkImageUsageFlags imageUsage,
+        const VkImageLayout layout,
+        const VkSamplerAddressMode addressMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        const VkMemoryPropertyFlags memoryUsage = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+    );
+
     void Clear();
 
 
     uint32_t Width()  const { return width; }
     uint32_t Height() const { return height; }
+    uint32_t Depth()  const { return depth; } // 1 for 2D images.
 
     const VkImage& Handle() const { return image; }
     const VkDeviceMemory& DeviceMemory() const { return deviceMemory; }
     const VkDescriptorImageInfo& Info() const { return info; }
 
-    static VkImage CreateImageHandle( const uint32_t width, const uint32_t height, const VkFormat format, const VkImageUsageFlags imageUsage, const VkImageTiling tiling );
-    static VkImageView CreateImageView( VkImage image, VkFormat format, VkImageAspectFlags aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT );
-    static VkSampler CreateSampler();
+    static VkImage CreateImageHandle( const uint32_t width, const uint32_t height, const VkFormat format, const VkImageUsageFlags imageUsage, const VkImageTiling tiling, const VkImageType imageType = VK_IMAGE_TYPE_2D, const uint32_t depth = 1 );
+    static VkImageView CreateImageView( VkImage image, VkFormat format, VkImageAspectFlags aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT, const VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D );
+    static VkSampler CreateSampler( const VkSamplerAddressMode addressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT );
     static VkDeviceMemory CreateBindedDeviceMemory( VkImage image, const VkMemoryPropertyFlags memoryUsage );
 
 
     void TransitionLayout( const CommandPool& commandPool, VkImageLayout newLayout );
 
+    // Records the layout transition into a command buffer, e.g. GENERAL for compute storage writes
+    // and SHADER_READ_ONLY_OPTIMAL for sampling afterwards.
+    void TransitionLayout( const VkCommandBuffer commandBuffer, VkImageLayout newLayout );
+
 private:
     uint32_t width = 0;
     uint32_t height = 0;
+    uint32_t depth = 0;
     VkImage image = VK_NULL_HANDLE;
     VkDeviceMemory deviceMemory = VK_NULL_HANDLE;
     VkDescriptorImageInfo info = { VK_NULL_HANDLE, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED };
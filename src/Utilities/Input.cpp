@@ -0,0 +1,45 @@
+#include "Input.h"
+
+#include <GLFW/glfw3.h>
+
+
+namespace svk {
+
+
+void InputState::Apply( const InputEvent& event )
+{
+    switch ( event.type )
+    {
+    case InputEventType::Key:
+        if ( event.code >= 0 && size_t( event.code ) < keys.size() && event.action != GLFW_REPEAT )
+            keys[event.code] = ( event.action == GLFW_PRESS );
+        break;
+    case InputEventType::MouseButton:
+        if ( event.code >= 0 && size_t( event.code ) < mouseButtons.size() )
+            mouseButtons[event.code] = ( event.action == GLFW_PRESS );
+        break;
+    case InputEventType::CursorPos:
+        cursorX = event.x;
+        cursorY = event.y;
+        break;
+    case InputEventType::FramebufferSize:
+        framebufferWidth = int( event.x );
+        framebufferHeight = int( event.y );
+        break;
+    }
+}
+
+
+bool InputState::IsKeyDown( const int key ) const
+{
+    return key >= 0 && size_t( key ) < keys.size() && keys[key];
+}
+
+
+bool InputState::IsMouseButtonDown( const int button ) const
+{
+    return button >= 0 && size_t( button ) < mouseButtons.size() && mouseButtons[button];
+}
+
+
+} // namespace svk
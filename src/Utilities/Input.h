@@ -0,0 +1,66 @@
+#ifndef SVK_INPUT_H
+#define SVK_INPUT_H
+
+#include "SpscQueue.h"
+
+#include <bitset>
+
+
+namespace svk {
+
+
+enum class InputEventType
+{
+    Key,
+    MouseButton,
+    CursorPos,
+    FramebufferSize,
+};
+
+
+// Window event, as reported by the GLFW callbacks.
+struct InputEvent
+{
+    InputEventType type = InputEventType::Key;
+    int code = 0;   // GLFW key or mouse button.
+    int action = 0; // GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT.
+    int mods = 0;
+    double x = 0.0; // Cursor position or framebuffer size.
+    double y = 0.0;
+};
+
+
+// From the thread pumping window events to the render thread.
+using InputQueue = SpscQueue<InputEvent, 4096>;
+
+
+// Keys, buttons, cursor and framebuffer size after the events applied so far.
+// Lets the render thread poll input without calling GLFW, which is main thread only.
+class InputState
+{
+public:
+
+    void Apply( const InputEvent& event );
+
+    bool IsKeyDown( const int key ) const;
+    bool IsMouseButtonDown( const int button ) const;
+
+    double CursorX() const { return cursorX; }
+    double CursorY() const { return cursorY; }
+
+    int FramebufferWidth() const { return framebufferWidth; }
+    int FramebufferHeight() const { return framebufferHeight; }
+
+private:
+    std::bitset<512> keys;
+    std::bitset<8> mouseButtons;
+    double cursorX = 0.0;
+    double cursorY = 0.0;
+    int framebufferWidth = 0;
+    int framebufferHeight = 0;
+};
+
+
+} // namespace svk
+
+#endif // SVK_INPUT_H
@@ -0,0 +1,227 @@
+#include "MeshIndexing.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+
+namespace svk {
+
+namespace {
+
+// Corners per block in the order-preserving passes; smaller inputs are processed serially.
+const size_t MinBlockSize = 16384;
+
+const uint32_t EmptySlot = UINT32_MAX;
+
+
+uint32_t CeilLog2( size_t value )
+{
+    uint32_t result = 0;
+    while ( ( size_t(1) << result ) < value )
+        ++result;
+    return result;
+}
+
+} // namespace
+
+
+uint64_t HashBytes( const void* data, const size_t size, const uint64_t seed )
+{
+    // MurmurHash64A by Austin Appleby, public domain.
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+
+    const unsigned char* bytes = static_cast<const unsigned char*>( data );
+    uint64_t h = seed ^ ( uint64_t( size ) * m );
+
+    const size_t numWords = size / 8;
+    for ( size_t i = 0; i < numWords; ++i )
+    {
+        uint64_t k;
+        memcpy( &k, bytes + 8*i, 8 );
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+
+    const unsigned char* tail = bytes + 8*numWords;
+    switch ( size & 7 )
+    {
+    case 7: h ^= uint64_t( tail[6] ) << 48; [[fallthrough]];
+    case 6: h ^= uint64_t( tail[5] ) << 40; [[fallthrough]];
+    case 5: h ^= uint64_t( tail[4] ) << 32; [[fallthrough]];
+    case 4: h ^= uint64_t( tail[3] ) << 24; [[fallthrough]];
+    case 3: h ^= uint64_t( tail[2] ) << 16; [[fallthrough]];
+    case 2: h ^= uint64_t( tail[1] ) << 8;  [[fallthrough]];
+    case 1: h ^= uint64_t( tail[0] );
+            h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+
+size_t GenerateVertexRemap( const void* corners, const size_t numCorners, const size_t vertexSize, std::vector<uint32_t>& remap, std::vector<uint32_t>& uniqueCorners )
+{
+    remap.resize( numCorners );
+    uniqueCorners.clear();
+
+    if ( numCorners == 0 )
+        return 0;
+    if ( numCorners >= size_t( EmptySlot ) )
+        throw std::runtime_error( "GenerateVertexRemap: Too many corners for 32-bit indices." );
+
+    const unsigned char* bytes = static_cast<const unsigned char*>( corners );
+
+    // Corners are split into blocks, so that the passes which depend on corner order can still run in parallel.
+    const size_t numBlocks = std::min( ( numCorners + MinBlockSize - 1 ) / MinBlockSize, size_t( 4 * NumParallelThreads() ) );
+    const size_t blockSize = ( numCorners + numBlocks - 1 ) / numBlocks;
+    const auto forEachBlock = [&]( const std::function<void( size_t block, size_t begin, size_t end )>& func )
+    {
+        ParallelFor( numBlocks, [&]( const size_t blockBegin, const size_t blockEnd )
+        {
+            for ( size_t block = blockBegin; block < blockEnd; ++block )
+                func( block, block * blockSize, std::min( numCorners, (block + 1) * blockSize ) );
+        }, 1 );
+    };
+
+    // Pass 1: hash all corners.
+    std::vector<uint64_t> hashes( numCorners );
+    ParallelFor( numCorners, [&]( const size_t begin, const size_t end )
+    {
+        for ( size_t i = begin; i < end; ++i )
+            hashes[i] = HashBytes( bytes + i*vertexSize, vertexSize );
+    } );
+
+    // Pass 2: bucket corners into partitions by the highest hash bits, keeping the corner order within each partition.
+    // Equal vertices always land in the same partition, so partitions can be deduplicated independently.
+    const uint32_t partitionBits = ( numBlocks > 1 ) ? CeilLog2( 4 * NumParallelThreads() ) : 0;
+    const size_t numPartitions = size_t(1) << partitionBits;
+    const auto partitionOf = [partitionBits]( const uint64_t hash ) -> size_t
+    {
+        return ( partitionBits == 0 ) ? 0 : size_t( hash >> ( 64 - partitionBits ) );
+    };
+
+    std::vector<uint32_t> blockOffsets( numBlocks * numPartitions, 0 );
+    forEachBlock( [&]( const size_t block, const size_t begin, const size_t end )
+    {
+        uint32_t* counts = blockOffsets.data() + block * numPartitions;
+        for ( size_t i = begin; i < end; ++i )
+            ++counts[ partitionOf( hashes[i] ) ];
+    } );
+
+    std::vector<size_t> partitionStart( numPartitions + 1 );
+    uint32_t offset = 0;
+    for ( size_t partition = 0; partition < numPartitions; ++partition )
+    {
+        partitionStart[partition] = offset;
+        for ( size_t block = 0; block < numBlocks; ++block )
+        {
+            const uint32_t count = blockOffsets[ block * numPartitions + partition ];
+            blockOffsets[ block * numPartitions + partition ] = offset;
+            offset += count;
+        }
+    }
+    partitionStart[numPartitions] = offset;
+
+    std::vector<uint32_t> partitionedCorners( numCorners );
+    forEachBlock( [&]( const size_t block, const size_t begin, const size_t end )
+    {
+        uint32_t* cursors = blockOffsets.data() + block * numPartitions;
+        for ( size_t i = begin; i < end; ++i )
+            partitionedCorners[ cursors[ partitionOf( hashes[i] ) ]++ ] = static_cast<uint32_t>( i );
+    } );
+
+    // Pass 3: find the first occurrence of every corner, using one open-addressing table per partition.
+    std::vector<uint32_t> firstOccurrence( numCorners );
+    ParallelFor( numPartitions, [&]( const size_t partitionBegin, const size_t partitionEnd )
+    {
+        std::vector<uint32_t> table;
+        for ( size_t partition = partitionBegin; partition < partitionEnd; ++partition )
+        {
+            const size_t begin = partitionStart[partition];
+            const size_t end = partitionStart[partition + 1];
+            if ( begin == end )
+                continue;
+
+            // Load factor is kept below 1/2, so linear probing stays short.
+            const size_t tableSize = size_t(1) << std::max( 4u, CeilLog2( 2 * ( end - begin ) ) );
+            const size_t mask = tableSize - 1;
+            table.assign( tableSize, EmptySlot );
+
+            for ( size_t k = begin; k < end; ++k )
+            {
+                const uint32_t corner = partitionedCorners[k];
+                const uint64_t hash = hashes[corner];
+                const unsigned char* vertex = bytes + size_t( corner ) * vertexSize;
+
+                // Low hash bits pick the slot; high bits were already used for partitioning.
+                size_t slot = size_t( hash ) & mask;
+                while ( true )
+                {
+                    const uint32_t entry = table[slot];
+                    if ( entry == EmptySlot )
+                    {
+                        table[slot] = corner;
+                        firstOccurrence[corner] = corner;
+                        break;
+                    }
+                    if ( hashes[entry] == hash && memcmp( bytes + size_t( entry ) * vertexSize, vertex, vertexSize ) == 0 )
+                    {
+                        firstOccurrence[corner] = entry;
+                        break;
+                    }
+                    slot = ( slot + 1 ) & mask;
+                }
+            }
+        }
+    }, 1 );
+
+    // Pass 4: number unique vertices in the order of their first occurrence.
+    std::vector<uint32_t> blockFirstVertex( numBlocks + 1, 0 );
+    forEachBlock( [&]( const size_t block, const size_t begin, const size_t end )
+    {
+        uint32_t count = 0;
+        for ( size_t i = begin; i < end; ++i )
+            count += ( firstOccurrence[i] == i ) ? 1 : 0;
+        blockFirstVertex[block + 1] = count;
+    } );
+    for ( size_t block = 0; block < numBlocks; ++block )
+        blockFirstVertex[block + 1] += blockFirstVertex[block];
+
+    const size_t numUnique = blockFirstVertex[numBlocks];
+    uniqueCorners.resize( numUnique );
+    forEachBlock( [&]( const size_t block, const size_t begin, const size_t end )
+    {
+        uint32_t vertex = blockFirstVertex[block];
+        for ( size_t i = begin; i < end; ++i )
+        {
+            if ( firstOccurrence[i] == i )
+            {
+                uniqueCorners[vertex] = static_cast<uint32_t>( i );
+                remap[i] = vertex++;
+            }
+        }
+    } );
+
+    // Pass 5: repeated corners take the number of their first occurrence.
+    ParallelFor( numCorners, [&]( const size_t begin, const size_t end )
+    {
+        for ( size_t i = begin; i < end; ++i )
+        {
+            if ( firstOccurrence[i] != i )
+                remap[i] = remap[ firstOccurrence[i] ];
+        }
+    } );
+
+    return numUnique;
+}
+
+
+} // namespace svk
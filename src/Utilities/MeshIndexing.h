@@ -0,0 +1,58 @@
+#ifndef SVK_MESHINDEXING_H
+#define SVK_MESHINDEXING_H
+
+#include "Parallel.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+
+namespace svk {
+
+
+// Strong 64-bit hash of raw bytes (MurmurHash64A).
+uint64_t HashBytes( const void* data, const size_t size, const uint64_t seed = 0 );
+
+
+// Merges bit-identical vertices of a triangle corner stream.
+// Corners are compared by their raw bytes, so vertex types must not contain padding,
+// and +0.0 and -0.0 are treated as different values.
+// On return, remap[i] is the unique vertex of corner i, and uniqueCorners[v] is the first corner of unique vertex v.
+// Unique vertices are numbered in the order of their first occurrence.
+// Returns the number of unique vertices.
+size_t GenerateVertexRemap(
+    const void* corners,
+    const size_t numCorners,
+    const size_t vertexSize,
+    std::vector<uint32_t>& remap,
+    std::vector<uint32_t>& uniqueCorners
+);
+
+
+// Converts a stream of triangle corners into vertex and index buffers.
+// The result is identical to the usual unordered_map-based deduplication.
+template< typename Vertex >
+void BuildIndexedMesh(
+    const std::vector<Vertex>& corners,
+    std::vector<Vertex>& vertices,
+    std::vector<uint32_t>& indices )
+{
+    static_assert( std::is_trivially_copyable<Vertex>::value, "Vertex must be trivially copyable." );
+
+    std::vector<uint32_t> uniqueCorners;
+    GenerateVertexRemap( corners.data(), corners.size(), sizeof(Vertex), indices, uniqueCorners );
+
+    vertices.resize( uniqueCorners.size() );
+    ParallelFor( uniqueCorners.size(), [&]( const size_t begin, const size_t end )
+    {
+        for ( size_t i = begin; i < end; ++i )
+            vertices[i] = corners[ uniqueCorners[i] ];
+    } );
+}
+
+
+} // namespace svk
+
+#endif // SVK_MESHINDEXING_H
@@ -0,0 +1,365 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+
+namespace svk {
+
+namespace {
+
+// Soft cluster boundaries are never placed closer than this many triangles apart.
+const size_t MinClusterSize = 8;
+
+
+void ValidateIndices( const std::vector<uint32_t>& indices, const size_t numVertices )
+{
+    if ( indices.size() % 3 != 0 )
+        throw std::runtime_error( "MeshOptimizer: Index count is not a multiple of 3." );
+    for ( const uint32_t index : indices )
+    {
+        if ( index >= numVertices )
+            throw std::runtime_error( "MeshOptimizer: Index is out of vertex range." );
+    }
+}
+
+
+// FIFO post-transform cache, simulated with insertion timestamps.
+// Vertex is cached if it was inserted during the last cacheSize misses.
+class FifoCacheSimulator
+{
+public:
+
+    FifoCacheSimulator( const size_t numVertices, const uint32_t cacheSize )
+        : insertionTime( numVertices, 0 )
+        , cacheSize( cacheSize )
+        , time( cacheSize + 1 )
+    {}
+
+    // Returns true on cache miss.
+    bool Access( const uint32_t vertex )
+    {
+        if ( time - insertionTime[vertex] <= cacheSize )
+            return false;
+        insertionTime[vertex] = time++;
+        return true;
+    }
+
+    int AccessTriangle( const uint32_t* triangle )
+    {
+        return int( Access( triangle[0] ) ) + int( Access( triangle[1] ) ) + int( Access( triangle[2] ) );
+    }
+
+    void Flush()
+    {
+        time += cacheSize + 1;
+    }
+
+private:
+    std::vector<uint32_t> insertionTime;
+    uint32_t cacheSize;
+    uint32_t time;
+};
+
+
+void ReadPosition( const void* positions, const size_t positionStride, const uint32_t vertex, float* position )
+{
+    memcpy( position, static_cast<const char*>( positions ) + size_t( vertex ) * positionStride, 3 * sizeof(float) );
+}
+
+} // namespace
+
+
+VertexCacheStatistics AnalyzeVertexCache( const std::vector<uint32_t>& indices, const size_t numVertices, const uint32_t cacheSize )
+{
+    ValidateIndices( indices, numVertices );
+
+    VertexCacheStatistics statistics;
+    const size_t numTriangles = indices.size() / 3;
+    if ( numTriangles == 0 )
+        return statistics;
+
+    FifoCacheSimulator cache( numVertices, cacheSize );
+    std::vector<uint8_t> isReferenced( numVertices, 0 );
+    size_t numMisses = 0;
+    size_t numReferenced = 0;
+    for ( const uint32_t index : indices )
+    {
+        numMisses += cache.Access( index ) ? 1 : 0;
+        numReferenced += isReferenced[index] ? 0 : 1;
+        isReferenced[index] = 1;
+    }
+
+    statistics.acmr = double( numMisses ) / double( numTriangles );
+    statistics.atvr = double( numMisses ) / double( numReferenced );
+    return statistics;
+}
+
+
+void OptimizeVertexCache( std::vector<uint32_t>& indices, const size_t numVertices, const uint32_t cacheSize )
+{
+    ValidateIndices( indices, numVertices );
+
+    const size_t numTriangles = indices.size() / 3;
+    if ( numTriangles == 0 )
+        return;
+
+    // Vertex-to-triangle adjacency.
+    std::vector<uint32_t> adjacencyOffsets( numVertices + 1, 0 );
+    for ( const uint32_t index : indices )
+        ++adjacencyOffsets[index + 1];
+    for ( size_t v = 0; v < numVertices; ++v )
+        adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+
+    std::vector<uint32_t> adjacency( indices.size() );
+    std::vector<uint32_t> adjacencyCursor( adjacencyOffsets.begin(), adjacencyOffsets.end() - 1 );
+    for ( size_t i = 0; i < indices.size(); ++i )
+        adjacency[ adjacencyCursor[ indices[i] ]++ ] = static_cast<uint32_t>( i / 3 );
+
+    // Number of not yet emitted triangles using each vertex.
+    std::vector<uint32_t> liveTriangles( numVertices );
+    for ( size_t v = 0; v < numVertices; ++v )
+        liveTriangles[v] = adjacencyOffsets[v + 1] - adjacencyOffsets[v];
+
+    std::vector<uint32_t> cacheTime( numVertices, 0 );
+    std::vector<uint8_t> isEmitted( numTriangles, 0 );
+    std::vector<uint32_t> deadEndStack;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> result;
+    result.reserve( indices.size() );
+
+    uint32_t time = cacheSize + 1;
+    size_t scanCursor = 0;
+
+    // Next vertex with live triangles: the most recent one on the dead-end stack, otherwise the next one in input order.
+    const auto skipDeadEnd = [&]() -> int64_t
+    {
+        while ( !deadEndStack.empty() )
+        {
+            const uint32_t vertex = deadEndStack.back();
+            deadEndStack.pop_back();
+            if ( liveTriangles[vertex] > 0 )
+                return vertex;
+        }
+        while ( scanCursor < numVertices )
+        {
+            if ( liveTriangles[scanCursor] > 0 )
+                return int64_t( scanCursor );
+            ++scanCursor;
+        }
+        return -1;
+    };
+
+    int64_t fanningVertex = skipDeadEnd();
+    while ( fanningVertex >= 0 )
+    {
+        // Emit all remaining triangles around the fanning vertex.
+        candidates.clear();
+        for ( uint32_t a = adjacencyOffsets[fanningVertex]; a < adjacencyOffsets[fanningVertex + 1]; ++a )
+        {
+            const uint32_t triangle = adjacency[a];
+            if ( isEmitted[triangle] )
+                continue;
+            isEmitted[triangle] = 1;
+
+            for ( int c = 0; c < 3; ++c )
+            {
+                const uint32_t vertex = indices[ 3*triangle + c ];
+                result.push_back( vertex );
+                deadEndStack.push_back( vertex );
+                candidates.push_back( vertex );
+                --liveTriangles[vertex];
+                if ( time - cacheTime[vertex] > cacheSize )
+                    cacheTime[vertex] = time++;
+            }
+        }
+
+        // Pick the candidate that will still be in cache after its fan is emitted, preferring the oldest one.
+        int64_t nextVertex = -1;
+        int64_t bestPriority = -1;
+        for ( const uint32_t vertex : candidates )
+        {
+            if ( liveTriangles[vertex] == 0 )
+                continue;
+            const int64_t age = int64_t( time - cacheTime[vertex] );
+            const int64_t priority = ( age + 2 * int64_t( liveTriangles[vertex] ) <= int64_t( cacheSize ) ) ? age : 0;
+            if ( priority > bestPriority )
+            {
+                bestPriority = priority;
+                nextVertex = vertex;
+            }
+        }
+
+        fanningVertex = ( nextVertex >= 0 ) ? nextVertex : skipDeadEnd();
+    }
+
+    indices.swap( result );
+}
+
+
+void OptimizeOverdraw( std::vector<uint32_t>& indices, const void* positions, const size_t positionStride, const size_t numVertices, const uint32_t cacheSize, const float threshold )
+{
+    ValidateIndices( indices, numVertices );
+
+    const size_t numTriangles = indices.size() / 3;
+    if ( numTriangles < 2 )
+        return;
+
+    // Hard cluster boundaries: triangles that miss the cache on all three vertices,
+    // i.e. places where the cache-optimized order restarts anyway.
+    std::vector<size_t> hardClusters;
+    {
+        FifoCacheSimulator cache( numVertices, cacheSize );
+        for ( size_t t = 0; t < numTriangles; ++t )
+        {
+            if ( cache.AccessTriangle( &indices[3*t] ) == 3 || t == 0 )
+                hardClusters.push_back( t );
+        }
+        hardClusters.push_back( numTriangles );
+    }
+
+    // Soft cluster boundaries: split hard clusters wherever the prefix is almost as cache efficient as the whole cluster.
+    std::vector<size_t> clusters;
+    {
+        FifoCacheSimulator cache( numVertices, cacheSize );
+        for ( size_t h = 0; h + 1 < hardClusters.size(); ++h )
+        {
+            const size_t start = hardClusters[h];
+            const size_t end = hardClusters[h + 1];
+
+            cache.Flush();
+            size_t clusterMisses = 0;
+            for ( size_t t = start; t < end; ++t )
+                clusterMisses += cache.AccessTriangle( &indices[3*t] );
+            const double clusterAcmr = double( clusterMisses ) / double( end - start );
+
+            cache.Flush();
+            clusters.push_back( start );
+            size_t begin = start;
+            size_t misses = 0;
+            for ( size_t t = start; t < end; ++t )
+            {
+                misses += cache.AccessTriangle( &indices[3*t] );
+                const size_t count = t + 1 - begin;
+                if ( t + 1 < end && count >= MinClusterSize && double( misses ) <= threshold * clusterAcmr * double( count ) )
+                {
+                    clusters.push_back( t + 1 );
+                    begin = t + 1;
+                    misses = 0;
+                    cache.Flush();
+                }
+            }
+        }
+        clusters.push_back( numTriangles );
+    }
+
+    const size_t numClusters = clusters.size() - 1;
+    if ( numClusters < 2 )
+        return;
+
+    // Area-weighted centroid and normal of each cluster, and of the whole mesh.
+    std::vector<double> clusterData( 6 * numClusters, 0.0 );
+    double meshCentroid[3] = { 0.0, 0.0, 0.0 };
+    double meshArea = 0.0;
+    for ( size_t c = 0; c < numClusters; ++c )
+    {
+        double* centroid = &clusterData[6*c];
+        double* normal = &clusterData[6*c + 3];
+        double clusterArea = 0.0;
+        for ( size_t t = clusters[c]; t < clusters[c + 1]; ++t )
+        {
+            float p0[3], p1[3], p2[3];
+            ReadPosition( positions, positionStride, indices[3*t + 0], p0 );
+            ReadPosition( positions, positionStride, indices[3*t + 1], p1 );
+            ReadPosition( positions, positionStride, indices[3*t + 2], p2 );
+
+            const double e1[3] = { double(p1[0]) - p0[0], double(p1[1]) - p0[1], double(p1[2]) - p0[2] };
+            const double e2[3] = { double(p2[0]) - p0[0], double(p2[1]) - p0[1], double(p2[2]) - p0[2] };
+            const double n[3] = {
+                e1[1]*e2[2] - e1[2]*e2[1],
+                e1[2]*e2[0] - e1[0]*e2[2],
+                e1[0]*e2[1] - e1[1]*e2[0],
+            };
+            const double area = 0.5 * std::sqrt( n[0]*n[0] + n[1]*n[1] + n[2]*n[2] );
+
+            for ( int k = 0; k < 3; ++k )
+            {
+                const double triangleCentroid = ( double(p0[k]) + p1[k] + p2[k] ) / 3.0;
+                centroid[k] += area * triangleCentroid;
+                meshCentroid[k] += area * triangleCentroid;
+                normal[k] += n[k];
+            }
+            clusterArea += area;
+        }
+        for ( int k = 0; k < 3; ++k )
+            centroid[k] = ( clusterArea > 0.0 ) ? centroid[k] / clusterArea : 0.0;
+        meshArea += clusterArea;
+    }
+    for ( int k = 0; k < 3; ++k )
+        meshCentroid[k] = ( meshArea > 0.0 ) ? meshCentroid[k] / meshArea : 0.0;
+
+    // View-independent occlusion heuristic: clusters facing away from the mesh centre are likely occluders.
+    std::vector<double> sortKeys( numClusters );
+    for ( size_t c = 0; c < numClusters; ++c )
+    {
+        const double* centroid = &clusterData[6*c];
+        const double* normal = &clusterData[6*c + 3];
+        const double normalLength = std::sqrt( normal[0]*normal[0] + normal[1]*normal[1] + normal[2]*normal[2] );
+        double key = 0.0;
+        if ( normalLength > 0.0 )
+        {
+            for ( int k = 0; k < 3; ++k )
+                key += ( centroid[k] - meshCentroid[k] ) * normal[k];
+            key /= normalLength;
+        }
+        sortKeys[c] = key;
+    }
+
+    std::vector<uint32_t> clusterOrder( numClusters );
+    for ( size_t c = 0; c < numClusters; ++c )
+        clusterOrder[c] = static_cast<uint32_t>( c );
+    std::stable_sort( clusterOrder.begin(), clusterOrder.end(), [&]( const uint32_t a, const uint32_t b )
+    {
+        return sortKeys[a] > sortKeys[b];
+    } );
+
+    std::vector<uint32_t> result;
+    result.reserve( indices.size() );
+    for ( const uint32_t c : clusterOrder )
+        result.insert( result.end(), indices.begin() + 3*clusters[c], indices.begin() + 3*clusters[c + 1] );
+    indices.swap( result );
+}
+
+
+std::vector<uint32_t> OptimizeVertexFetchRemap( std::vector<uint32_t>& indices, const size_t numVertices )
+{
+    ValidateIndices( indices, numVertices );
+
+    const uint32_t Unassigned = UINT32_MAX;
+    std::vector<uint32_t> oldToNew( numVertices, Unassigned );
+    std::vector<uint32_t> newToOld;
+    newToOld.reserve( numVertices );
+
+    for ( uint32_t& index : indices )
+    {
+        if ( oldToNew[index] == Unassigned )
+        {
+            oldToNew[index] = static_cast<uint32_t>( newToOld.size() );
+            newToOld.push_back( index );
+        }
+        index = oldToNew[index];
+    }
+
+    for ( size_t v = 0; v < numVertices; ++v )
+    {
+        if ( oldToNew[v] == Unassigned )
+            newToOld.push_back( static_cast<uint32_t>( v ) );
+    }
+
+    return newToOld;
+}
+
+
+} // namespace svk
@@ -0,0 +1,105 @@
+#ifndef SVK_MESHOPTIMIZER_H
+#define SVK_MESHOPTIMIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+
+namespace svk {
+
+
+// Post-transform vertex cache efficiency of a triangle list, simulated with a FIFO cache.
+struct VertexCacheStatistics
+{
+    double acmr = 0.0; // Average cache miss ratio: transformed vertices per triangle (0.5 is ideal, 3 is worst).
+    double atvr = 0.0; // Average transform to vertex ratio: transformed vertices per referenced vertex (1 is ideal).
+};
+
+struct MeshOptimizationReport
+{
+    VertexCacheStatistics before;
+    VertexCacheStatistics after;
+};
+
+
+const uint32_t DefaultVertexCacheSize = 16;
+
+
+VertexCacheStatistics AnalyzeVertexCache(
+    const std::vector<uint32_t>& indices,
+    const size_t numVertices,
+    const uint32_t cacheSize = DefaultVertexCacheSize
+);
+
+
+// Reorders triangles for post-transform vertex cache locality (Tipsify, Sander et al. 2007).
+void OptimizeVertexCache(
+    std::vector<uint32_t>& indices,
+    const size_t numVertices,
+    const uint32_t cacheSize = DefaultVertexCacheSize
+);
+
+
+// Reorders clusters of a cache-optimized triangle list so that outward-facing clusters are drawn first,
+// which reduces overdraw from any viewpoint. Clusters are split where the cache efficiency
+// is within the given threshold of the original, so ACMR grows by at most that factor.
+// Vertex positions are three floats, read at positions + i*positionStride bytes.
+void OptimizeOverdraw(
+    std::vector<uint32_t>& indices,
+    const void* positions,
+    const size_t positionStride,
+    const size_t numVertices,
+    const uint32_t cacheSize = DefaultVertexCacheSize,
+    const float threshold = 1.05f
+);
+
+
+// Renumbers vertices in the order of their first use in the index buffer.
+// Rewrites the indices and returns the table newToOld, where newToOld[i] is the old index of new vertex i.
+// Unreferenced vertices are moved to the end.
+std::vector<uint32_t> OptimizeVertexFetchRemap(
+    std::vector<uint32_t>& indices,
+    const size_t numVertices
+);
+
+
+template< typename Vertex >
+void OptimizeVertexFetch( std::vector<Vertex>& vertices, std::vector<uint32_t>& indices )
+{
+    const auto newToOld = OptimizeVertexFetchRemap( indices, vertices.size() );
+    std::vector<Vertex> reordered( vertices.size() );
+    for ( size_t i = 0; i < newToOld.size(); ++i )
+        reordered[i] = vertices[ newToOld[i] ];
+    vertices.swap( reordered );
+}
+
+
+// Runs vertex cache, overdraw and vertex fetch optimization in sequence.
+// Vertex position is three floats at positionOffset bytes from the start of Vertex.
+template< typename Vertex >
+MeshOptimizationReport OptimizeMesh(
+    std::vector<Vertex>& vertices,
+    std::vector<uint32_t>& indices,
+    const size_t positionOffset,
+    const uint32_t cacheSize = DefaultVertexCacheSize )
+{
+    static_assert( std::is_trivially_copyable<Vertex>::value, "Vertex must be trivially copyable." );
+
+    MeshOptimizationReport report;
+    report.before = AnalyzeVertexCache( indices, vertices.size(), cacheSize );
+
+    OptimizeVertexCache( indices, vertices.size(), cacheSize );
+    const char* positions = reinterpret_cast<const char*>( vertices.data() ) + positionOffset;
+    OptimizeOverdraw( indices, positions, sizeof(Vertex), vertices.size(), cacheSize );
+    OptimizeVertexFetch( vertices, indices );
+
+    report.after = AnalyzeVertexCache( indices, vertices.size(), cacheSize );
+    return report;
+}
+
+
+} // namespace svk
+
+#endif // SVK_MESHOPTIMIZER_H
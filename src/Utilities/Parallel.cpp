@@ -0,0 +1,167 @@
+#include "Parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace svk {
+
+namespace {
+
+
+thread_local bool isInsideParallelFor = false;
+
+
+// Persistent pool of worker threads, so that ParallelFor can be used every frame.
+class WorkerPool
+{
+public:
+
+    WorkerPool()
+    {
+        const uint32_t numHardwareThreads = std::max( 1u, std::thread::hardware_concurrency() );
+        for ( uint32_t i = 1; i < numHardwareThreads; ++i )
+            workers.emplace_back( [this] { WorkerLoop(); } );
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            isStopping = true;
+        }
+        wakeCondition.notify_all();
+        for ( auto& worker : workers )
+            worker.join();
+    }
+
+    uint32_t NumThreads() const { return static_cast<uint32_t>( workers.size() ) + 1; }
+
+    void Run( const size_t numChunks, const std::function<void( size_t chunk )>& chunkFunc )
+    {
+        std::lock_guard<std::mutex> submitLock( submitMutex );
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            job = &chunkFunc;
+            jobNumChunks = numChunks;
+            nextChunk.store( 0 );
+            ++generation;
+        }
+        wakeCondition.notify_all();
+
+        ProcessChunks();
+
+        // Workers may still be finishing their last chunks.
+        std::unique_lock<std::mutex> lock( mutex );
+        doneCondition.wait( lock, [this] { return numActiveWorkers == 0; } );
+        job = nullptr;
+    }
+
+private:
+
+    void WorkerLoop()
+    {
+        isInsideParallelFor = true;
+        uint64_t seenGeneration = 0;
+        std::unique_lock<std::mutex> lock( mutex );
+        while ( true )
+        {
+            wakeCondition.wait( lock, [&] { return isStopping || generation != seenGeneration; } );
+            if ( isStopping )
+                return;
+            seenGeneration = generation;
+            if ( job == nullptr )
+                continue;
+
+            ++numActiveWorkers;
+            lock.unlock();
+            ProcessChunks();
+            lock.lock();
+            if ( --numActiveWorkers == 0 )
+                doneCondition.notify_all();
+        }
+    }
+
+    void ProcessChunks()
+    {
+        while ( true )
+        {
+            const size_t chunk = nextChunk.fetch_add( 1 );
+            if ( chunk >= jobNumChunks )
+                return;
+            (*job)( chunk );
+        }
+    }
+
+private:
+    std::vector<std::thread> workers;
+
+    std::mutex submitMutex;
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable doneCondition;
+
+    const std::function<void( size_t )>* job = nullptr;
+    size_t jobNumChunks = 0;
+    std::atomic<size_t> nextChunk { 0 };
+    uint64_t generation = 0;
+    uint32_t numActiveWorkers = 0;
+    bool isStopping = false;
+};
+
+
+WorkerPool& theWorkerPool()
+{
+    static WorkerPool pool;
+    return pool;
+}
+
+
+} // namespace
+
+
+uint32_t NumParallelThreads()
+{
+    return theWorkerPool().NumThreads();
+}
+
+
+void ParallelFor( const size_t count, const std::function<void( size_t begin, size_t end )>& func, const size_t minChunkSize )
+{
+    if ( count == 0 )
+        return;
+
+    if ( isInsideParallelFor )
+    {
+        func( 0, count );
+        return;
+    }
+
+    auto& pool = theWorkerPool();
+
+    // Few chunks per thread give some load balancing without much scheduling overhead.
+    const size_t maxNumChunks = 4 * size_t( pool.NumThreads() );
+    const size_t chunkSize = std::max( std::max( minChunkSize, size_t(1) ), ( count + maxNumChunks - 1 ) / maxNumChunks );
+    const size_t numChunks = ( count + chunkSize - 1 ) / chunkSize;
+
+    if ( numChunks <= 1 || pool.NumThreads() == 1 )
+    {
+        func( 0, count );
+        return;
+    }
+
+    isInsideParallelFor = true;
+    pool.Run( numChunks, [&]( const size_t chunk )
+    {
+        const size_t begin = chunk * chunkSize;
+        func( begin, std::min( count, begin + chunkSize ) );
+    } );
+    isInsideParallelFor = false;
+}
+
+
+} // namespace svk
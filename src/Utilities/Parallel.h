@@ -0,0 +1,30 @@
+#ifndef SVK_PARALLEL_H
+#define SVK_PARALLEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+
+namespace svk {
+
+
+// Number of threads taking part in ParallelFor, including the calling thread.
+uint32_t NumParallelThreads();
+
+
+// Splits the range [0,count) into contiguous chunks of at least minChunkSize elements,
+// and calls func( begin, end ) for each of them on a shared pool of worker threads.
+// The calling thread participates in the work; the call returns when all chunks are done.
+// Nested calls (from inside func) are executed serially on the calling thread.
+// Function func must not throw.
+void ParallelFor(
+    const size_t count,
+    const std::function<void( size_t begin, size_t end )>& func,
+    const size_t minChunkSize = 1024
+);
+
+
+} // namespace svk
+
+#endif // SVK_PARALLEL_H
@@ -0,0 +1,345 @@
+#include "ParticleIntegrator.h"
+
+#include "Parallel.h"
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SVK_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define SVK_SIMD_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SVK_SIMD_NEON
+#endif
+
+
+namespace svk {
+
+namespace {
+
+
+// Lane backends. Kernels are templates over a backend and use only the operations below,
+// so every backend computes exactly the same IEEE operations as the scalar one.
+// Max( a, b ) is a > b ? a : b, as std::max( b, a ).
+
+struct ScalarLanes
+{
+    using F = float;
+    using Mask = bool;
+    static constexpr size_t Width = 1;
+
+    static F Load( const float* p ) { return *p; }
+    static void Store( float* p, const F a ) { *p = a; }
+    static F Set( const float a ) { return a; }
+
+    static F Sqrt( const F a ) { return std::sqrt( a ); }
+    static F Abs( const F a ) { return std::fabs( a ); }
+    static F Max( const F a, const F b ) { return ( a > b ) ? a : b; }
+    static F Truncate( const F a ) { return float( int32_t( a ) ); }
+    static F Round( const F a ) { return std::nearbyint( a ); }
+
+    static Mask Greater( const F a, const F b ) { return a > b; }
+    static Mask Equal( const F a, const F b ) { return a == b; }
+    static F Select( const Mask m, const F a, const F b ) { return m ? a : b; }
+};
+
+
+#if defined(SVK_SIMD_AVX2)
+
+struct AvxLanes
+{
+    struct F
+    {
+        __m256 v;
+        friend F operator+( const F a, const F b ) { return { _mm256_add_ps( a.v, b.v ) }; }
+        friend F operator-( const F a, const F b ) { return { _mm256_sub_ps( a.v, b.v ) }; }
+        friend F operator*( const F a, const F b ) { return { _mm256_mul_ps( a.v, b.v ) }; }
+        friend F operator/( const F a, const F b ) { return { _mm256_div_ps( a.v, b.v ) }; }
+        friend F operator-( const F a ) { return { _mm256_xor_ps( a.v, _mm256_set1_ps( -0.0f ) ) }; }
+    };
+    struct Mask { __m256 v; };
+    static constexpr size_t Width = 8;
+
+    static F Load( const float* p ) { return { _mm256_loadu_ps( p ) }; }
+    static void Store( float* p, const F a ) { _mm256_storeu_ps( p, a.v ); }
+    static F Set( const float a ) { return { _mm256_set1_ps( a ) }; }
+
+    static F Sqrt( const F a ) { return { _mm256_sqrt_ps( a.v ) }; }
+    static F Abs( const F a ) { return { _mm256_andnot_ps( _mm256_set1_ps( -0.0f ), a.v ) }; }
+    static F Max( const F a, const F b ) { return { _mm256_max_ps( a.v, b.v ) }; }
+    static F Truncate( const F a ) { return { _mm256_cvtepi32_ps( _mm256_cvttps_epi32( a.v ) ) }; }
+    static F Round( const F a ) { return { _mm256_round_ps( a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC ) }; }
+
+    static Mask Greater( const F a, const F b ) { return { _mm256_cmp_ps( a.v, b.v, _CMP_GT_OQ ) }; }
+    static Mask Equal( const F a, const F b ) { return { _mm256_cmp_ps( a.v, b.v, _CMP_EQ_OQ ) }; }
+    static F Select( const Mask m, const F a, const F b ) { return { _mm256_blendv_ps( b.v, a.v, m.v ) }; }
+};
+using BestLanes = AvxLanes;
+const char* const BestLanesName = "AVX2";
+
+#elif defined(SVK_SIMD_SSE2)
+
+struct SseLanes
+{
+    struct F
+    {
+        __m128 v;
+        friend F operator+( const F a, const F b ) { return { _mm_add_ps( a.v, b.v ) }; }
+        friend F operator-( const F a, const F b ) { return { _mm_sub_ps( a.v, b.v ) }; }
+        friend F operator*( const F a, const F b ) { return { _mm_mul_ps( a.v, b.v ) }; }
+        friend F operator/( const F a, const F b ) { return { _mm_div_ps( a.v, b.v ) }; }
+        friend F operator-( const F a ) { return { _mm_xor_ps( a.v, _mm_set1_ps( -0.0f ) ) }; }
+    };
+    struct Mask { __m128 v; };
+    static constexpr size_t Width = 4;
+
+    static F Load( const float* p ) { return { _mm_loadu_ps( p ) }; }
+    static void Store( float* p, const F a ) { _mm_storeu_ps( p, a.v ); }
+    static F Set( const float a ) { return { _mm_set1_ps( a ) }; }
+
+    static F Sqrt( const F a ) { return { _mm_sqrt_ps( a.v ) }; }
+    static F Abs( const F a ) { return { _mm_andnot_ps( _mm_set1_ps( -0.0f ), a.v ) }; }
+    static F Max( const F a, const F b ) { return { _mm_max_ps( a.v, b.v ) }; }
+    static F Truncate( const F a ) { return { _mm_cvtepi32_ps( _mm_cvttps_epi32( a.v ) ) }; }
+    // Rounds to nearest even with the default MXCSR rounding mode, as std::nearbyint.
+    static F Round( const F a ) { return { _mm_cvtepi32_ps( _mm_cvtps_epi32( a.v ) ) }; }
+
+    static Mask Greater( const F a, const F b ) { return { _mm_cmpgt_ps( a.v, b.v ) }; }
+    static Mask Equal( const F a, const F b ) { return { _mm_cmpeq_ps( a.v, b.v ) }; }
+    static F Select( const Mask m, const F a, const F b ) { return { _mm_or_ps( _mm_and_ps( m.v, a.v ), _mm_andnot_ps( m.v, b.v ) ) }; }
+};
+using BestLanes = SseLanes;
+const char* const BestLanesName = "SSE2";
+
+#elif defined(SVK_SIMD_NEON)
+
+struct NeonLanes
+{
+    struct F
+    {
+        float32x4_t v;
+        friend F operator+( const F a, const F b ) { return { vaddq_f32( a.v, b.v ) }; }
+        friend F operator-( const F a, const F b ) { return { vsubq_f32( a.v, b.v ) }; }
+        friend F operator*( const F a, const F b ) { return { vmulq_f32( a.v, b.v ) }; }
+        friend F operator/( const F a, const F b ) { return { vdivq_f32( a.v, b.v ) }; }
+        friend F operator-( const F a ) { return { vnegq_f32( a.v ) }; }
+    };
+    struct Mask { uint32x4_t v; };
+    static constexpr size_t Width = 4;
+
+    static F Load( const float* p ) { return { vld1q_f32( p ) }; }
+    static void Store( float* p, const F a ) { vst1q_f32( p, a.v ); }
+    static F Set( const float a ) { return { vdupq_n_f32( a ) }; }
+
+    static F Sqrt( const F a ) { return { vsqrtq_f32( a.v ) }; }
+    static F Abs( const F a ) { return { vabsq_f32( a.v ) }; }
+    // vmaxq_f32 propagates NaN, so compare and select instead.
+    static F Max( const F a, const F b ) { return { vbslq_f32( vcgtq_f32( a.v, b.v ), a.v, b.v ) }; }
+    static F Truncate( const F a ) { return { vcvtq_f32_s32( vcvtq_s32_f32( a.v ) ) }; }
+    static F Round( const F a ) { return { vrndnq_f32( a.v ) }; }
+
+    static Mask Greater( const F a, const F b ) { return { vcgtq_f32( a.v, b.v ) }; }
+    static Mask Equal( const F a, const F b ) { return { vceqq_f32( a.v, b.v ) }; }
+    static F Select( const Mask m, const F a, const F b ) { return { vbslq_f32( m.v, a.v, b.v ) }; }
+};
+using BestLanes = NeonLanes;
+const char* const BestLanesName = "NEON";
+
+#else
+
+using BestLanes = ScalarLanes;
+const char* const BestLanesName = "Scalar";
+
+#endif
+
+
+const float _2Pi = float( 2.0 * M_PI );
+
+
+// Sine and cosine for |x| < 2*pi, with an absolute error of about 1e-7.
+// Cody-Waite reduction to [-pi/4,pi/4] and Cephes sinf/cosf polynomials.
+template< typename L >
+void SinCos( const typename L::F x, typename L::F& sinX, typename L::F& cosX )
+{
+    using F = typename L::F;
+
+    const F q = L::Round( x * L::Set( 0.63661977236758134f ) );
+    const F r = ( ( x - q * L::Set( 1.5703125f ) ) - q * L::Set( 4.837512969970703125e-4f ) ) - q * L::Set( 7.549789948768648e-8f );
+    const F z = r * r;
+
+    const F sinR = r + r * z * ( L::Set( -1.6666654611e-1f ) + z * ( L::Set( 8.3321608736e-3f ) + z * L::Set( -1.9515295891e-4f ) ) );
+    const F cosR = L::Set( 1.0f ) - L::Set( 0.5f ) * z
+        + z * z * ( L::Set( 4.166664568298827e-2f ) + z * ( L::Set( -1.388731625493765e-3f ) + z * L::Set( 2.443315711809948e-5f ) ) );
+
+    // Quadrant q mod 4, in [0,4).
+    F quadrant = q - L::Set( 4.0f ) * L::Truncate( q * L::Set( 0.25f ) );
+    quadrant = L::Select( L::Greater( L::Set( 0.0f ), quadrant ), quadrant + L::Set( 4.0f ), quadrant );
+
+    const auto isQuadrant1 = L::Equal( quadrant, L::Set( 1.0f ) );
+    const auto isQuadrant2 = L::Equal( quadrant, L::Set( 2.0f ) );
+    const auto isQuadrant3 = L::Equal( quadrant, L::Set( 3.0f ) );
+
+    sinX = L::Select( isQuadrant1, cosR, L::Select( isQuadrant2, -sinR, L::Select( isQuadrant3, -cosR, sinR ) ) );
+    cosX = L::Select( isQuadrant1, -sinR, L::Select( isQuadrant2, -cosR, L::Select( isQuadrant3, sinR, cosR ) ) );
+}
+
+
+// Same steps as Task5 used to do per triangle with glm::vec3.
+template< typename L >
+void StepExplodeLanes( ExplodeParticles& particles, const ExplodeParameters& parameters, const float deltaTime, const size_t i )
+{
+    using F = typename L::F;
+
+    F speedX = L::Load( &particles.speedX[i] );
+    F speedY = L::Load( &particles.speedY[i] );
+    F speedZ = L::Load( &particles.speedZ[i] );
+    F shiftX = L::Load( &particles.shiftX[i] );
+    F shiftY = L::Load( &particles.shiftY[i] );
+    F shiftZ = L::Load( &particles.shiftZ[i] );
+
+    const F zero = L::Set( 0.0f );
+    const F dt = L::Set( deltaTime );
+
+    // Deteriorate explode speed.
+    F speedNorm = L::Sqrt( speedX*speedX + speedY*speedY + speedZ*speedZ );
+    const auto hasSpeed = L::Greater( speedNorm, L::Set( 0.01f ) );
+    const F speedDirX = L::Select( hasSpeed, speedX / speedNorm, zero );
+    const F speedDirY = L::Select( hasSpeed, speedY / speedNorm, zero );
+    const F speedDirZ = L::Select( hasSpeed, speedZ / speedNorm, zero );
+    const F shiftNorm = L::Sqrt( shiftX*shiftX + shiftY*shiftY + shiftZ*shiftZ );
+    const F deterioration = ( L::Set( 1.0f ) + shiftNorm ) * L::Set( parameters.speedDeterioration );
+    speedNorm = L::Max( speedNorm - dt*deterioration, zero );
+    speedX = speedNorm * speedDirX;
+    speedY = speedNorm * speedDirY;
+    speedZ = speedNorm * speedDirZ;
+
+    // Apply explode speed, then pull to center.
+    shiftX = shiftX + speedX * dt;
+    shiftY = shiftY + speedY * dt;
+    shiftZ = shiftZ + speedZ * dt;
+    F centerDist = L::Sqrt( shiftX*shiftX + shiftY*shiftY + shiftZ*shiftZ );
+    const auto hasShift = L::Greater( centerDist, L::Set( 0.0001f ) );
+    const F shiftDirX = L::Select( hasShift, shiftX / centerDist, zero );
+    const F shiftDirY = L::Select( hasShift, shiftY / centerDist, zero );
+    const F shiftDirZ = L::Select( hasShift, shiftZ / centerDist, zero );
+    centerDist = L::Max( centerDist - dt*L::Set( parameters.pullToCenter ), zero );
+
+    L::Store( &particles.speedX[i], speedX );
+    L::Store( &particles.speedY[i], speedY );
+    L::Store( &particles.speedZ[i], speedZ );
+    L::Store( &particles.shiftX[i], centerDist * shiftDirX );
+    L::Store( &particles.shiftY[i], centerDist * shiftDirY );
+    L::Store( &particles.shiftZ[i], centerDist * shiftDirZ );
+}
+
+
+// Same steps as Task1b used to do per triangle.
+template< typename L >
+void StepRigidBodyLanes( RigidBodies2D& bodies, const std::vector<float>& outline, const float deltaTime, const size_t i )
+{
+    using F = typename L::F;
+
+    const F dt = L::Set( deltaTime );
+    const F one = L::Set( 1.0f );
+    const F minusOne = L::Set( -1.0f );
+
+    F angle = L::Load( &bodies.angle[i] );
+    angle = angle + dt * L::Load( &bodies.angularSpeed[i] );
+    angle = angle - L::Truncate( angle / L::Set( _2Pi ) ) * L::Set( _2Pi );
+    F sinA, cosA;
+    SinCos<L>( angle, sinA, cosA );
+
+    F speedX = L::Load( &bodies.speedX[i] );
+    F speedY = L::Load( &bodies.speedY[i] );
+    const F positionX = L::Load( &bodies.positionX[i] ) + speedX * dt;
+    const F positionY = L::Load( &bodies.positionY[i] ) + speedY * dt;
+
+    // Change speed direction on collision.
+    for ( size_t k = 0; k + 1 < outline.size(); k += 2 )
+    {
+        const F localX = L::Set( outline[k] );
+        const F localY = L::Set( outline[k+1] );
+        const F x = ( positionX + cosA*localX ) - sinA*localY;
+        const F y = ( positionY + sinA*localX ) + cosA*localY;
+
+        speedX = L::Select( L::Greater( x, one ), -L::Abs( speedX ), speedX );
+        speedX = L::Select( L::Greater( minusOne, x ), L::Abs( speedX ), speedX );
+        speedY = L::Select( L::Greater( y, one ), -L::Abs( speedY ), speedY );
+        speedY = L::Select( L::Greater( minusOne, y ), L::Abs( speedY ), speedY );
+    }
+
+    L::Store( &bodies.angle[i], angle );
+    L::Store( &bodies.positionX[i], positionX );
+    L::Store( &bodies.positionY[i], positionY );
+    L::Store( &bodies.speedX[i], speedX );
+    L::Store( &bodies.speedY[i], speedY );
+}
+
+
+// Full-width lanes first, the remainder with the scalar kernel.
+template< typename L, typename Kernel, typename ScalarKernel >
+void ForEachLanes( const size_t count, const Kernel& kernel, const ScalarKernel& scalarKernel )
+{
+    ParallelFor( count, [&]( const size_t begin, const size_t end )
+    {
+        size_t i = begin;
+        for ( ; i + L::Width <= end; i += L::Width )
+            kernel( i );
+        for ( ; i < end; ++i )
+            scalarKernel( i );
+    }, 4096 );
+}
+
+
+} // namespace
+
+
+const char* BestSimdPathName()
+{
+    return BestLanesName;
+}
+
+
+void ExplodeParticles::Resize( const size_t numParticles )
+{
+    for ( auto* values : { &speedX, &speedY, &speedZ, &shiftX, &shiftY, &shiftZ } )
+        values->resize( numParticles, 0.0f );
+}
+
+
+void StepExplodeParticles( ExplodeParticles& particles, const ExplodeParameters& parameters, const float deltaTime, const SimdPath path )
+{
+    const auto scalarKernel = [&]( const size_t i ) { StepExplodeLanes<ScalarLanes>( particles, parameters, deltaTime, i ); };
+    if ( path == SimdPath::Scalar )
+        ForEachLanes<ScalarLanes>( particles.Size(), scalarKernel, scalarKernel );
+    else
+        ForEachLanes<BestLanes>( particles.Size(), [&]( const size_t i ) { StepExplodeLanes<BestLanes>( particles, parameters, deltaTime, i ); }, scalarKernel );
+}
+
+
+void RigidBodies2D::Resize( const size_t numBodies )
+{
+    for ( auto* values : { &positionX, &positionY, &speedX, &speedY, &angle, &angularSpeed } )
+        values->resize( numBodies, 0.0f );
+}
+
+
+void StepRigidBodies2D( RigidBodies2D& bodies, const std::vector<float>& outline, const float deltaTime, const SimdPath path )
+{
+    if ( outline.size() % 2 != 0 )
+        throw std::runtime_error( "StepRigidBodies2D: Outline must consist of x,y pairs." );
+
+    const auto scalarKernel = [&]( const size_t i ) { StepRigidBodyLanes<ScalarLanes>( bodies, outline, deltaTime, i ); };
+    if ( path == SimdPath::Scalar )
+        ForEachLanes<ScalarLanes>( bodies.Size(), scalarKernel, scalarKernel );
+    else
+        ForEachLanes<BestLanes>( bodies.Size(), [&]( const size_t i ) { StepRigidBodyLanes<BestLanes>( bodies, outline, deltaTime, i ); }, scalarKernel );
+}
+
+
+} // namespace svk
@@ -0,0 +1,79 @@
+#ifndef SVK_PARTICLEINTEGRATOR_H
+#define SVK_PARTICLEINTEGRATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace svk {
+
+
+// Kernels used by the integrators. All paths give bit-identical results:
+// the SIMD kernels perform the same IEEE operations in the same order as the scalar ones,
+// and the file is compiled without multiply-add contraction.
+enum class SimdPath
+{
+    Scalar,
+    Best, // Widest instruction set the library was compiled for (AVX2, SSE2, NEON or scalar).
+};
+
+// Name of the kernels used by SimdPath::Best.
+const char* BestSimdPathName();
+
+
+// Pieces of an explosion in structure-of-arrays layout.
+// Each piece flies away from its rest position with a decaying speed and is pulled back at constant speed.
+struct ExplodeParticles
+{
+    std::vector<float> speedX, speedY, speedZ; // Out-of-center speed.
+    std::vector<float> shiftX, shiftY, shiftZ; // Relative position to rest.
+
+    size_t Size() const { return speedX.size(); }
+
+    // New particles are at rest.
+    void Resize( const size_t numParticles );
+};
+
+
+struct ExplodeParameters
+{
+    float pullToCenter = 2.0f; // Constant speed that pulls to center.
+    float speedDeterioration = 2.0f; // How much speed deteriorates per second, scaled by ( 1 + shift length ).
+};
+
+
+void StepExplodeParticles(
+    ExplodeParticles& particles,
+    const ExplodeParameters& parameters,
+    const float deltaTime,
+    const SimdPath path = SimdPath::Best
+);
+
+
+// 2D rigid bodies sharing one outline, bouncing inside the [-1,1] square.
+// Speed components are reflected when an outline vertex leaves the square.
+struct RigidBodies2D
+{
+    std::vector<float> positionX, positionY;
+    std::vector<float> speedX, speedY;
+    std::vector<float> angle, angularSpeed; // Angle is kept in (-2*pi, 2*pi).
+
+    size_t Size() const { return positionX.size(); }
+
+    void Resize( const size_t numBodies );
+};
+
+
+// Outline is given as x,y pairs in body coordinates.
+void StepRigidBodies2D(
+    RigidBodies2D& bodies,
+    const std::vector<float>& outline,
+    const float deltaTime,
+    const SimdPath path = SimdPath::Best
+);
+
+
+} // namespace svk
+
+#endif // SVK_PARTICLEINTEGRATOR_H
@@ -0,0 +1,111 @@
+#include "PresentPolicy.h"
+
+#include "CommandLine.h"
+
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+
+namespace svk {
+
+
+namespace {
+
+
+// Margin left to yielding before a frame deadline.
+const auto SpinMargin = std::chrono::milliseconds( 2 );
+
+
+} // namespace
+
+
+PresentPolicy PresentPolicy::FromCommandLine( int argc, char** argv )
+{
+    PresentPolicy policy;
+
+    const std::string presentModes = FindCommandLineOption( argc, argv, "present-mode" );
+    if ( !presentModes.empty() )
+    {
+        policy.presentModes.clear();
+        std::istringstream stream( presentModes );
+        std::string name;
+        while ( std::getline( stream, name, ',' ) )
+            policy.presentModes.push_back( ParsePresentMode( name ) );
+    }
+
+    const std::string numImages = FindCommandLineOption( argc, argv, "swapchain-images" );
+    if ( !numImages.empty() )
+        policy.numImages = uint32_t( std::atoi( numImages.c_str() ) );
+
+    const std::string framesInFlight = FindCommandLineOption( argc, argv, "frames-in-flight" );
+    if ( !framesInFlight.empty() )
+    {
+        policy.framesInFlight = uint32_t( std::atoi( framesInFlight.c_str() ) );
+        if ( policy.framesInFlight == 0 )
+            throw std::runtime_error( "PresentPolicy: --frames-in-flight must be at least 1." );
+    }
+
+    const std::string maxFrameRate = FindCommandLineOption( argc, argv, "max-fps" );
+    if ( !maxFrameRate.empty() )
+        policy.maxFrameRate = std::atof( maxFrameRate.c_str() );
+
+    return policy;
+}
+
+
+VkPresentModeKHR ParsePresentMode( const std::string& name )
+{
+    if ( name == "immediate" )
+        return VK_PRESENT_MODE_IMMEDIATE_KHR;
+    if ( name == "mailbox" )
+        return VK_PRESENT_MODE_MAILBOX_KHR;
+    if ( name == "fifo" )
+        return VK_PRESENT_MODE_FIFO_KHR;
+    if ( name == "fifo-relaxed" )
+        return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+    throw std::runtime_error( "Unknown present mode: " + name );
+}
+
+
+const char* PresentModeName( const VkPresentModeKHR presentMode )
+{
+    switch ( presentMode )
+    {
+    case VK_PRESENT_MODE_IMMEDIATE_KHR: return "immediate";
+    case VK_PRESENT_MODE_MAILBOX_KHR: return "mailbox";
+    case VK_PRESENT_MODE_FIFO_KHR: return "fifo";
+    case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "fifo-relaxed";
+    default: return "unknown";
+    }
+}
+
+
+FrameLimiter::FrameLimiter( const double maxFrameRate )
+{
+    if ( maxFrameRate > 0.0 )
+        framePeriod = std::chrono::duration_cast<Clock::duration>( std::chrono::duration<double>( 1.0 / maxFrameRate ) );
+    nextFrameTime = Clock::now();
+}
+
+
+void FrameLimiter::Wait()
+{
+    if ( framePeriod == Clock::duration::zero() )
+        return;
+
+    if ( Clock::now() < nextFrameTime - SpinMargin )
+        std::this_thread::sleep_until( nextFrameTime - SpinMargin );
+    while ( Clock::now() < nextFrameTime )
+        std::this_thread::yield();
+
+    // A late frame starts a new schedule instead of being followed by a burst of catch-up frames.
+    const auto now = Clock::now();
+    nextFrameTime += framePeriod;
+    if ( nextFrameTime < now )
+        nextFrameTime = now + framePeriod;
+}
+
+
+} // namespace svk
@@ -0,0 +1,65 @@
+#ifndef SVK_PRESENTPOLICY_H
+#define SVK_PRESENTPOLICY_H
+
+#include <vulkan/vulkan.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+
+namespace svk {
+
+
+// How frames are paced and presented, trading latency, throughput and power.
+// Set with VulkanContext::SetPresentPolicy before the swap chain is created.
+struct PresentPolicy
+{
+    // In order of preference. The first one supported by the surface is used, FIFO otherwise.
+    std::vector<VkPresentModeKHR> presentModes = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR };
+
+    // Swap chain images, clamped to the surface limits. Zero means one more than the surface minimum.
+    uint32_t numImages = 0;
+
+    // Frames the CPU may record ahead of the GPU.
+    uint32_t framesInFlight = 2;
+
+    // CPU side frame rate cap. Zero means no cap.
+    double maxFrameRate = 0.0;
+
+
+    // Options in the form --key=value, others are ignored:
+    //   --present-mode=M[,M...]   immediate, mailbox, fifo or fifo-relaxed, in order of preference.
+    //   --swapchain-images=N
+    //   --frames-in-flight=N
+    //   --max-fps=F
+    static PresentPolicy FromCommandLine( int argc, char** argv );
+};
+
+
+VkPresentModeKHR ParsePresentMode( const std::string& name );
+
+const char* PresentModeName( const VkPresentModeKHR presentMode );
+
+
+// Spaces calls of Wait() at least 1/maxFrameRate apart.
+// Sleeps until shortly before the deadline, then yields, as sleeps overshoot by up to a scheduler tick.
+class FrameLimiter
+{
+public:
+
+    explicit FrameLimiter( const double maxFrameRate = 0.0 );
+
+    void Wait();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Clock::duration framePeriod = Clock::duration::zero();
+    Clock::time_point nextFrameTime;
+};
+
+
+} // namespace svk
+
+#endif // SVK_PRESENTPOLICY_H
@@ -0,0 +1,289 @@
+#include "Random.h"
+
+#include "Parallel.h"
+
+#include <algorithm>
+#include <random>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SVK_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define SVK_SIMD_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SVK_SIMD_NEON
+#endif
+
+
+namespace svk {
+
+namespace {
+
+
+const uint32_t PhiloxM0 = 0xD2511F53u;
+const uint32_t PhiloxM1 = 0xCD9E8D57u;
+const uint32_t PhiloxW0 = 0x9E3779B9u;
+const uint32_t PhiloxW1 = 0xBB67AE85u;
+
+
+// Lane backends for Philox, as in ParticleIntegrator: one kernel template, many widths.
+
+struct ScalarLanes
+{
+    using U = uint32_t;
+    static constexpr size_t Width = 1;
+
+    static U Load( const uint32_t* p ) { return *p; }
+    static void Store( uint32_t* p, const U a ) { *p = a; }
+    static U Set( const uint32_t a ) { return a; }
+    static U Xor( const U a, const U b ) { return a ^ b; }
+
+    static void MulHiLo( const U a, const uint32_t m, U& hi, U& lo )
+    {
+        const uint64_t product = uint64_t( a ) * m;
+        hi = uint32_t( product >> 32 );
+        lo = uint32_t( product );
+    }
+};
+
+
+#if defined(SVK_SIMD_AVX2)
+
+struct BestLanes
+{
+    using U = __m256i;
+    static constexpr size_t Width = 8;
+
+    static U Load( const uint32_t* p ) { return _mm256_loadu_si256( reinterpret_cast<const __m256i*>( p ) ); }
+    static void Store( uint32_t* p, const U a ) { _mm256_storeu_si256( reinterpret_cast<__m256i*>( p ), a ); }
+    static U Set( const uint32_t a ) { return _mm256_set1_epi32( int32_t( a ) ); }
+    static U Xor( const U a, const U b ) { return _mm256_xor_si256( a, b ); }
+
+    static void MulHiLo( const U a, const uint32_t m, U& hi, U& lo )
+    {
+        const __m256i mv = _mm256_set1_epi32( int32_t( m ) );
+        const __m256i even = _mm256_mul_epu32( a, mv );
+        const __m256i odd = _mm256_mul_epu32( _mm256_srli_epi64( a, 32 ), mv );
+        const __m256i lowMask = _mm256_set1_epi64x( 0xFFFFFFFFll );
+        lo = _mm256_or_si256( _mm256_and_si256( even, lowMask ), _mm256_slli_epi64( odd, 32 ) );
+        hi = _mm256_or_si256( _mm256_srli_epi64( even, 32 ), _mm256_andnot_si256( lowMask, odd ) );
+    }
+};
+
+#elif defined(SVK_SIMD_SSE2)
+
+struct BestLanes
+{
+    using U = __m128i;
+    static constexpr size_t Width = 4;
+
+    static U Load( const uint32_t* p ) { return _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) ); }
+    static void Store( uint32_t* p, const U a ) { _mm_storeu_si128( reinterpret_cast<__m128i*>( p ), a ); }
+    static U Set( const uint32_t a ) { return _mm_set1_epi32( int32_t( a ) ); }
+    static U Xor( const U a, const U b ) { return _mm_xor_si128( a, b ); }
+
+    static void MulHiLo( const U a, const uint32_t m, U& hi, U& lo )
+    {
+        const __m128i mv = _mm_set1_epi32( int32_t( m ) );
+        const __m128i even = _mm_mul_epu32( a, mv );
+        const __m128i odd = _mm_mul_epu32( _mm_srli_epi64( a, 32 ), mv );
+        const __m128i lowMask = _mm_set1_epi64x( 0xFFFFFFFFll );
+        lo = _mm_or_si128( _mm_and_si128( even, lowMask ), _mm_slli_epi64( odd, 32 ) );
+        hi = _mm_or_si128( _mm_srli_epi64( even, 32 ), _mm_andnot_si128( lowMask, odd ) );
+    }
+};
+
+#elif defined(SVK_SIMD_NEON)
+
+struct BestLanes
+{
+    using U = uint32x4_t;
+    static constexpr size_t Width = 4;
+
+    static U Load( const uint32_t* p ) { return vld1q_u32( p ); }
+    static void Store( uint32_t* p, const U a ) { vst1q_u32( p, a ); }
+    static U Set( const uint32_t a ) { return vdupq_n_u32( a ); }
+    static U Xor( const U a, const U b ) { return veorq_u32( a, b ); }
+
+    static void MulHiLo( const U a, const uint32_t m, U& hi, U& lo )
+    {
+        const uint32x2_t mv = vdup_n_u32( m );
+        const uint64x2_t low = vmull_u32( vget_low_u32( a ), mv );
+        const uint64x2_t high = vmull_u32( vget_high_u32( a ), mv );
+        lo = vcombine_u32( vmovn_u64( low ), vmovn_u64( high ) );
+        hi = vcombine_u32( vshrn_n_u64( low, 32 ), vshrn_n_u64( high, 32 ) );
+    }
+};
+
+#else
+
+using BestLanes = ScalarLanes;
+
+#endif
+
+
+// Philox blocks firstBlock .. firstBlock + L::Width - 1, written to result[block][word].
+template< typename L >
+void PhiloxBlocks( const uint64_t seed, const uint64_t firstBlock, uint32_t result[][4] )
+{
+    using U = typename L::U;
+
+    uint32_t counterLow[L::Width], counterHigh[L::Width];
+    for ( size_t lane = 0; lane < L::Width; ++lane )
+    {
+        counterLow[lane] = uint32_t( firstBlock + lane );
+        counterHigh[lane] = uint32_t( ( firstBlock + lane ) >> 32 );
+    }
+
+    U c0 = L::Load( counterLow );
+    U c1 = L::Load( counterHigh );
+    U c2 = L::Set( 0 );
+    U c3 = L::Set( 0 );
+    uint32_t k0 = uint32_t( seed );
+    uint32_t k1 = uint32_t( seed >> 32 );
+
+    for ( int round = 0; round < 10; ++round )
+    {
+        U hi0, lo0, hi1, lo1;
+        L::MulHiLo( c0, PhiloxM0, hi0, lo0 );
+        L::MulHiLo( c2, PhiloxM1, hi1, lo1 );
+        c0 = L::Xor( L::Xor( hi1, c1 ), L::Set( k0 ) );
+        c1 = lo1;
+        c2 = L::Xor( L::Xor( hi0, c3 ), L::Set( k1 ) );
+        c3 = lo0;
+        k0 += PhiloxW0;
+        k1 += PhiloxW1;
+    }
+
+    uint32_t words[4][L::Width];
+    L::Store( words[0], c0 );
+    L::Store( words[1], c1 );
+    L::Store( words[2], c2 );
+    L::Store( words[3], c3 );
+    for ( size_t lane = 0; lane < L::Width; ++lane )
+    {
+        for ( int word = 0; word < 4; ++word )
+            result[lane][word] = words[word][lane];
+    }
+}
+
+
+// Stream values [firstIndex, firstIndex + count), count at most 4 * BestLanes::Width * 64.
+void GenerateBatch( const uint64_t seed, const uint64_t firstIndex, uint32_t* values, const size_t count )
+{
+    const size_t Width = BestLanes::Width;
+    uint32_t blocks[Width * 64 + 2][4];
+
+    const uint64_t firstBlock = firstIndex / 4;
+    const uint64_t endBlock = ( firstIndex + count + 3 ) / 4;
+    const size_t numBlocks = size_t( endBlock - firstBlock );
+
+    size_t block = 0;
+    for ( ; block + Width <= numBlocks; block += Width )
+        PhiloxBlocks<BestLanes>( seed, firstBlock + block, &blocks[block] );
+    for ( ; block < numBlocks; ++block )
+        PhiloxBlocks<ScalarLanes>( seed, firstBlock + block, &blocks[block] );
+
+    const size_t skip = size_t( firstIndex % 4 );
+    for ( size_t i = 0; i < count; ++i )
+        values[i] = blocks[ ( skip + i ) / 4 ][ ( skip + i ) % 4 ];
+}
+
+
+const size_t BatchSize = 4 * BestLanes::Width * 64;
+
+
+float UintToFloat( const uint32_t value )
+{
+    return float( value >> 8 ) * ( 1.0f / 16777216.0f );
+}
+
+
+} // namespace
+
+
+void Philox4x32( const uint32_t counter[4], const uint32_t key[2], uint32_t result[4] )
+{
+    uint32_t c[4] = { counter[0], counter[1], counter[2], counter[3] };
+    uint32_t k[2] = { key[0], key[1] };
+
+    for ( int round = 0; round < 10; ++round )
+    {
+        const uint64_t product0 = uint64_t( PhiloxM0 ) * c[0];
+        const uint64_t product1 = uint64_t( PhiloxM1 ) * c[2];
+        const uint32_t next[4] = {
+            uint32_t( product1 >> 32 ) ^ c[1] ^ k[0],
+            uint32_t( product1 ),
+            uint32_t( product0 >> 32 ) ^ c[3] ^ k[1],
+            uint32_t( product0 ),
+        };
+        for ( int i = 0; i < 4; ++i )
+            c[i] = next[i];
+        k[0] += PhiloxW0;
+        k[1] += PhiloxW1;
+    }
+
+    for ( int i = 0; i < 4; ++i )
+        result[i] = c[i];
+}
+
+
+uint32_t RandomUint( const uint64_t seed, const uint64_t index )
+{
+    const uint64_t block = index / 4;
+    const uint32_t counter[4] = { uint32_t( block ), uint32_t( block >> 32 ), 0, 0 };
+    const uint32_t key[2] = { uint32_t( seed ), uint32_t( seed >> 32 ) };
+    uint32_t result[4];
+    Philox4x32( counter, key, result );
+    return result[ index % 4 ];
+}
+
+
+float RandomFloat( const uint64_t seed, const uint64_t index )
+{
+    return UintToFloat( RandomUint( seed, index ) );
+}
+
+
+void FillRandomUints( const uint64_t seed, const uint64_t firstIndex, uint32_t* values, const size_t count )
+{
+    const size_t numBatches = ( count + BatchSize - 1 ) / BatchSize;
+    ParallelFor( numBatches, [&]( const size_t begin, const size_t end )
+    {
+        for ( size_t batch = begin; batch < end; ++batch )
+        {
+            const size_t offset = batch * BatchSize;
+            GenerateBatch( seed, firstIndex + offset, values + offset, std::min( BatchSize, count - offset ) );
+        }
+    }, 4 );
+}
+
+
+void FillRandomFloats( const uint64_t seed, const uint64_t firstIndex, float* values, const size_t count )
+{
+    const size_t numBatches = ( count + BatchSize - 1 ) / BatchSize;
+    ParallelFor( numBatches, [&]( const size_t begin, const size_t end )
+    {
+        uint32_t batchValues[BatchSize];
+        for ( size_t batch = begin; batch < end; ++batch )
+        {
+            const size_t offset = batch * BatchSize;
+            const size_t batchCount = std::min( BatchSize, count - offset );
+            GenerateBatch( seed, firstIndex + offset, batchValues, batchCount );
+            for ( size_t i = 0; i < batchCount; ++i )
+                values[offset + i] = UintToFloat( batchValues[i] );
+        }
+    }, 4 );
+}
+
+
+uint64_t RandomSeed()
+{
+    std::random_device device;
+    return ( uint64_t( device() ) << 32 ) | device();
+}
+
+
+} // namespace svk
@@ -0,0 +1,62 @@
+#ifndef SVK_RANDOM_H
+#define SVK_RANDOM_H
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace svk {
+
+
+// Counter-based random numbers: Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+// Value number index of a stream depends only on ( seed, index ): it is word index%4 of the
+// Philox block with counter index/4 and key seed. There is no shared state, so values can be
+// generated in any order, from any thread, and by shaders/Random.glsl on the GPU.
+void Philox4x32( const uint32_t counter[4], const uint32_t key[2], uint32_t result[4] );
+
+uint32_t RandomUint( const uint64_t seed, const uint64_t index );
+
+// Uniform in [0,1), with 24 bits of precision, exactly as randomFloat in shaders/Random.glsl.
+float RandomFloat( const uint64_t seed, const uint64_t index );
+
+
+// Values firstIndex, firstIndex+1, ... of a stream, generated in SIMD batches under ParallelFor.
+void FillRandomUints( const uint64_t seed, const uint64_t firstIndex, uint32_t* values, const size_t count );
+
+void FillRandomFloats( const uint64_t seed, const uint64_t firstIndex, float* values, const size_t count );
+
+
+// Seed from std::random_device, for runs that should differ.
+uint64_t RandomSeed();
+
+
+// Consecutive values of a stream, for code that just needs the next random number.
+class RandomStream
+{
+public:
+
+    explicit RandomStream( const uint64_t seed = 0, const uint64_t firstIndex = 0 ) :
+        seed( seed ),
+        index( firstIndex )
+    {}
+
+    uint32_t NextUint() { return RandomUint( seed, index++ ); }
+
+    // Uniform in [0,1).
+    float NextFloat() { return RandomFloat( seed, index++ ); }
+
+    // Uniform in [minValue,maxValue).
+    float NextFloat( const float minValue, const float maxValue ) { return minValue + ( maxValue - minValue ) * NextFloat(); }
+
+    uint64_t Seed() const { return seed; }
+    uint64_t Index() const { return index; }
+
+private:
+    uint64_t seed;
+    uint64_t index;
+};
+
+
+} // namespace svk
+
+#endif // SVK_RANDOM_H
@@ -0,0 +1,43 @@
+#include "ReportFormat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+
+namespace svk {
+
+
+double Percentile( const std::vector<double>& sorted, const double fraction )
+{
+    const size_t rank = size_t( std::ceil( fraction * sorted.size() ) );
+    return sorted[ std::min( std::max( rank, size_t( 1 ) ), sorted.size() ) - 1 ];
+}
+
+
+std::string JsonString( const std::string& value )
+{
+    std::string result = "\"";
+    for ( const char c : value )
+    {
+        if ( c == '"' || c == '\\' )
+        {
+            result += '\\';
+            result += c;
+        }
+        else if ( static_cast<unsigned char>( c ) < 0x20 )
+        {
+            char escaped[8];
+            snprintf( escaped, sizeof(escaped), "\\u%04x", unsigned( c ) );
+            result += escaped;
+        }
+        else
+        {
+            result += c;
+        }
+    }
+    return result + "\"";
+}
+
+
+} // namespace svk
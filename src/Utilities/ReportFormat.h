@@ -0,0 +1,22 @@
+#ifndef SVK_REPORTFORMAT_H
+#define SVK_REPORTFORMAT_H
+
+#include <string>
+#include <vector>
+
+
+namespace svk {
+
+
+// Helpers of the measurement reports of FrameBenchmark, GpuProfiler and Trace.
+
+
+// Nearest-rank percentile of sorted values, fraction from [0,1]. The values must not be empty.
+double Percentile( const std::vector<double>& sorted, const double fraction );
+
+// Value as a quoted JSON string, with quotes, backslashes and control characters escaped.
+std::string JsonString( const std::string& value );
+
+} // namespace svk
+
+#endif // SVK_REPORTFORMAT_H
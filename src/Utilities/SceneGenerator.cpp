@@ -0,0 +1,331 @@
+#include "SceneGenerator.h"
+
+#include "CommandLine.h"
+#include "Random.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+
+namespace svk {
+
+
+namespace {
+
+
+const float Pi = 3.14159265358979f;
+
+
+uint32_t ParseCount( int argc, char** argv, const std::string& key, const uint32_t defaultValue )
+{
+    const std::string value = FindCommandLineOption( argc, argv, key );
+    if ( value.empty() )
+        return defaultValue;
+    const long count = std::atol( value.c_str() );
+    if ( count <= 0 )
+        throw std::runtime_error( "SceneOptions: --" + key + " must be a positive count, got " + value );
+    return uint32_t( count );
+}
+
+
+// Uniformly distributed rotation (Shoemake, "Uniform random rotations").
+void RandomRotation( RandomStream& random, float rotation[4] )
+{
+    const float u1 = random.NextFloat();
+    const float u2 = random.NextFloat() * 2.0f * Pi;
+    const float u3 = random.NextFloat() * 2.0f * Pi;
+    const float a = std::sqrt( 1.0f - u1 );
+    const float b = std::sqrt( u1 );
+    rotation[0] = a * std::sin( u2 );
+    rotation[1] = a * std::cos( u2 );
+    rotation[2] = b * std::sin( u3 );
+    rotation[3] = b * std::cos( u3 );
+}
+
+
+void RandomColor( RandomStream& random, uint8_t color[4] )
+{
+    const uint32_t value = random.NextUint();
+    // Bright tints, so that the textures stay visible.
+    color[0] = uint8_t( 128 + ( value & 0x7f ) );
+    color[1] = uint8_t( 128 + ( ( value >> 8 ) & 0x7f ) );
+    color[2] = uint8_t( 128 + ( ( value >> 16 ) & 0x7f ) );
+    color[3] = 255;
+}
+
+
+void HueToRgb( const float hue, float rgb[3] )
+{
+    for ( int i = 0; i < 3; ++i )
+    {
+        const float h = std::fmod( hue + float( i ) / 3.0f, 1.0f );
+        rgb[i] = std::min( std::max( std::fabs( h * 6.0f - 3.0f ) - 1.0f, 0.0f ), 1.0f );
+    }
+}
+
+
+} // namespace
+
+
+const char* SceneKindName( const SceneKind kind )
+{
+    switch ( kind )
+    {
+    case SceneKind::Models: return "models";
+    case SceneKind::Spheres: return "spheres";
+    case SceneKind::Quads: return "quads";
+    case SceneKind::Particles: return "particles";
+    }
+    return "unknown";
+}
+
+
+SceneOptions SceneOptions::FromCommandLine( int argc, char** argv )
+{
+    SceneOptions options;
+
+    const std::string kind = FindCommandLineOption( argc, argv, "scene" );
+    if ( kind == "models" )
+        options.kind = SceneKind::Models;
+    else if ( kind == "spheres" || kind.empty() )
+        options.kind = SceneKind::Spheres;
+    else if ( kind == "quads" )
+        options.kind = SceneKind::Quads;
+    else if ( kind == "particles" )
+        options.kind = SceneKind::Particles;
+    else
+        throw std::runtime_error( "SceneOptions: Unknown --scene=" + kind + ", expected models, spheres, quads or particles." );
+
+    options.numObjects = ParseCount( argc, argv, "objects", options.kind == SceneKind::Particles ? 1000000 : 1000 );
+    options.numTriangles = ParseCount( argc, argv, "triangles", options.numTriangles );
+    options.numTextures = ParseCount( argc, argv, "textures", options.numTextures );
+    options.textureSize = ParseCount( argc, argv, "texture-size", options.textureSize );
+
+    const std::string seed = FindCommandLineOption( argc, argv, "seed" );
+    if ( !seed.empty() )
+        options.seed = std::strtoull( seed.c_str(), nullptr, 10 );
+
+    return options;
+}
+
+
+std::string SceneOptions::Describe() const
+{
+    std::ostringstream description;
+    description << SceneKindName( kind ) << " objects=" << numObjects;
+    if ( kind == SceneKind::Spheres )
+        description << " triangles=" << numTriangles;
+    description << " textures=" << numTextures;
+    return description.str();
+}
+
+
+SceneMesh MakeSphere( const uint32_t numTriangles )
+{
+    // Stacks s and slices 2s give 4s(s-1) triangles, since the pole rows have one triangle per slice.
+    const uint32_t numStacks = std::max( 2u, uint32_t( std::lround( 0.5 + 0.5 * std::sqrt( 1.0 + double( numTriangles ) ) ) ) );
+    const uint32_t numSlices = 2 * numStacks;
+
+    SceneMesh mesh;
+    mesh.vertices.reserve( ( numStacks + 1 ) * ( numSlices + 1 ) );
+    for ( uint32_t i = 0; i <= numStacks; ++i )
+    {
+        const float theta = Pi * float( i ) / float( numStacks );
+        for ( uint32_t j = 0; j <= numSlices; ++j )
+        {
+            const float phi = 2.0f * Pi * float( j ) / float( numSlices );
+            SceneVertex vertex;
+            vertex.pos[0] = std::sin( theta ) * std::sin( phi );
+            vertex.pos[1] = std::cos( theta );
+            vertex.pos[2] = std::sin( theta ) * std::cos( phi );
+            std::copy( vertex.pos, vertex.pos + 3, vertex.normal );
+            vertex.texCoord[0] = float( j ) / float( numSlices );
+            vertex.texCoord[1] = float( i ) / float( numStacks );
+            mesh.vertices.push_back( vertex );
+        }
+    }
+
+    // Counter-clockwise seen from outside.
+    mesh.indices.reserve( 12 * numStacks * ( numStacks - 1 ) );
+    for ( uint32_t i = 0; i < numStacks; ++i )
+    {
+        for ( uint32_t j = 0; j < numSlices; ++j )
+        {
+            const uint32_t a = i * ( numSlices + 1 ) + j;
+            const uint32_t b = a + numSlices + 1;
+            const uint32_t c = b + 1;
+            const uint32_t d = a + 1;
+            if ( i != 0 )
+                mesh.indices.insert( mesh.indices.end(), { a, b, d } );
+            if ( i != numStacks - 1 )
+                mesh.indices.insert( mesh.indices.end(), { d, b, c } );
+        }
+    }
+    return mesh;
+}
+
+
+SceneMesh MakeQuad()
+{
+    SceneMesh mesh;
+    mesh.vertices = {
+        { { -0.5f, -0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f } },
+        { {  0.5f, -0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 1.0f, 1.0f } },
+        { {  0.5f,  0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f } },
+        { { -0.5f,  0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f } },
+    };
+    mesh.indices = {
+        0, 1, 2,   0, 2, 3,
+        0, 2, 1,   0, 3, 2,
+    };
+    return mesh;
+}
+
+
+void NormalizeMesh( SceneMesh& mesh )
+{
+    if ( mesh.vertices.empty() )
+        return;
+
+    float minPos[3], maxPos[3];
+    std::copy( mesh.vertices[0].pos, mesh.vertices[0].pos + 3, minPos );
+    std::copy( mesh.vertices[0].pos, mesh.vertices[0].pos + 3, maxPos );
+    for ( const auto& vertex : mesh.vertices )
+    {
+        for ( int i = 0; i < 3; ++i )
+        {
+            minPos[i] = std::min( minPos[i], vertex.pos[i] );
+            maxPos[i] = std::max( maxPos[i], vertex.pos[i] );
+        }
+    }
+
+    const float center[3] = { 0.5f * ( minPos[0] + maxPos[0] ), 0.5f * ( minPos[1] + maxPos[1] ), 0.5f * ( minPos[2] + maxPos[2] ) };
+    float radius = 0.0f;
+    for ( auto& vertex : mesh.vertices )
+    {
+        for ( int i = 0; i < 3; ++i )
+            vertex.pos[i] -= center[i];
+        radius = std::max( radius, vertex.pos[0] * vertex.pos[0] + vertex.pos[1] * vertex.pos[1] + vertex.pos[2] * vertex.pos[2] );
+    }
+
+    if ( radius == 0.0f )
+        return;
+    const float scale = 1.0f / std::sqrt( radius );
+    for ( auto& vertex : mesh.vertices )
+    {
+        for ( int i = 0; i < 3; ++i )
+            vertex.pos[i] *= scale;
+    }
+}
+
+
+SceneInstances MakeSceneInstances( const SceneOptions& options )
+{
+    if ( options.numObjects == 0 || options.numTextures == 0 )
+        throw std::runtime_error( "MakeSceneInstances: The scene needs objects and textures." );
+
+    RandomStream random( options.seed );
+    std::vector<SceneInstance> instances( options.numObjects );
+
+    if ( options.kind == SceneKind::Particles )
+    {
+        for ( auto& instance : instances )
+        {
+            // Uniform in the unit ball.
+            float x, y, z;
+            do
+            {
+                x = random.NextFloat( -1.0f, 1.0f );
+                y = random.NextFloat( -1.0f, 1.0f );
+                z = random.NextFloat( -1.0f, 1.0f );
+            } while ( x * x + y * y + z * z > 1.0f );
+            instance.offset[0] = x;
+            instance.offset[1] = y;
+            instance.offset[2] = z;
+            instance.scale = random.NextFloat( 0.01f, 0.03f );
+            RandomRotation( random, instance.rotation );
+            RandomColor( random, instance.color );
+        }
+    }
+    else if ( options.kind == SceneKind::Quads )
+    {
+        const uint32_t side = uint32_t( std::ceil( std::sqrt( double( options.numObjects ) ) ) );
+        const float cellSize = 2.0f / float( side );
+        for ( uint32_t i = 0; i < options.numObjects; ++i )
+        {
+            auto& instance = instances[i];
+            instance.offset[0] = -1.0f + cellSize * ( float( i % side ) + 0.5f );
+            instance.offset[1] = -1.0f + cellSize * ( float( i / side ) + 0.5f );
+            instance.offset[2] = 0.0f;
+            instance.scale = 0.9f * cellSize;
+            instance.rotation[0] = instance.rotation[1] = instance.rotation[2] = 0.0f;
+            instance.rotation[3] = 1.0f;
+            RandomColor( random, instance.color );
+        }
+    }
+    else
+    {
+        // Meshes of radius 1, scaled to fit their grid cells.
+        uint32_t side = uint32_t( std::ceil( std::cbrt( double( options.numObjects ) ) ) );
+        while ( uint64_t( side ) * side * side < options.numObjects )
+            ++side;
+        const float cellSize = 2.0f / float( side );
+        for ( uint32_t i = 0; i < options.numObjects; ++i )
+        {
+            auto& instance = instances[i];
+            instance.offset[0] = -1.0f + cellSize * ( float( i % side ) + 0.5f );
+            instance.offset[1] = -1.0f + cellSize * ( float( i / side % side ) + 0.5f );
+            instance.offset[2] = -1.0f + cellSize * ( float( i / side / side ) + 0.5f );
+            instance.scale = 0.45f * cellSize;
+            RandomRotation( random, instance.rotation );
+            RandomColor( random, instance.color );
+        }
+    }
+
+    // Round-robin textures, then grouped so that each texture is one draw.
+    SceneInstances result;
+    result.firstInstance.assign( options.numTextures + 1, 0 );
+    for ( uint32_t i = 0; i < options.numObjects; ++i )
+    {
+        instances[i].texture = i % options.numTextures;
+        ++result.firstInstance[instances[i].texture + 1];
+    }
+    for ( uint32_t t = 0; t < options.numTextures; ++t )
+        result.firstInstance[t + 1] += result.firstInstance[t];
+
+    result.instances.resize( instances.size() );
+    std::vector<uint32_t> next( result.firstInstance.begin(), result.firstInstance.end() - 1 );
+    for ( const auto& instance : instances )
+        result.instances[next[instance.texture]++] = instance;
+
+    return result;
+}
+
+
+std::vector<uint8_t> MakeSceneTexture( const uint32_t size, const uint32_t textureIndex, const uint64_t seed )
+{
+    // Golden ratio steps spread the hues of consecutive textures.
+    float light[3];
+    HueToRgb( std::fmod( RandomFloat( seed, textureIndex ) + 0.618034f * float( textureIndex ), 1.0f ), light );
+    const uint32_t cellSize = std::max( 1u, size >> ( 2 + textureIndex % 4 ) );
+
+    std::vector<uint8_t> pixels( size_t( size ) * size * 4 );
+    for ( uint32_t y = 0; y < size; ++y )
+    {
+        for ( uint32_t x = 0; x < size; ++x )
+        {
+            const bool isLight = ( ( x / cellSize ) + ( y / cellSize ) ) % 2 == 0;
+            uint8_t* pixel = &pixels[4 * ( size_t( y ) * size + x )];
+            for ( int i = 0; i < 3; ++i )
+                pixel[i] = uint8_t( 255.0f * ( isLight ? 0.5f + 0.5f * light[i] : 0.25f * light[i] ) );
+            pixel[3] = 255;
+        }
+    }
+    return pixels;
+}
+
+
+} // namespace svk
@@ -0,0 +1,109 @@
+#ifndef SVK_SCENEGENERATOR_H
+#define SVK_SCENEGENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace svk {
+
+
+// Procedural scenes for scaling measurements: many instances of one mesh, grouped by texture.
+// Everything is deterministic for a given seed, so runs with the same options draw the same frames.
+
+
+enum class SceneKind
+{
+    Models,    // Instances of a loaded model, e.g. media/viking_room.obj.
+    Spheres,   // Instances of a sphere tessellated to the requested triangle count.
+    Quads,     // Planar grid of textured quads, as in Task 3.
+    Particles, // Cloud of small quads filling the view, as in Task 5, for fragment and overdraw load.
+};
+
+const char* SceneKindName( const SceneKind kind );
+
+
+// Scene parameters, swept by the scaling benchmarks.
+//
+//     --scene=models|spheres|quads|particles   Kind of scene (default spheres).
+//     --objects=count           Instances (default 1000, a million for particles).
+//     --triangles=count         Triangles per sphere (default 1000).
+//     --textures=count          Textures, each drawn by its own draw item (default 1).
+//     --texture-size=pixels     Side of the generated textures (default 256).
+//     --seed=value              Seed of placements and textures (default 1).
+struct SceneOptions
+{
+    SceneKind kind = SceneKind::Spheres;
+    uint32_t numObjects = 1000;
+    uint32_t numTriangles = 1000;
+    uint32_t numTextures = 1;
+    uint32_t textureSize = 256;
+    uint64_t seed = 1;
+
+    static SceneOptions FromCommandLine( int argc, char** argv );
+
+    // Short description like "spheres objects=1000 triangles=1000 textures=1", for reports.
+    std::string Describe() const;
+};
+
+
+struct SceneVertex
+{
+    float pos[3];
+    float normal[3];
+    float texCoord[2];
+};
+
+
+struct SceneMesh
+{
+    std::vector<SceneVertex> vertices;
+    std::vector<uint32_t> indices;
+
+    size_t NumTriangles() const { return indices.size() / 3; }
+};
+
+
+// Per-instance vertex data: the mesh is rotated, scaled and then moved.
+struct SceneInstance
+{
+    float offset[3];
+    float scale;
+    float rotation[4];  // Unit quaternion x, y, z, w.
+    uint8_t color[4];   // Unorm tint, multiplied with the texture.
+    uint32_t texture;
+};
+
+
+// Instances grouped by texture: those of texture t are [firstInstance[t], firstInstance[t+1]).
+struct SceneInstances
+{
+    std::vector<SceneInstance> instances;
+    std::vector<uint32_t> firstInstance;
+};
+
+
+// UV sphere of radius 1 with at least 8 and about numTriangles triangles.
+SceneMesh MakeSphere( const uint32_t numTriangles );
+
+// Unit quad in the XY plane, with both windings so that it is visible from both sides.
+SceneMesh MakeQuad();
+
+// Centers the mesh at the origin and scales it to radius 1.
+void NormalizeMesh( SceneMesh& mesh );
+
+
+// Instances of options.kind inside [-1,1]^3, the XY plane for quads, in instance order
+// of a regular grid (random rotations and tints) or of a random cloud for particles.
+SceneInstances MakeSceneInstances( const SceneOptions& options );
+
+
+// RGBA8 checkerboard with a hue and cell size that differ per texture index.
+std::vector<uint8_t> MakeSceneTexture( const uint32_t size, const uint32_t textureIndex, const uint64_t seed );
+
+
+} // namespace svk
+
+#endif // SVK_SCENEGENERATOR_H
@@ -0,0 +1,59 @@
+#ifndef SVK_SPSCQUEUE_H
+#define SVK_SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+
+namespace svk {
+
+
+// Lock-free single producer, single consumer queue of fixed capacity (a power of two).
+// Push() is called from one thread, Pop() from another; neither side ever waits.
+template< typename T, size_t Capacity >
+class SpscQueue
+{
+    static_assert( Capacity > 0 && ( Capacity & ( Capacity - 1 ) ) == 0, "SpscQueue: Capacity must be a power of two." );
+
+public:
+
+    SpscQueue() = default;
+
+    SpscQueue( const SpscQueue& ) = delete;
+
+
+    // Producer side. Returns false, dropping the value, if the queue is full.
+    bool Push( const T& value )
+    {
+        const size_t tail = tailIndex.load( std::memory_order_relaxed );
+        if ( tail - headIndex.load( std::memory_order_acquire ) == Capacity )
+            return false;
+        items[tail & ( Capacity - 1 )] = value;
+        tailIndex.store( tail + 1, std::memory_order_release );
+        return true;
+    }
+
+
+    // Consumer side. Returns false if the queue is empty.
+    bool Pop( T& value )
+    {
+        const size_t head = headIndex.load( std::memory_order_relaxed );
+        if ( head == tailIndex.load( std::memory_order_acquire ) )
+            return false;
+        value = items[head & ( Capacity - 1 )];
+        headIndex.store( head + 1, std::memory_order_release );
+        return true;
+    }
+
+
+private:
+    T items[Capacity];
+    // On separate cache lines, so the two sides do not contend.
+    alignas(64) std::atomic<size_t> headIndex{ 0 };
+    alignas(64) std::atomic<size_t> tailIndex{ 0 };
+};
+
+
+} // namespace svk
+
+#endif // SVK_SPSCQUEUE_H
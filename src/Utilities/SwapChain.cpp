@@ -2,19 +2,23 @@
 #include "VulkanContext.h"
 #include "VulkanBase.h"
 #include "CommandPool.h"
+#include "GpuProfiler.h"
 #include "Image.h"
+#include "Trace.h"
 
 #include <stdexcept>
 #include <array>
+#include <algorithm>
+#include <cstring>
 
 
 namespace svk {
 
-void SwapChainInfo::Update()
+void SwapChainInfo::Update( const VkExtent2D& framebufferSize )
 {
-    const auto window = theVulkanContext().Window();
     const auto surface = theVulkanContext().Surface();
     const auto physicalDevice = theVulkanContext().PhysicalDevice();
+    const auto& policy = theVulkanContext().GetPresentPolicy();
 
     const auto support = QuerySwapChainSupport( physicalDevice, surface );
     capabilities = support.capabilities;
@@ -23,15 +27,24 @@ void SwapChainInfo::Update()
 
     surfaceFormat = ChooseSwapSurfaceFormat( support.formats );
     imageFormat = surfaceFormat.format;
-    presentMode = ChooseSwapPresentMode( support.presentModes );
-    extent = ChooseSwapExtent( window, support.capabilities );
+    presentMode = ChooseSwapPresentMode( support.presentModes, policy.presentModes );
+    extent = ChooseSwapExtent( framebufferSize, support.capabilities );
 
-    numEntries = support.capabilities.minImageCount + 1;
+    numEntries = ( policy.numImages > 0 ) ? policy.numImages : support.capabilities.minImageCount + 1;
+    numEntries = std::max( numEntries, support.capabilities.minImageCount );
     if ( support.capabilities.maxImageCount > 0 && numEntries > support.capabilities.maxImageCount )
         numEntries = support.capabilities.maxImageCount;
 }
 
 
+uint64_t MakeDrawSortKey( const DrawItem& item )
+{
+    if ( item.pipeline >= (1u << 16) || item.material >= (1u << 24) || item.mesh >= (1u << 24) )
+        throw std::runtime_error( "MakeDrawSortKey: Draw item index is out of range." );
+    return ( uint64_t( item.pipeline ) << 48 ) | ( uint64_t( item.material ) << 24 ) | uint64_t( item.mesh );
+}
+
+
 SwapChain::~SwapChain()
 {
     const auto device = theVulkanContext().LogicalDevice();
@@ -42,6 +55,10 @@ SwapChain::~SwapChain()
         vkDestroyDescriptorSetLayout( device, descriptorSetLayout, nullptr );
     descriptorSetLayout = VK_NULL_HANDLE;
 
+    if ( pipelineCache != VK_NULL_HANDLE )
+        vkDestroyPipelineCache( device, pipelineCache, nullptr );
+    pipelineCache = VK_NULL_HANDLE;
+
     for ( auto& entry : fenceEntries )
     {
         vkDestroySemaphore( device, entry.renderFinishedSemaphore, nullptr );
@@ -57,16 +74,32 @@ SwapChain::~SwapChain()
 
 void SwapChain::DrawFrame()
 {
+    SVK_TRACE_SCOPE( "DrawFrame" );
+
     const auto device = theVulkanContext().LogicalDevice();
     const auto presentQueue = theVulkanContext().PresentQueue();
     const int maxFramesInFlight = theVulkanContext().MaxFramesInFlight();
 
+    if ( IsMinimized() )
+        return;
+
+    frameTimings.start = FrameTimings::Clock::now();
+
     auto& fenceEntry = fenceEntries[currentFrame];
 
-    vkWaitForFences( device, 1, &fenceEntry.inFlightFence, VK_TRUE, UINT64_MAX );
+    flushMeshBuffers();
+
+    {
+        SVK_TRACE_SCOPE( "WaitForFrameFence" );
+        vkWaitForFences( device, 1, &fenceEntry.inFlightFence, VK_TRUE, UINT64_MAX );
+    }
 
     uint32_t imageIndex;
-    VkResult result = vkAcquireNextImageKHR( device, swapChain, UINT64_MAX, fenceEntry.imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex );
+    VkResult result;
+    {
+        SVK_TRACE_SCOPE( "AcquireNextImage" );
+        result = vkAcquireNextImageKHR( device, swapChain, UINT64_MAX, fenceEntry.imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex );
+    }
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR) {
         recreateSwapChain();
@@ -77,17 +110,35 @@ void SwapChain::DrawFrame()
 
     auto& swapChainEntry = swapChainEntries[imageIndex];
 
-    renderEntryManager->UpdateRenderEntry( swapChainInfo, swapChainEntry, imageIndex );
-
+    // The entry's resources are free once the frame that last used it is done.
     if ( swapChainEntry.imageInFlight != VK_NULL_HANDLE )
+    {
+        SVK_TRACE_SCOPE( "WaitForImageFence" );
         vkWaitForFences( device, 1, &swapChainEntry.imageInFlight, VK_TRUE, UINT64_MAX );
+    }
     swapChainEntry.imageInFlight = fenceEntry.inFlightFence;
 
+    frameTimings.acquired = FrameTimings::Clock::now();
+    {
+        SVK_TRACE_SCOPE( "UpdateRenderEntry" );
+        renderEntryManager->UpdateRenderEntry( swapChainInfo, swapChainEntry, imageIndex );
+    }
+
+    uploadInstanceData( imageIndex );
+    recordCommandBuffer( imageIndex );
+
     const std::vector<VkSemaphore> waitSemaphores = { fenceEntry.imageAvailableSemaphore };
     const std::vector<VkPipelineStageFlags> waitStages = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
     const std::vector<VkSemaphore> signalSemaphores = { fenceEntry.renderFinishedSemaphore };
 
+    frameTimings.inputSampled = FrameTimings::Clock::now();
+    {
+        SVK_TRACE_SCOPE( "LatchRenderEntry" );
+        renderEntryManager->LatchRenderEntry( swapChainInfo, swapChainEntry, imageIndex );
+    }
+
     theVulkanContext().SubmitGraphicsQueue( swapChainEntry.commandBuffer, waitSemaphores, waitStages, signalSemaphores, fenceEntry.inFlightFence );
+    frameTimings.submitted = FrameTimings::Clock::now();
 
     VkPresentInfoKHR presentInfo{};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -101,7 +152,12 @@ void SwapChain::DrawFrame()
 
     presentInfo.pImageIndices = &imageIndex;
 
-    result = vkQueuePresentKHR(presentQueue, &presentInfo);
+    {
+        SVK_TRACE_SCOPE( "Present" );
+        result = vkQueuePresentKHR(presentQueue, &presentInfo);
+    }
+    frameTimings.presented = FrameTimings::Clock::now();
+    lastFrameTimings = frameTimings;
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized) {
         framebufferResized = false;
@@ -114,28 +170,45 @@ void SwapChain::DrawFrame()
 }
 
 
-void SwapChain::Init_Internal( std::shared_ptr<CommandPool> commandPool, RenderEntryManager* renderEntryManager, const std::vector<uint32_t>& indices, const VkDeviceSize vertexBufferSize, const void* vertexBufferData, const std::string& vertShaderPath, const std::string& fragShaderPath )
+void SwapChain::Init_Internal( std::shared_ptr<CommandPool> commandPool, RenderEntryManager* renderEntryManager, const std::vector<uint32_t>& indices, const size_t vertexStride, const size_t numVertices, const void* vertexData, const std::string& vertShaderPath, const std::string& fragShaderPath )
 {
     this->commandPool = commandPool;
     this->renderEntryManager = renderEntryManager;
     this->window = theVulkanContext().Window();
-    this->vertShaderPath = vertShaderPath;
-    this->fragShaderPath = fragShaderPath;
+    this->pipelineShaders = { { vertShaderPath, fragShaderPath } };
 
-    swapChainInfo.Update();
+    if ( framebufferSize.width == 0 && framebufferSize.height == 0 && window != nullptr )
+    {
+        int width = 0, height = 0;
+        glfwGetFramebufferSize( window, &width, &height );
+        SetFramebufferSize( uint32_t( width ), uint32_t( height ) );
+    }
+
+    swapChainInfo.Update( framebufferSize );
     renderEntryManager->InitRenderEntries( swapChainInfo );
     createRenderPass();
     createDescriptorSetLayout();
-    createGraphicsPipeline();
+    createPipelineCache();
+    createGraphicsPipelines();
     createDepthResources();
     createDescriptorPool();
     createSwapChain();
     createImageViews();
     createFramebuffers();
     createDescriptorSets();
-    resetVertexIndexBuffer( indices, vertexBufferSize, vertexBufferData );
+    resetVertexIndexBuffer( indices, vertexStride, numVertices, vertexData );
     createCommandBuffers();
     createSyncObjects();
+    if ( profiler )
+        profiler->Reset( uint32_t( swapChainEntries.size() ) );
+}
+
+
+void SwapChain::SetProfiler( std::shared_ptr<GpuProfiler> profiler )
+{
+    this->profiler = profiler;
+    if ( profiler && !swapChainEntries.empty() )
+        profiler->Reset( uint32_t( swapChainEntries.size() ) );
 }
 
 
@@ -153,7 +226,11 @@ void SwapChain::cleanupSwapChain()
     }
     swapChainEntries.clear();
 
-    vkDestroyPipeline(device, graphicsPipeline, nullptr);
+    cleanupInstanceBuffers();
+
+    for ( auto& pipeline : graphicsPipelines )
+        vkDestroyPipeline( device, pipeline, nullptr );
+    graphicsPipelines.clear();
     vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
     vkDestroyRenderPass(device, renderPass, nullptr);
 
@@ -168,14 +245,15 @@ void SwapChain::cleanupSwapChain()
 
 void SwapChain::recreateSwapChain()
 {
+    SVK_TRACE_SCOPE( "RecreateSwapChain" );
+
     const auto device = theVulkanContext().LogicalDevice();
 
-    int width = 0, height = 0;
-    glfwGetFramebufferSize( window, &width, &height );
-    while (width == 0 || height == 0)
+    // Minimized: recreate once the window is restored and drawing resumes.
+    if ( IsMinimized() )
     {
-        glfwGetFramebufferSize( window, &width, &height );
-        glfwWaitEvents();
+        framebufferResized = true;
+        return;
     }
 
     vkDeviceWaitIdle( device );
@@ -185,13 +263,15 @@ void SwapChain::recreateSwapChain()
     createSwapChain();
     createImageViews();
     createRenderPass();
-    createGraphicsPipeline();
+    createGraphicsPipelines();
     createDepthResources();
     createFramebuffers();
     renderEntryManager->InitRenderEntries( swapChainInfo );
     createDescriptorPool();
     createDescriptorSets();
     createCommandBuffers();
+    if ( profiler )
+        profiler->Reset( uint32_t( swapChainEntries.size() ) );
 }
 
 
@@ -203,7 +283,7 @@ void SwapChain::createSwapChain()
     const auto graphicsFamily = theVulkanContext().GraphicsFamily();
     const auto presentFamily = theVulkanContext().PresentFamily();
 
-    swapChainInfo.Update();
+    swapChainInfo.Update( framebufferSize );
 
     VkSwapchainCreateInfoKHR createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
@@ -326,12 +406,59 @@ void SwapChain::createDescriptorSetLayout()
 }
 
 
-void SwapChain::createGraphicsPipeline()
+void SwapChain::createPipelineCache()
+{
+    const auto device = theVulkanContext().LogicalDevice();
+
+    VkPipelineCacheCreateInfo cacheInfo{};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+    if ( vkCreatePipelineCache( device, &cacheInfo, nullptr, &pipelineCache ) != VK_SUCCESS )
+        throw std::runtime_error( "failed to create pipeline cache!" );
+}
+
+
+void SwapChain::createGraphicsPipelines()
+{
+    const auto device = theVulkanContext().LogicalDevice();
+
+    // Draw item transform.
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = DrawItemPushConstantSize;
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    if ( descriptorSetLayout != VK_NULL_HANDLE )
+    {
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+    }
+    else
+    {
+        pipelineLayoutInfo.setLayoutCount = 0;
+        pipelineLayoutInfo.pSetLayouts = VK_NULL_HANDLE;
+    }
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline layout!");
+    }
+
+    graphicsPipelines.clear();
+    for ( const auto& shaders : pipelineShaders )
+        graphicsPipelines.push_back( createGraphicsPipeline( shaders ) );
+}
+
+
+VkPipeline SwapChain::createGraphicsPipeline( const PipelineShaders& shaders )
 {
     const auto device = theVulkanContext().LogicalDevice();
 
-    auto vertShaderCode = LoadShaderCode( vertShaderPath );
-    auto fragShaderCode = LoadShaderCode( fragShaderPath );
+    auto vertShaderCode = LoadShaderCode( shaders.vertShaderPath );
+    auto fragShaderCode = LoadShaderCode( shaders.fragShaderPath );
 
     VkShaderModule vertShaderModule = CreateShaderModule( device, vertShaderCode );
     VkShaderModule fragShaderModule = CreateShaderModule( device, fragShaderCode );
@@ -353,12 +480,12 @@ void SwapChain::createGraphicsPipeline()
     VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
     vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
-    auto bindingDescription = renderEntryManager->getVertexBindingDescription();
+    auto bindingDescriptions = renderEntryManager->getVertexBindingDescriptions();
     auto attributeDescriptions = renderEntryManager->getVertexAttributeDescriptions();
 
-    vertexInputInfo.vertexBindingDescriptionCount = 1;
+    vertexInputInfo.vertexBindingDescriptionCount = bindingDescriptions.size();
     vertexInputInfo.vertexAttributeDescriptionCount = attributeDescriptions.size();
-    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+    vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
     vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 
     VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
@@ -423,23 +550,6 @@ void SwapChain::createGraphicsPipeline()
     colorBlending.blendConstants[2] = 0.0f;
     colorBlending.blendConstants[3] = 0.0f;
 
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    if ( descriptorSetLayout != VK_NULL_HANDLE )
-    {
-        pipelineLayoutInfo.setLayoutCount = 1;
-        pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
-    }
-    else
-    {
-        pipelineLayoutInfo.setLayoutCount = 0;
-        pipelineLayoutInfo.pSetLayouts = VK_NULL_HANDLE;
-    }
-
-    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create pipeline layout!");
-    }
-
     VkGraphicsPipelineCreateInfo pipelineInfo{};
     pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
     pipelineInfo.stageCount = 2;
@@ -456,12 +566,24 @@ void SwapChain::createGraphicsPipeline()
     pipelineInfo.subpass = 0;
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+    VkPipeline graphicsPipeline = VK_NULL_HANDLE;
+    if (vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
         throw std::runtime_error("failed to create graphics pipeline!");
     }
 
     vkDestroyShaderModule(device, fragShaderModule, nullptr);
     vkDestroyShaderModule(device, vertShaderModule, nullptr);
+
+    return graphicsPipeline;
+}
+
+
+uint32_t SwapChain::AddGraphicsPipeline( const std::string& vertShaderPath, const std::string& fragShaderPath )
+{
+    pipelineShaders.push_back( { vertShaderPath, fragShaderPath } );
+    if ( pipelineLayout != VK_NULL_HANDLE )
+        graphicsPipelines.push_back( createGraphicsPipeline( pipelineShaders.back() ) );
+    return static_cast<uint32_t>( pipelineShaders.size() - 1 );
 }
 
 void SwapChain::createFramebuffers()
@@ -553,43 +675,169 @@ void SwapChain::createDescriptorSets()
 void SwapChain::createCommandBuffers()
 {
     for ( auto& entry : swapChainEntries )
-    {
         entry.commandBuffer = commandPool->CreateCommandBuffer();
-        CommandPool::BeginCommandBuffer( entry.commandBuffer, false );
+}
 
-        VkRenderPassBeginInfo renderPassInfo{};
-        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderPassInfo.renderPass = renderPass;
-        renderPassInfo.framebuffer = entry.framebuffer;
-        renderPassInfo.renderArea.offset = {0, 0};
-        renderPassInfo.renderArea.extent = swapChainInfo.extent;
 
-        std::array<VkClearValue, 2> clearValues{};
-        clearValues[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
-        clearValues[1].depthStencil = {1.0f, 0};
+void SwapChain::recordCommandBuffer( const uint32_t swapEntryIndex )
+{
+    SVK_TRACE_SCOPE( "RecordCommandBuffer" );
 
-        renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-        renderPassInfo.pClearValues = clearValues.data();
+    const auto& entry = swapChainEntries[swapEntryIndex];
 
-        vkCmdBeginRenderPass( entry.commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE );
+    CommandPool::BeginCommandBuffer( entry.commandBuffer, true );
 
-        vkCmdBindPipeline( entry.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline );
+    if ( profiler )
+    {
+        profiler->BeginFrame( entry.commandBuffer, swapEntryIndex );
+        profiler->BeginRegion( entry.commandBuffer, "frame" );
+    }
 
-        if ( entry.descriptorSet != VK_NULL_HANDLE )
-            vkCmdBindDescriptorSets( entry.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &entry.descriptorSet, 0, nullptr );
+    recordMeshUpdates( entry.commandBuffer, swapEntryIndex );
 
-        VkBuffer vertexBuffers[] = {vertexBuffer};
-        VkDeviceSize offsets[] = {0};
-        vkCmdBindVertexBuffers( entry.commandBuffer, 0, 1, vertexBuffers, offsets );
-        vkCmdBindIndexBuffer( entry.commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32 );
-        vkCmdDrawIndexed( entry.commandBuffer, numDrawIndices, 1, 0, 0, 0 );
+    if ( profiler )
+        profiler->BeginRegion( entry.commandBuffer, "pre-render pass", true );
 
-        vkCmdEndRenderPass( entry.commandBuffer );
+    renderEntryManager->RecordPreRenderPassCommands( entry.commandBuffer, swapEntryIndex );
 
-        CommandPool::EndCommandBuffer( entry.commandBuffer );
+    if ( profiler )
+    {
+        profiler->EndRegion( entry.commandBuffer );
+        profiler->BeginRegion( entry.commandBuffer, "render pass", true );
     }
+
+    VkRenderPassBeginInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = renderPass;
+    renderPassInfo.framebuffer = entry.framebuffer;
+    renderPassInfo.renderArea.offset = {0, 0};
+    renderPassInfo.renderArea.extent = swapChainInfo.extent;
+
+    std::array<VkClearValue, 2> clearValues{};
+    clearValues[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
+    clearValues[1].depthStencil = {1.0f, 0};
+
+    renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+    renderPassInfo.pClearValues = clearValues.data();
+
+    vkCmdBeginRenderPass( entry.commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE );
+
+    // All pipelines share the layout, so descriptor sets stay bound across pipeline changes.
+    if ( entry.descriptorSet != VK_NULL_HANDLE )
+        vkCmdBindDescriptorSets( entry.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &entry.descriptorSet, 0, nullptr );
+
+    VkBuffer vertexBuffers[] = {vertexBuffer.Handle()};
+    VkDeviceSize offsets[] = {0};
+    vkCmdBindVertexBuffers( entry.commandBuffer, 0, 1, vertexBuffers, offsets );
+    vkCmdBindIndexBuffer( entry.commandBuffer, indexBuffer.Handle(), 0, indexType );
+
+    for ( size_t i = 0; i < instanceStreams.size(); ++i )
+    {
+        const auto& stream = instanceStreams[i];
+        if ( stream.externalBuffer != VK_NULL_HANDLE )
+            vkCmdBindVertexBuffers( entry.commandBuffer, stream.binding, 1, &stream.externalBuffer, &stream.externalOffset );
+        else
+            vkCmdBindVertexBuffers( entry.commandBuffer, stream.binding, 1, &instanceBuffers[swapEntryIndex][i].buffer->Handle(), offsets );
+    }
+
+    const DrawItem* previousItem = nullptr;
+    for ( const auto& item : drawList )
+    {
+        if ( previousItem == nullptr || item.pipeline != previousItem->pipeline )
+            vkCmdBindPipeline( entry.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipelines[item.pipeline] );
+        if ( previousItem == nullptr || item.material != previousItem->material )
+            renderEntryManager->BindMaterial( entry.commandBuffer, pipelineLayout, item.material, swapEntryIndex );
+
+        vkCmdPushConstants( entry.commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, DrawItemPushConstantSize, item.transform );
+
+        const auto& mesh = meshes[item.mesh];
+        vkCmdDrawIndexed( entry.commandBuffer, mesh.numIndices, item.numInstances, mesh.firstIndex, mesh.vertexOffset, item.firstInstance );
+        previousItem = &item;
+    }
+
+    vkCmdEndRenderPass( entry.commandBuffer );
+
+    if ( profiler )
+        profiler->EndRegion( entry.commandBuffer );
+
+    renderEntryManager->RecordPostRenderPassCommands( entry.commandBuffer, swapEntryIndex );
+
+    if ( profiler )
+        profiler->EndRegion( entry.commandBuffer );
+
+    CommandPool::EndCommandBuffer( entry.commandBuffer );
+}
+
+
+void SwapChain::SetDrawList( const std::vector<DrawItem>& drawItems )
+{
+    for ( const auto& item : drawItems )
+    {
+        if ( item.pipeline >= pipelineShaders.size() )
+            throw std::runtime_error( "SwapChain: Draw item refers to unknown pipeline." );
+        if ( item.mesh >= meshes.size() )
+            throw std::runtime_error( "SwapChain: Draw item refers to unknown mesh." );
+    }
+    for ( const auto& stream : instanceStreams )
+        checkInstanceRanges( drawItems, stream.numInstances );
+
+    drawList = drawItems;
+    std::stable_sort( drawList.begin(), drawList.end(), []( const DrawItem& a, const DrawItem& b )
+    {
+        return MakeDrawSortKey( a ) < MakeDrawSortKey( b );
+    } );
+}
+
+
+
+void SwapChain::recordMeshUpdates( const VkCommandBuffer commandBuffer, const uint32_t swapEntryIndex )
+{
+    if ( pendingMeshUpdates.empty() )
+        return;
+
+    SVK_TRACE_SCOPE( "RecordMeshUpdates" );
+
+    if ( meshStagingBuffers.size() != swapChainEntries.size() )
+    {
+        meshStagingBuffers.clear();
+        meshStagingBuffers.resize( swapChainEntries.size() );
+    }
+
+    VkDeviceSize stagingSize = 0;
+    for ( const uint32_t mesh : pendingMeshUpdates )
+        stagingSize += VkDeviceSize( meshes[mesh].numVertices ) * meshVertexStride;
+
+    // Entry is not in flight here, so its staging buffer can be reallocated and written directly.
+    auto& staging = meshStagingBuffers[swapEntryIndex];
+    if ( !staging || stagingSize > staging->Size() )
+    {
+        const VkDeviceSize capacity = std::max( stagingSize, staging ? 2 * staging->Size() : VkDeviceSize( 0 ) );
+        staging = std::make_unique<Buffer>( capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+    }
+
+    std::vector<VkBufferCopy> regions;
+    VkDeviceSize stagingOffset = 0;
+    for ( const uint32_t mesh : pendingMeshUpdates )
+    {
+        const auto& range = meshes[mesh];
+        VkBufferCopy region{};
+        region.srcOffset = stagingOffset;
+        region.dstOffset = VkDeviceSize( range.vertexOffset ) * meshVertexStride;
+        region.size = VkDeviceSize( range.numVertices ) * meshVertexStride;
+        memcpy( static_cast<uint8_t*>( staging->Mapped() ) + region.srcOffset, meshVertexData.data() + region.dstOffset, region.size );
+        regions.push_back( region );
+        stagingOffset += region.size;
+    }
+    pendingMeshUpdates.clear();
+
+    // Earlier frames may still read the old vertices, the rest of this frame reads the new ones.
+    const VkPipelineStageFlags readStages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    cmdBufferBarrier( commandBuffer, vertexBuffer.Handle(), readStages, 0, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT );
+    vkCmdCopyBuffer( commandBuffer, staging->Handle(), vertexBuffer.Handle(), uint32_t( regions.size() ), regions.data() );
+    cmdBufferBarrier( commandBuffer, vertexBuffer.Handle(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, readStages, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT );
 }
 
+
 void SwapChain::createSyncObjects()
 {
     const auto device = theVulkanContext().LogicalDevice();
@@ -644,84 +892,225 @@ VkFormat SwapChain::findDepthFormat() {
 }
 
 
-void SwapChain::resetVertexIndexBuffer( const std::vector<uint32_t>& indices, const VkDeviceSize vertexBufferSize, const void* vertexBufferData )
+void SwapChain::resetVertexIndexBuffer( const std::vector<uint32_t>& indices, const size_t vertexStride, const size_t numVertices, const void* vertexData )
 {
-    const auto device = theVulkanContext().LogicalDevice();
+    meshes.clear();
+    meshVertexData.clear();
+    meshIndexData.clear();
+    meshVertexStride = 0;
+
+    registerMesh( indices, vertexStride, numVertices, vertexData );
+    drawList = { DrawItem{} };
+    flushMeshBuffers();
+}
 
+
+uint32_t SwapChain::registerMesh( const std::vector<uint32_t>& indices, const size_t vertexStride, const size_t numVertices, const void* vertexData )
+{
     if ( indices.size() == 0 )
         throw std::runtime_error( "Index buffer has zero size." );
-    if ( vertexBufferSize == 0 )
+    if ( numVertices == 0 || vertexStride == 0 )
         throw std::runtime_error( "Vertex buffer has zero size." );
+    if ( meshVertexStride != 0 && meshVertexStride != vertexStride )
+        throw std::runtime_error( "SwapChain: All meshes must use the same vertex type." );
+    for ( const uint32_t index : indices )
+    {
+        if ( index >= numVertices )
+            throw std::runtime_error( "SwapChain: Mesh index is out of vertex range." );
+    }
 
-    cleanupVertexIndexBuffers();
+    MeshRange mesh;
+    mesh.firstIndex = static_cast<uint32_t>( meshIndexData.size() );
+    mesh.numIndices = static_cast<uint32_t>( indices.size() );
+    mesh.vertexOffset = static_cast<int32_t>( meshVertexData.size() / vertexStride );
+    mesh.numVertices = static_cast<uint32_t>( numVertices );
 
-    VkBuffer stagingBuffer = VK_NULL_HANDLE;
-    VkDeviceMemory stagingBufferMemory = VK_NULL_HANDLE;
-    void* data = nullptr;
+    meshVertexStride = vertexStride;
+    const uint8_t* bytes = static_cast<const uint8_t*>( vertexData );
+    meshVertexData.insert( meshVertexData.end(), bytes, bytes + numVertices * vertexStride );
+    meshIndexData.insert( meshIndexData.end(), indices.begin(), indices.end() );
+    areMeshBuffersDirty = true;
 
-    numDrawIndices = indices.size();
+    meshes.push_back( mesh );
+    return static_cast<uint32_t>( meshes.size() - 1 );
+}
 
-    // Create vertex buffer.
-    createBuffer( vertexBufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer, vertexBufferMemory );
-    uploadVertexData( vertexBufferSize, vertexBufferData );
 
-    // Create index buffer.
-    const VkDeviceSize indexBufferSize = sizeof(indices[0]) * indices.size();
-    createBuffer( indexBufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, indexBufferMemory );
-    uploadIndexData( indices );
+void SwapChain::updateMeshVertices( const uint32_t mesh, const size_t vertexStride, const size_t numVertices, const void* vertexData )
+{
+    if ( mesh >= meshes.size() )
+        throw std::runtime_error( "SwapChain: Unknown mesh." );
+    const auto& range = meshes[mesh];
+    if ( vertexStride != meshVertexStride || numVertices != range.numVertices )
+        throw std::runtime_error( "SwapChain: Updated vertices do not match the registered mesh." );
+
+    const VkDeviceSize offset = VkDeviceSize( range.vertexOffset ) * vertexStride;
+    const VkDeviceSize size = VkDeviceSize( numVertices ) * vertexStride;
+    memcpy( meshVertexData.data() + offset, vertexData, size );
+
+    // Otherwise the whole buffer is uploaded by the next flush.
+    if ( !areMeshBuffersDirty && std::find( pendingMeshUpdates.begin(), pendingMeshUpdates.end(), mesh ) == pendingMeshUpdates.end() )
+        pendingMeshUpdates.push_back( mesh );
 }
 
-void SwapChain::uploadIndexData( const std::vector<uint32_t>& indices )
+
+void SwapChain::flushMeshBuffers()
 {
-    const auto device = theVulkanContext().LogicalDevice();
-    VkBuffer stagingBuffer = VK_NULL_HANDLE;
-    VkDeviceMemory stagingBufferMemory = VK_NULL_HANDLE;
-    void* data = nullptr;
-    const VkDeviceSize indexBufferSize = sizeof(indices[0]) * indices.size();
-    createBuffer( indexBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory );
-    vkMapMemory(device, stagingBufferMemory, 0, indexBufferSize, 0, &data );
-    memcpy( data, indices.data(), indexBufferSize );
-    vkUnmapMemory( device, stagingBufferMemory );
-    copyBuffer( *commandPool, stagingBuffer, indexBuffer, indexBufferSize );
-    vkDestroyBuffer( device, stagingBuffer, nullptr );
-    vkFreeMemory( device, stagingBufferMemory, nullptr );
+    SVK_TRACE_SCOPE( "FlushMeshBuffers" );
+
+    if ( !areMeshBuffersDirty )
+        return;
+
+    uint32_t maxMeshVertices = 0;
+    for ( const auto& mesh : meshes )
+        maxMeshVertices = std::max( maxMeshVertices, mesh.numVertices );
+    indexType = ( maxMeshVertices < 65536 ) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+
+    const VkDeviceSize vertexBufferSize = meshVertexData.size();
+    const VkDeviceSize indexSize = ( indexType == VK_INDEX_TYPE_UINT16 ) ? sizeof(uint16_t) : sizeof(uint32_t);
+    const VkDeviceSize indexBufferSize = indexSize * meshIndexData.size();
+
+    // Frames in flight may still read the buffers.
+    vkDeviceWaitIdle( theVulkanContext().LogicalDevice() );
+
+    // Buffers grow geometrically, so that registering meshes one by one does not reallocate every time.
+    // Each buffer is only recreated when its own data outgrows it.
+    if ( vertexBufferSize > vertexBuffer.Size() )
+        vertexBuffer.Reset( std::max( vertexBufferSize, 2 * vertexBuffer.Size() ), VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT );
+    if ( indexBufferSize > indexBuffer.Size() )
+        indexBuffer.Reset( std::max( indexBufferSize, 2 * indexBuffer.Size() ), VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT );
+
+    vertexBuffer.Upload( *commandPool, meshVertexData.data(), vertexBufferSize );
+
+    if ( indexType == VK_INDEX_TYPE_UINT16 )
+    {
+        std::vector<uint16_t> shortIndices( meshIndexData.begin(), meshIndexData.end() );
+        indexBuffer.Upload( *commandPool, shortIndices.data(), indexBufferSize );
+    }
+    else
+    {
+        indexBuffer.Upload( *commandPool, meshIndexData.data(), indexBufferSize );
+    }
+
+    areMeshBuffersDirty = false;
+    pendingMeshUpdates.clear();
 }
 
-void SwapChain::uploadVertexData( const VkDeviceSize vertexBufferSize, const void* vertexBufferData )
+
+void SwapChain::checkInstanceRanges( const std::vector<DrawItem>& drawItems, const size_t numInstances )
 {
-    const auto device = theVulkanContext().LogicalDevice();
-    VkBuffer stagingBuffer = VK_NULL_HANDLE;
-    VkDeviceMemory stagingBufferMemory = VK_NULL_HANDLE;
-    void* data = nullptr;
-    createBuffer( vertexBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory );
-    vkMapMemory( device, stagingBufferMemory, 0, vertexBufferSize, 0, &data );
-    memcpy( data, vertexBufferData, vertexBufferSize );
-    vkUnmapMemory( device, stagingBufferMemory );
-    copyBuffer( *commandPool, stagingBuffer, vertexBuffer, vertexBufferSize );
-    vkDestroyBuffer( device, stagingBuffer, nullptr );
-    vkFreeMemory( device, stagingBufferMemory, nullptr );
+    for ( const auto& item : drawItems )
+    {
+        if ( size_t( item.firstInstance ) + item.numInstances > numInstances )
+            throw std::runtime_error( "SwapChain: Draw item instances are out of instance data range." );
+    }
 }
 
 
-void SwapChain::cleanupVertexIndexBuffers()
+SwapChain::InstanceStream& SwapChain::instanceStream( const uint32_t binding, const size_t instanceStride )
 {
-    const auto device = theVulkanContext().LogicalDevice();
+    if ( binding == 0 )
+        throw std::runtime_error( "SwapChain: Binding 0 is the mesh vertex stream." );
 
-    if ( indexBuffer != VK_NULL_HANDLE )
-        vkDestroyBuffer( device, indexBuffer, nullptr );
-    indexBuffer = VK_NULL_HANDLE;
+    bool isInstanceBinding = false;
+    for ( const auto& description : renderEntryManager->getVertexBindingDescriptions() )
+    {
+        if ( description.binding == binding )
+            isInstanceBinding = ( description.inputRate == VK_VERTEX_INPUT_RATE_INSTANCE && ( instanceStride == 0 || description.stride == instanceStride ) );
+    }
+    if ( !isInstanceBinding )
+        throw std::runtime_error( "SwapChain: Instance data does not match an instance rate vertex binding." );
 
-    if ( indexBufferMemory != VK_NULL_HANDLE )
-        vkFreeMemory( device, indexBufferMemory, nullptr );
-    indexBufferMemory = VK_NULL_HANDLE;
+    auto stream = std::find_if( instanceStreams.begin(), instanceStreams.end(), [binding]( const InstanceStream& s ) { return s.binding == binding; } );
+    if ( stream == instanceStreams.end() )
+    {
+        instanceStreams.emplace_back();
+        stream = instanceStreams.end() - 1;
+        stream->binding = binding;
+    }
+    return *stream;
+}
 
-    if ( vertexBuffer != VK_NULL_HANDLE )
-        vkDestroyBuffer( device, vertexBuffer, nullptr );
-    vertexBuffer = VK_NULL_HANDLE;
 
-    if ( vertexBufferMemory != VK_NULL_HANDLE )
-        vkFreeMemory( device, vertexBufferMemory, nullptr );
-    vertexBufferMemory = VK_NULL_HANDLE;
+void SwapChain::setInstanceData( const uint32_t binding, const size_t instanceStride, const size_t numInstances, const void* instanceData )
+{
+    checkInstanceRanges( drawList, numInstances );
+    auto& stream = instanceStream( binding, instanceStride );
+
+    const uint8_t* bytes = static_cast<const uint8_t*>( instanceData );
+    stream.data.assign( bytes, bytes + numInstances * instanceStride );
+    stream.numInstances = numInstances;
+    stream.externalBuffer = VK_NULL_HANDLE;
+    stream.externalOffset = 0;
+    ++stream.version;
+}
+
+
+void SwapChain::SetInstanceBuffer( const uint32_t binding, const VkBuffer buffer, const size_t numInstances, const VkDeviceSize offset )
+{
+    if ( buffer == VK_NULL_HANDLE )
+        throw std::runtime_error( "SwapChain: Instance buffer is null." );
+
+    checkInstanceRanges( drawList, numInstances );
+    // Stride is given by the binding description.
+    auto& stream = instanceStream( binding, 0 );
+    stream.data.clear();
+    stream.numInstances = numInstances;
+    stream.externalBuffer = buffer;
+    stream.externalOffset = offset;
+    ++stream.version;
+}
+
+
+void SwapChain::uploadInstanceData( const uint32_t swapEntryIndex )
+{
+    SVK_TRACE_SCOPE( "UploadInstanceData" );
+
+    if ( instanceBuffers.size() != swapChainEntries.size() )
+    {
+        cleanupInstanceBuffers();
+        instanceBuffers.resize( swapChainEntries.size() );
+    }
+
+    auto& entryBuffers = instanceBuffers[swapEntryIndex];
+    entryBuffers.resize( instanceStreams.size() );
+    for ( size_t i = 0; i < instanceStreams.size(); ++i )
+    {
+        const auto& stream = instanceStreams[i];
+        auto& instanceBuffer = entryBuffers[i];
+        if ( stream.externalBuffer != VK_NULL_HANDLE )
+            continue;
+        if ( instanceBuffer.buffer && instanceBuffer.version == stream.version )
+            continue;
+
+        // Entry is not in flight here, so its buffers can be reallocated and written directly.
+        const VkDeviceSize size = stream.data.size();
+        if ( !instanceBuffer.buffer || size > instanceBuffer.buffer->Size() )
+        {
+            const VkDeviceSize capacity = std::max( std::max( size, instanceBuffer.buffer ? 2 * instanceBuffer.buffer->Size() : VkDeviceSize( 0 ) ), VkDeviceSize( 256 ) );
+            instanceBuffer.buffer = std::make_unique<Buffer>( capacity, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+        }
+
+        if ( size > 0 )
+            memcpy( instanceBuffer.buffer->Mapped(), stream.data.data(), size );
+        instanceBuffer.version = stream.version;
+    }
+}
+
+
+void SwapChain::cleanupInstanceBuffers()
+{
+    instanceBuffers.clear();
+}
+
+
+void SwapChain::cleanupVertexIndexBuffers()
+{
+    indexBuffer.Clear();
+    vertexBuffer.Clear();
+
+    pendingMeshUpdates.clear();
+    meshStagingBuffers.clear();
 }
 
 
@@ -1,7 +1,10 @@
 #ifndef SVK_SWAPCHAIN_H
 #define SVK_SWAPCHAIN_H
 
+#include "Buffer.h"
+
 #include <vulkan/vulkan.h>
+#include <chrono>
 #include <vector>
 #include <memory>
 #include <string>
@@ -13,6 +16,7 @@ namespace svk {
 
 
 class CommandPool;
+class GpuProfiler;
 class Image;
 
 
@@ -46,9 +50,52 @@ struct SwapChainInfo
     VkExtent2D extent;
     uint32_t numEntries;
 
-    void Update();
+    // Extent follows the surface, or the framebuffer size where the surface leaves it to the app.
+    void Update( const VkExtent2D& framebufferSize );
+};
+
+
+// Range of a mesh inside the shared vertex and index buffers of SwapChain.
+struct MeshRange
+{
+    uint32_t firstIndex = 0;
+    uint32_t numIndices = 0;
+    int32_t vertexOffset = 0;
+    uint32_t numVertices = 0;
+};
+
+
+// Single draw of the SwapChain draw list.
+struct DrawItem
+{
+    uint32_t pipeline = 0; // Index from SwapChain::AddGraphicsPipeline, 0 is the pipeline given to Init.
+    uint32_t material = 0; // Passed to RenderEntryManager::BindMaterial whenever it changes.
+    uint32_t mesh = 0;     // Index from SwapChain::RegisterMesh, 0 is the mesh given to Init.
+    uint32_t firstInstance = 0; // Range of per-instance data, see SwapChain::SetInstanceData.
+    uint32_t numInstances = 1;
+    float transform[16] = { 1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1 }; // Column-major, vertex stage push constant at offset 0.
 };
 
+const uint32_t DrawItemPushConstantSize = 16 * sizeof(float);
+
+
+// Points in time of one SwapChain::DrawFrame.
+struct FrameTimings
+{
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point start;
+    Clock::time_point acquired;     // Image acquired, UpdateRenderEntry called.
+    Clock::time_point inputSampled; // LatchRenderEntry called, right before submit.
+    Clock::time_point submitted;
+    Clock::time_point presented;    // vkQueuePresentKHR returned, the image is queued for display.
+};
+
+
+// Pipeline in the highest bits, then material, then mesh,
+// so that sorted draw items change as little state as possible.
+uint64_t MakeDrawSortKey( const DrawItem& item );
+
 
 class RenderEntryManager
 {
@@ -56,6 +103,13 @@ public:
     virtual VkVertexInputBindingDescription getVertexBindingDescription() const = 0;
     virtual std::vector<VkVertexInputAttributeDescription> getVertexAttributeDescriptions() const = 0;
 
+    // Binding 0 is the mesh vertex stream. Override to add VK_VERTEX_INPUT_RATE_INSTANCE bindings,
+    // whose data is given by SwapChain::SetInstanceData.
+    virtual std::vector<VkVertexInputBindingDescription> getVertexBindingDescriptions() const
+    {
+        return { getVertexBindingDescription() };
+    }
+
     virtual std::vector<VkDescriptorSetLayoutBinding> getDescriptorBindings() const
     {
         return {};
@@ -80,6 +134,34 @@ public:
     {
         return;
     }
+
+    // Called after the command buffer is recorded, right before it is submitted, and after the GPU
+    // is done with the entry. Data that should be as fresh as possible, like the camera from input,
+    // is written here to persistently mapped memory read by the recorded commands.
+    virtual void LatchRenderEntry( const SwapChainInfo& swapChainInfo, const SwapChainEntry& swapChainEntry, const int swapEntryIndex )
+    {
+        return;
+    }
+
+    // Called while recording the draw list, before the first draw item and whenever the material changes.
+    virtual void BindMaterial( const VkCommandBuffer commandBuffer, const VkPipelineLayout pipelineLayout, const uint32_t material, const int swapEntryIndex )
+    {
+        return;
+    }
+
+    // Called at the start of the command buffer, outside the render pass.
+    // Compute dispatches and the barriers to their consumers are recorded here.
+    virtual void RecordPreRenderPassCommands( const VkCommandBuffer commandBuffer, const int swapEntryIndex )
+    {
+        return;
+    }
+
+    // Called at the end of the command buffer, after the render pass.
+    // Barriers that make shader writes visible to the host, for readback once the entry's frame is done, go here.
+    virtual void RecordPostRenderPassCommands( const VkCommandBuffer commandBuffer, const int swapEntryIndex )
+    {
+        return;
+    }
 };
 
 
@@ -89,6 +171,7 @@ public:
 
     SwapChain() = default;
 
+    // Vertices and indices become mesh 0, drawn with the given shaders as pipeline 0.
     template< typename Vertex >
     void Init(
         std::shared_ptr<CommandPool> commandPool,
@@ -98,8 +181,7 @@ public:
         const std::string& vertShaderPath,
         const std::string& fragShaderPath )
     {
-        const VkDeviceSize vertexBufferSize = sizeof(Vertex) * vertices.size();
-        Init_Internal( commandPool, renderEntryManager, indices, vertexBufferSize, vertices.data(), vertShaderPath, fragShaderPath );
+        Init_Internal( commandPool, renderEntryManager, indices, sizeof(Vertex), vertices.size(), vertices.data(), vertShaderPath, fragShaderPath );
     }
 
     ~SwapChain();
@@ -111,30 +193,129 @@ public:
         framebufferResized = true;
     }
 
+    // Window framebuffer size, as reported by the window events.
+    // Nothing is drawn while it is zero, i.e. while the window is minimized.
+    void SetFramebufferSize( const uint32_t width, const uint32_t height )
+    {
+        framebufferSize = { width, height };
+    }
+
+    bool IsMinimized() const
+    {
+        return framebufferSize.width == 0 || framebufferSize.height == 0;
+    }
+
+    // Profiles the frame command buffers: regions "frame", "pre-render pass" and "render pass",
+    // the last two with pipeline statistics. Null disables profiling.
+    void SetProfiler( std::shared_ptr<GpuProfiler> profiler );
+
+    // For extra regions recorded by RenderEntryManager hooks. Null if profiling is disabled.
+    GpuProfiler* Profiler() const
+    {
+        return profiler.get();
+    }
+
+    // Of the last frame that was presented.
+    const FrameTimings& LastFrameTimings() const
+    {
+        return lastFrameTimings;
+    }
+
+    // Replaces all meshes by a single mesh 0 and resets the draw list to drawing it.
     template< typename Vertex >
     void ResetVertexIndexBuffer(
         const std::vector<Vertex>& vertices,
         const std::vector<uint32_t>& indices )
     {
-        const VkDeviceSize vertexBufferSize = sizeof(Vertex) * vertices.size();
-        resetVertexIndexBuffer( indices, vertexBufferSize, vertices.data() );
+        resetVertexIndexBuffer( indices, sizeof(Vertex), vertices.size(), vertices.data() );
     }
 
     template< typename Vertex >
     void ReuploadVertexBuffer( const std::vector<Vertex>& vertices )
     {
-        const VkDeviceSize vertexBufferSize = sizeof(Vertex) * vertices.size();
-        uploadVertexData( vertexBufferSize, vertices.data() );
+        UpdateMeshVertices( 0, vertices );
+    }
+
+
+    // Appends a mesh to the shared vertex and index buffers. All meshes must use the same vertex type.
+    // Indices are local to the mesh. Returns the mesh index for DrawItem::mesh.
+    template< typename Vertex >
+    uint32_t RegisterMesh(
+        const std::vector<Vertex>& vertices,
+        const std::vector<uint32_t>& indices )
+    {
+        return registerMesh( indices, sizeof(Vertex), vertices.size(), vertices.data() );
     }
 
+    // Overwrites the vertices of a registered mesh, keeping their count. The new vertices are copied
+    // by the command buffer of the next frame, so frames in flight are not waited for.
+    template< typename Vertex >
+    void UpdateMeshVertices( const uint32_t mesh, const std::vector<Vertex>& vertices )
+    {
+        updateMeshVertices( mesh, sizeof(Vertex), vertices.size(), vertices.data() );
+    }
+
+    const MeshRange& Mesh( const uint32_t mesh ) const { return meshes.at( mesh ); }
+
+    // Shared mesh buffers, also usable as storage buffers. They are recreated when meshes are registered.
+    VkBuffer VertexBuffer() const { return vertexBuffer.Handle(); }
+    VkBuffer IndexBuffer() const { return indexBuffer.Handle(); }
+    VkIndexType IndexType() const { return indexType; }
+
+    // Sets per-instance data of a vertex binding. It is copied to a host-visible buffer
+    // of the next drawn swap chain entry, so it can be changed every frame.
+    template< typename Instance >
+    void SetInstanceData( const uint32_t binding, const std::vector<Instance>& instances )
+    {
+        setInstanceData( binding, sizeof(Instance), instances.size(), instances.data() );
+    }
+
+    // Uses an app-owned buffer as per-instance data of a vertex binding, e.g. written by a compute shader.
+    // The buffer must have VERTEX_BUFFER usage and outlive its use; synchronizing writes is up to the app.
+    void SetInstanceBuffer( const uint32_t binding, const VkBuffer buffer, const size_t numInstances, const VkDeviceSize offset = 0 );
+
+    // Layout of the descriptor set of getDescriptorBindings, for app-allocated sets of the same bindings,
+    // e.g. per material sets bound by RenderEntryManager::BindMaterial. Valid from Init on.
+    VkDescriptorSetLayout DescriptorSetLayout() const { return descriptorSetLayout; }
+
+    // Pipeline with the same layout and vertex input as pipeline 0. Returns the index for DrawItem::pipeline.
+    uint32_t AddGraphicsPipeline( const std::string& vertShaderPath, const std::string& fragShaderPath );
+
+    // Replaces the draw list. Items are sorted by MakeDrawSortKey and recorded every frame.
+    // Instance ranges must lie within the data of every instance stream, see SetInstanceData.
+    void SetDrawList( const std::vector<DrawItem>& drawItems );
+
 
 private:
+    struct PipelineShaders
+    {
+        std::string vertShaderPath;
+        std::string fragShaderPath;
+    };
+
+    struct InstanceStream
+    {
+        uint32_t binding = 0;
+        size_t numInstances = 0;
+        std::vector<uint8_t> data;
+        uint64_t version = 0;
+        VkBuffer externalBuffer = VK_NULL_HANDLE; // Used instead of data, if set.
+        VkDeviceSize externalOffset = 0;
+    };
+
+    struct InstanceBuffer
+    {
+        std::unique_ptr<Buffer> buffer; // Host-visible and coherent, written through its mapping.
+        uint64_t version = 0; // Version of the stream data in the buffer.
+    };
+
     void Init_Internal(
         std::shared_ptr<CommandPool> commandPool,
         RenderEntryManager* renderEntryManager,
         const std::vector<uint32_t>& indices,
-        const VkDeviceSize vertexBufferSize,
-        const void* vertexBufferData,
+        const size_t vertexStride,
+        const size_t numVertices,
+        const void* vertexData,
         const std::string& vertShaderPath,
         const std::string& fragShaderPath
     );
@@ -145,12 +326,16 @@ private:
     void createImageViews();
     void createRenderPass();
     void createDescriptorSetLayout();
-    void createGraphicsPipeline();
+    void createPipelineCache();
+    void createGraphicsPipelines();
+    VkPipeline createGraphicsPipeline( const PipelineShaders& shaders );
     void createFramebuffers();
     void createDepthResources();
     void createDescriptorPool();
     void createDescriptorSets();
     void createCommandBuffers();
+    void recordCommandBuffer( const uint32_t swapEntryIndex );
+    void recordMeshUpdates( const VkCommandBuffer commandBuffer, const uint32_t swapEntryIndex );
     void createSyncObjects();
 
     VkFormat findSupportedFormat( const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features );
@@ -158,12 +343,46 @@ private:
 
     void resetVertexIndexBuffer(
         const std::vector<uint32_t>& indices,
-        const VkDeviceSize vertexBufferSize,
-        const void* vertexBufferData
+        const size_t vertexStride,
+        const size_t numVertices,
+        const void* vertexData
+    );
+
+    uint32_t registerMesh(
+        const std::vector<uint32_t>& indices,
+        const size_t vertexStride,
+        const size_t numVertices,
+        const void* vertexData
+    );
+
+    void updateMeshVertices(
+        const uint32_t mesh,
+        const size_t vertexStride,
+        const size_t numVertices,
+        const void* vertexData
     );
 
-    void uploadIndexData( const std::vector<uint32_t>& indices );
-    void uploadVertexData( const VkDeviceSize vertexBufferSize, const void* vertexBufferData );
+    // Uploads the CPU copies of meshes to the GPU, if meshes were registered since the last upload.
+    // Index buffer is stored as 16-bit when every mesh has fewer than 65536 vertices.
+    void flushMeshBuffers();
+
+    // Throws if a draw item reads past the given number of instances.
+    static void checkInstanceRanges( const std::vector<DrawItem>& drawItems, const size_t numInstances );
+
+    // Stream of an instance rate vertex binding, created on first use.
+    InstanceStream& instanceStream( const uint32_t binding, const size_t instanceStride );
+
+    void setInstanceData(
+        const uint32_t binding,
+        const size_t instanceStride,
+        const size_t numInstances,
+        const void* instanceData
+    );
+
+    // Copies changed instance streams to the buffers of the given swap chain entry.
+    void uploadInstanceData( const uint32_t swapEntryIndex );
+
+    void cleanupInstanceBuffers();
 
     void cleanupVertexIndexBuffers();
 
@@ -171,8 +390,7 @@ private:
 
     GLFWwindow* window = nullptr;
 
-    std::string vertShaderPath;
-    std::string fragShaderPath;
+    std::vector<PipelineShaders> pipelineShaders;
 
     VkSwapchainKHR swapChain = VK_NULL_HANDLE;
     SwapChainInfo swapChainInfo = {};
@@ -184,14 +402,29 @@ private:
     VkRenderPass renderPass = VK_NULL_HANDLE;
     VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
     VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
-    VkPipeline graphicsPipeline = VK_NULL_HANDLE;
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+    std::vector<VkPipeline> graphicsPipelines;
 
-    VkBuffer vertexBuffer = VK_NULL_HANDLE;
-    VkDeviceMemory vertexBufferMemory = VK_NULL_HANDLE;
-    VkBuffer indexBuffer = VK_NULL_HANDLE;
-    VkDeviceMemory indexBufferMemory = VK_NULL_HANDLE;
+    // Shared buffers of all registered meshes, with their CPU copies.
+    Buffer vertexBuffer;
+    Buffer indexBuffer;
+    VkIndexType indexType = VK_INDEX_TYPE_UINT32;
 
-    uint32_t numDrawIndices = 0;
+    size_t meshVertexStride = 0;
+    std::vector<uint8_t> meshVertexData;
+    std::vector<uint32_t> meshIndexData;
+    std::vector<MeshRange> meshes;
+    bool areMeshBuffersDirty = false;
+
+    // Meshes whose vertices changed since the last recorded frame, copied through
+    // a staging buffer of the swap chain entry that records them.
+    std::vector<uint32_t> pendingMeshUpdates;
+    std::vector<std::unique_ptr<Buffer>> meshStagingBuffers; // Per swap chain entry.
+
+    std::vector<DrawItem> drawList;
+
+    std::vector<InstanceStream> instanceStreams;
+    std::vector<std::vector<InstanceBuffer>> instanceBuffers; // Per swap chain entry, per instance stream.
 
     std::shared_ptr<CommandPool> commandPool;
     VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
@@ -201,6 +434,12 @@ private:
     size_t currentFrame = 0;
 
     bool framebufferResized = false;
+    VkExtent2D framebufferSize = { 0, 0 };
+
+    FrameTimings frameTimings;
+    FrameTimings lastFrameTimings;
+
+    std::shared_ptr<GpuProfiler> profiler;
 };
 
 
@@ -0,0 +1,251 @@
+#include "Trace.h"
+#include "ReportFormat.h"
+
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+
+namespace svk {
+
+
+namespace detail {
+
+std::atomic<bool> isTracing{ false };
+
+} // namespace detail
+
+
+namespace {
+
+
+struct TraceEvent
+{
+    const char* name;
+    uint64_t beginTicks;
+    uint64_t endTicks;
+};
+
+
+const uint32_t ChunkSize = 4096;
+const size_t MaxChunksPerThread = 256; // About a million events, later ones are dropped.
+const size_t NumSpareChunks = 64; // Kept ready by StartTracing, about 256k events.
+
+
+// Written by its thread only. The count is published after the events,
+// so a concurrent WriteTraceFile reads complete events.
+struct TraceChunk
+{
+    TraceEvent events[ChunkSize];
+    std::atomic<uint32_t> count{ 0 };
+    std::atomic<TraceChunk*> next{ nullptr };
+};
+
+
+struct ThreadBuffer
+{
+    uint32_t threadId = 0;
+    std::string name; // Guarded by the registry mutex.
+    TraceChunk* head = nullptr;
+    // Used by the owning thread only.
+    TraceChunk* tail = nullptr;
+    size_t numChunks = 0;
+
+    ~ThreadBuffer()
+    {
+        while ( head != nullptr )
+        {
+            TraceChunk* next = head->next.load();
+            delete head;
+            head = next;
+        }
+    }
+};
+
+
+// Buffers outlive their threads, so that events of finished threads are still written.
+struct TraceRegistry
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> threads;
+    // Taken together in StartTracing, to convert ticks to time.
+    uint64_t startTicks = 0;
+    uint64_t startNs = 0;
+    // Chunks for threads that fill theirs, allocated and zeroed by StartTracing. Their pages are
+    // faulted in already, which would otherwise cost about as much as the recording itself.
+    std::vector<std::unique_ptr<TraceChunk>> spareChunks;
+};
+
+
+TraceRegistry& Registry()
+{
+    static TraceRegistry registry;
+    return registry;
+}
+
+
+// Call with the registry mutex locked.
+TraceChunk* NewChunk( TraceRegistry& registry )
+{
+    if ( registry.spareChunks.empty() )
+        return new TraceChunk();
+    TraceChunk* chunk = registry.spareChunks.back().release();
+    registry.spareChunks.pop_back();
+    return chunk;
+}
+
+
+ThreadBuffer& LocalBuffer()
+{
+    thread_local ThreadBuffer* buffer = nullptr;
+    if ( buffer == nullptr )
+    {
+        auto& registry = Registry();
+        std::lock_guard<std::mutex> lock( registry.mutex );
+        registry.threads.emplace_back( new ThreadBuffer() );
+        buffer = registry.threads.back().get();
+        buffer->threadId = uint32_t( registry.threads.size() );
+        buffer->head = NewChunk( registry );
+        buffer->tail = buffer->head;
+        buffer->numChunks = 1;
+    }
+    return *buffer;
+}
+
+
+} // namespace
+
+
+bool IsTracingCompiledIn()
+{
+#if defined(SVK_ENABLE_TRACING)
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+void StartTracing()
+{
+    auto& registry = Registry();
+    {
+        std::lock_guard<std::mutex> lock( registry.mutex );
+        while ( registry.spareChunks.size() < NumSpareChunks )
+            registry.spareChunks.emplace_back( new TraceChunk() );
+        if ( registry.startNs == 0 )
+        {
+            registry.startTicks = detail::TraceTicks();
+            registry.startNs = detail::TraceNowNs();
+        }
+    }
+    detail::isTracing = true;
+}
+
+
+void StopTracing()
+{
+    detail::isTracing = false;
+}
+
+
+void WriteTraceFile( const std::string& path )
+{
+    std::ofstream file( path );
+    if ( !file )
+        throw std::runtime_error( "WriteTraceFile: Failed to open " + path );
+
+    auto& registry = Registry();
+    std::lock_guard<std::mutex> lock( registry.mutex );
+    if ( registry.startNs == 0 )
+        throw std::runtime_error( "WriteTraceFile: Tracing was never started" );
+
+    // Tick rate over the whole trace, at least 10 ms for a precise rate.
+    const uint64_t minCalibrationNs = 10000000;
+    const uint64_t elapsedNs = detail::TraceNowNs() - registry.startNs;
+    if ( elapsedNs < minCalibrationNs )
+        std::this_thread::sleep_for( std::chrono::nanoseconds( minCalibrationNs - elapsedNs ) );
+    const uint64_t endTicks = detail::TraceTicks();
+    const uint64_t endNs = detail::TraceNowNs();
+    const double microsecondsPerTick = 1e-3 * double( endNs - registry.startNs ) / double( endTicks - registry.startTicks );
+
+    // Microseconds since StartTracing.
+    const auto toMicroseconds = [&]( const uint64_t ticks ) { return double( ticks - registry.startTicks ) * microsecondsPerTick; };
+
+    file << std::fixed << std::setprecision( 3 );
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool isFirst = true;
+    for ( const auto& thread : registry.threads )
+    {
+        if ( !thread->name.empty() )
+        {
+            file << ( isFirst ? "\n" : ",\n" ) << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->threadId << ",\"args\":{\"name\":" << JsonString( thread->name ) << "}}";
+            isFirst = false;
+        }
+
+        for ( const TraceChunk* chunk = thread->head; chunk != nullptr; chunk = chunk->next.load( std::memory_order_acquire ) )
+        {
+            const uint32_t count = chunk->count.load( std::memory_order_acquire );
+            for ( uint32_t i = 0; i < count; ++i )
+            {
+                const auto& event = chunk->events[i];
+                if ( event.beginTicks < registry.startTicks )
+                    continue;
+                file << ( isFirst ? "\n" : ",\n" ) << "{\"name\":" << JsonString( event.name )
+                    << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->threadId
+                    << ",\"ts\":" << toMicroseconds( event.beginTicks )
+                    << ",\"dur\":" << double( event.endTicks - event.beginTicks ) * microsecondsPerTick << "}";
+                isFirst = false;
+            }
+        }
+    }
+    file << "\n]}\n";
+}
+
+
+void SetTraceThreadName( const std::string& name )
+{
+    auto& buffer = LocalBuffer();
+    std::lock_guard<std::mutex> lock( Registry().mutex );
+    buffer.name = name;
+}
+
+
+namespace detail {
+
+
+void RecordTraceEvent( const char* name, const uint64_t beginTicks, const uint64_t endTicks )
+{
+    auto& buffer = LocalBuffer();
+    TraceChunk* chunk = buffer.tail;
+    uint32_t count = chunk->count.load( std::memory_order_relaxed );
+    if ( count == ChunkSize )
+    {
+        if ( buffer.numChunks == MaxChunksPerThread )
+            return;
+        // Locks once per chunk.
+        TraceChunk* next;
+        {
+            auto& registry = Registry();
+            std::lock_guard<std::mutex> lock( registry.mutex );
+            next = NewChunk( registry );
+        }
+        chunk->next.store( next, std::memory_order_release );
+        buffer.tail = next;
+        ++buffer.numChunks;
+        chunk = next;
+        count = 0;
+    }
+    chunk->events[count] = { name, beginTicks, endTicks };
+    chunk->count.store( count + 1, std::memory_order_release );
+}
+
+
+} // namespace detail
+
+
+} // namespace svk
@@ -0,0 +1,102 @@
+#ifndef SVK_TRACE_H
+#define SVK_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#if defined(_MSC_VER) && ( defined(_M_X64) || defined(_M_IX86) )
+#include <intrin.h>
+#define SVK_TRACE_TSC
+#elif ( defined(__GNUC__) || defined(__clang__) ) && ( defined(__x86_64__) || defined(__i386__) )
+#include <x86intrin.h>
+#define SVK_TRACE_TSC
+#endif
+
+
+// CPU tracing: SVK_TRACE_SCOPE( "name" ) records the time spent in the rest of the enclosing scope,
+// while tracing is started. Events go to lock-free per-thread buffers, and WriteTraceFile saves them
+// as Chrome trace JSON, viewable in chrome://tracing and ui.perfetto.dev.
+// Scopes compile to nothing unless SVK_ENABLE_TRACING is defined (CMake option SVK_ENABLE_TRACING).
+// Names must be string literals, or otherwise outlive the trace.
+// Microbenchmarks --suite=trace measures the cost of a scope, stopped and recording.
+#if defined(SVK_ENABLE_TRACING)
+#define SVK_TRACE_CONCAT_INNER( a, b ) a##b
+#define SVK_TRACE_CONCAT( a, b ) SVK_TRACE_CONCAT_INNER( a, b )
+#define SVK_TRACE_SCOPE( name ) const svk::TraceScope SVK_TRACE_CONCAT( svkTraceScope, __LINE__ )( name )
+#define SVK_TRACE_THREAD_NAME( name ) svk::SetTraceThreadName( name )
+#else
+#define SVK_TRACE_SCOPE( name ) ( (void)0 )
+#define SVK_TRACE_THREAD_NAME( name ) ( (void)0 )
+#endif
+
+
+namespace svk {
+
+
+// True if the scope macros record events, i.e. SVK_ENABLE_TRACING is defined.
+bool IsTracingCompiledIn();
+
+// Scopes entered after StartTracing are recorded, until StopTracing.
+void StartTracing();
+void StopTracing();
+
+// Writes the events recorded so far. Other threads may keep recording meanwhile.
+void WriteTraceFile( const std::string& path );
+
+// Name of the calling thread in the trace.
+void SetTraceThreadName( const std::string& name );
+
+
+namespace detail {
+
+extern std::atomic<bool> isTracing;
+
+inline uint64_t TraceNowNs()
+{
+    return uint64_t( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() );
+}
+
+// Timestamp of a scope boundary. On x86 this is the time stamp counter, which costs about half a
+// steady_clock read; WriteTraceFile converts ticks to time with a rate measured against steady_clock.
+inline uint64_t TraceTicks()
+{
+#if defined(SVK_TRACE_TSC)
+    return __rdtsc();
+#else
+    return TraceNowNs();
+#endif
+}
+
+void RecordTraceEvent( const char* name, const uint64_t beginTicks, const uint64_t endTicks );
+
+} // namespace detail
+
+
+class TraceScope
+{
+public:
+
+    explicit TraceScope( const char* name ) :
+        name( name ),
+        beginTicks( detail::isTracing.load( std::memory_order_relaxed ) ? detail::TraceTicks() : 0 )
+    {}
+
+    TraceScope( const TraceScope& ) = delete;
+
+    ~TraceScope()
+    {
+        if ( beginTicks != 0 )
+            detail::RecordTraceEvent( name, beginTicks, detail::TraceTicks() );
+    }
+
+private:
+    const char* name;
+    uint64_t beginTicks;
+};
+
+
+} // namespace svk
+
+#endif // SVK_TRACE_H
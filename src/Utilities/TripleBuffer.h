@@ -0,0 +1,66 @@
+#ifndef SVK_TRIPLEBUFFER_H
+#define SVK_TRIPLEBUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+
+namespace svk {
+
+
+// Lock-free single producer, single consumer exchange of the latest value.
+// The writer fills WriteBuffer() and publishes it; the reader picks up the most recently
+// published buffer with Update(). Neither side ever waits, and intermediate values may be skipped.
+template< typename T >
+class TripleBuffer
+{
+public:
+
+    TripleBuffer() = default;
+
+    TripleBuffer( const TripleBuffer& ) = delete;
+
+    // Initial contents of all three buffers.
+    explicit TripleBuffer( const T& value ) :
+        buffers{ value, value, value }
+    {}
+
+
+    // Writer side.
+
+    T& WriteBuffer() { return buffers[writeIndex]; }
+
+    void Publish()
+    {
+        writeIndex = middle.exchange( uint8_t( writeIndex | DirtyBit ), std::memory_order_acq_rel ) & IndexMask;
+    }
+
+
+    // Reader side.
+
+    // Returns true if a new buffer was published since the last call.
+    bool Update()
+    {
+        if ( ( middle.load( std::memory_order_relaxed ) & DirtyBit ) == 0 )
+            return false;
+        readIndex = middle.exchange( readIndex, std::memory_order_acq_rel ) & IndexMask;
+        return true;
+    }
+
+    const T& ReadBuffer() const { return buffers[readIndex]; }
+
+
+private:
+    static const uint8_t IndexMask = 0x3;
+    static const uint8_t DirtyBit = 0x4;
+
+    T buffers[3];
+    uint8_t writeIndex = 0;
+    uint8_t readIndex = 1;
+    std::atomic<uint8_t> middle{ 2 }; // Index of the buffer in exchange, with DirtyBit if not read yet.
+};
+
+
+} // namespace svk
+
+#endif // SVK_TRIPLEBUFFER_H
@@ -0,0 +1,178 @@
+#include "VertexQuantization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+
+namespace svk {
+
+
+uint16_t FloatToHalf( const float value )
+{
+    uint32_t bits;
+    memcpy( &bits, &value, sizeof(bits) );
+    const uint32_t sign = ( bits >> 16 ) & 0x8000;
+    const uint32_t absBits = bits & 0x7FFFFFFF;
+
+    // Inf and NaN.
+    if ( absBits >= 0x7F800000 )
+        return uint16_t( sign | 0x7C00 | ( absBits > 0x7F800000 ? 0x200 : 0 ) );
+
+    // Rounds to infinity (65520 and above).
+    if ( absBits >= 0x477FF000 )
+        return uint16_t( sign | 0x7C00 );
+
+    // Subnormal half: value in units of 2^-24.
+    if ( absBits < 0x38800000 )
+    {
+        float absValue;
+        memcpy( &absValue, &absBits, sizeof(absValue) );
+        return uint16_t( sign | uint32_t( std::nearbyint( absValue * 16777216.0f ) ) );
+    }
+
+    // Normal half: rebias exponent and round mantissa to nearest even.
+    const uint32_t rounded = absBits + 0xFFF + ( ( absBits >> 13 ) & 1 );
+    return uint16_t( sign | ( ( rounded - 0x38000000 ) >> 13 ) );
+}
+
+
+float HalfToFloat( const uint16_t value )
+{
+    const uint32_t sign = uint32_t( value & 0x8000 ) << 16;
+    const uint32_t exponent = ( value >> 10 ) & 0x1F;
+    const uint32_t mantissa = value & 0x3FF;
+
+    if ( exponent == 0 )
+    {
+        const float result = std::ldexp( float( mantissa ), -24 );
+        return sign ? -result : result;
+    }
+
+    uint32_t bits;
+    if ( exponent == 31 )
+        bits = sign | 0x7F800000 | ( mantissa << 13 );
+    else
+        bits = sign | ( ( exponent + 112 ) << 23 ) | ( mantissa << 13 );
+
+    float result;
+    memcpy( &result, &bits, sizeof(result) );
+    return result;
+}
+
+
+uint16_t QuantizeUnorm16( const float value )
+{
+    const float clamped = std::min( std::max( value, 0.0f ), 1.0f );
+    return uint16_t( std::lround( clamped * 65535.0f ) );
+}
+
+
+namespace {
+
+float SignNotZero( const float value )
+{
+    return ( value < 0.0f ) ? -1.0f : 1.0f;
+}
+
+int16_t QuantizeSnorm16( const float value )
+{
+    const float clamped = std::min( std::max( value, -1.0f ), 1.0f );
+    return int16_t( std::lround( clamped * 32767.0f ) );
+}
+
+} // namespace
+
+
+void EncodeOctahedralNormal( const float normal[3], int16_t encoded[2] )
+{
+    const float l1 = std::fabs( normal[0] ) + std::fabs( normal[1] ) + std::fabs( normal[2] );
+    if ( l1 == 0.0f )
+    {
+        encoded[0] = 0;
+        encoded[1] = 0;
+        return;
+    }
+
+    float u = normal[0] / l1;
+    float v = normal[1] / l1;
+    if ( normal[2] < 0.0f )
+    {
+        const float foldedU = ( 1.0f - std::fabs( v ) ) * SignNotZero( u );
+        const float foldedV = ( 1.0f - std::fabs( u ) ) * SignNotZero( v );
+        u = foldedU;
+        v = foldedV;
+    }
+
+    encoded[0] = QuantizeSnorm16( u );
+    encoded[1] = QuantizeSnorm16( v );
+}
+
+
+void DecodeOctahedralNormal( const int16_t encoded[2], float normal[3] )
+{
+    const float u = std::max( float( encoded[0] ) / 32767.0f, -1.0f );
+    const float v = std::max( float( encoded[1] ) / 32767.0f, -1.0f );
+
+    normal[0] = u;
+    normal[1] = v;
+    normal[2] = 1.0f - std::fabs( u ) - std::fabs( v );
+    if ( normal[2] < 0.0f )
+    {
+        normal[0] = ( 1.0f - std::fabs( v ) ) * SignNotZero( u );
+        normal[1] = ( 1.0f - std::fabs( u ) ) * SignNotZero( v );
+    }
+
+    const float length = std::sqrt( normal[0]*normal[0] + normal[1]*normal[1] + normal[2]*normal[2] );
+    for ( int k = 0; k < 3; ++k )
+        normal[k] /= length;
+}
+
+
+PositionQuantization ComputePositionQuantization( const void* positions, const size_t positionStride, const size_t numVertices )
+{
+    PositionQuantization quantization;
+    if ( numVertices == 0 )
+        return quantization;
+
+    float minimum[3], maximum[3];
+    for ( int k = 0; k < 3; ++k )
+    {
+        minimum[k] = std::numeric_limits<float>::max();
+        maximum[k] = std::numeric_limits<float>::lowest();
+    }
+
+    for ( size_t i = 0; i < numVertices; ++i )
+    {
+        float position[3];
+        memcpy( position, static_cast<const char*>( positions ) + i * positionStride, sizeof(position) );
+        for ( int k = 0; k < 3; ++k )
+        {
+            minimum[k] = std::min( minimum[k], position[k] );
+            maximum[k] = std::max( maximum[k], position[k] );
+        }
+    }
+
+    for ( int k = 0; k < 3; ++k )
+    {
+        quantization.offset[k] = minimum[k];
+        quantization.scale[k] = maximum[k] - minimum[k];
+    }
+    return quantization;
+}
+
+
+void QuantizePosition( const PositionQuantization& quantization, const float position[3], uint16_t quantized[4] )
+{
+    for ( int k = 0; k < 3; ++k )
+    {
+        // Flat axis: every position is exactly at the offset.
+        const float scale = quantization.scale[k];
+        quantized[k] = ( scale > 0.0f ) ? QuantizeUnorm16( ( position[k] - quantization.offset[k] ) / scale ) : 0;
+    }
+    quantized[3] = 0;
+}
+
+
+} // namespace svk
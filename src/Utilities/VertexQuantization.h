@@ -0,0 +1,55 @@
+#ifndef SVK_VERTEXQUANTIZATION_H
+#define SVK_VERTEXQUANTIZATION_H
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace svk {
+
+
+// Float to IEEE half precision (VK_FORMAT_R16*_SFLOAT), rounded to nearest even.
+uint16_t FloatToHalf( const float value );
+
+float HalfToFloat( const uint16_t value );
+
+
+// Value in [0,1] to 16-bit unsigned normalized (VK_FORMAT_R16*_UNORM). Out of range values are clamped.
+uint16_t QuantizeUnorm16( const float value );
+
+
+// Unit normal to octahedral encoding in two 16-bit signed normalized values (VK_FORMAT_R16G16_SNORM).
+// Decode in the shader with:
+//     vec3 n = vec3( e, 1.0 - abs(e.x) - abs(e.y) );
+//     if ( n.z < 0.0 ) n.xy = ( 1.0 - abs(n.yx) ) * sign(n.xy);
+//     n = normalize(n);
+void EncodeOctahedralNormal( const float normal[3], int16_t encoded[2] );
+
+void DecodeOctahedralNormal( const int16_t encoded[2], float normal[3] );
+
+
+// Positions are stored as 16-bit unorm inside the mesh bounding box.
+// Dequantized position is offset + scale * quantized, which is folded into the model matrix.
+struct PositionQuantization
+{
+    float offset[3] = { 0.0f, 0.0f, 0.0f };
+    float scale[3] = { 1.0f, 1.0f, 1.0f };
+};
+
+
+// Bounding box of positions, given as three floats at positions + i*positionStride bytes.
+PositionQuantization ComputePositionQuantization(
+    const void* positions,
+    const size_t positionStride,
+    const size_t numVertices
+);
+
+
+// Writes x, y, z and w = 0, to be read as VK_FORMAT_R16G16B16A16_UNORM
+// (three-component 16-bit formats are rarely supported for vertex input).
+void QuantizePosition( const PositionQuantization& quantization, const float position[3], uint16_t quantized[4] );
+
+
+} // namespace svk
+
+#endif // SVK_VERTEXQUANTIZATION_H
@@ -1,6 +1,7 @@
 #include "VulkanBase.h"
 #include "VulkanContext.h"
 #include "CommandPool.h"
+#include "Trace.h"
 
 #include <algorithm>
 #include <fstream>
@@ -59,30 +60,24 @@ VkSurfaceFormatKHR ChooseSwapSurfaceFormat( const std::vector<VkSurfaceFormatKHR
 }
 
 
-VkPresentModeKHR ChooseSwapPresentMode( const std::vector<VkPresentModeKHR>& availablePresentModes )
+VkPresentModeKHR ChooseSwapPresentMode( const std::vector<VkPresentModeKHR>& availablePresentModes, const std::vector<VkPresentModeKHR>& preferredPresentModes )
 {
-    for ( const auto& availablePresentMode : availablePresentModes )
+    for ( const auto& preferredPresentMode : preferredPresentModes )
     {
-        if ( availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR )
-            return availablePresentMode;
+        if ( std::find( availablePresentModes.begin(), availablePresentModes.end(), preferredPresentMode ) != availablePresentModes.end() )
+            return preferredPresentMode;
     }
     return VK_PRESENT_MODE_FIFO_KHR;
 }
 
 
-VkExtent2D ChooseSwapExtent( GLFWwindow* window, const VkSurfaceCapabilitiesKHR& capabilities )
+VkExtent2D ChooseSwapExtent( const VkExtent2D& framebufferSize, const VkSurfaceCapabilitiesKHR& capabilities )
 {
     if ( capabilities.currentExtent.width != UINT32_MAX ) {
         return capabilities.currentExtent;
     }
     else {
-        int width, height;
-        glfwGetFramebufferSize( window, &width, &height );
-
-        VkExtent2D actualExtent = {
-            static_cast<uint32_t>( width ),
-            static_cast<uint32_t>( height )
-        };
+        VkExtent2D actualExtent = framebufferSize;
 
         actualExtent.width = std::clamp( actualExtent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width );
         actualExtent.height = std::clamp( actualExtent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height );
@@ -145,13 +140,16 @@ void createBuffer( VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryProperty
     vkBindBufferMemory(device, buffer, bufferMemory, 0);
 }
 
-void copyBuffer( const CommandPool& commandPool, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size )
+void copyBuffer( const CommandPool& commandPool, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset )
 {
+    SVK_TRACE_SCOPE( "copyBuffer" );
+
     VkCommandBuffer commandBuffer = commandPool.CreateCommandBuffer();
     CommandPool::BeginCommandBuffer( commandBuffer, true );
 
     VkBufferCopy copyRegion{};
     copyRegion.size = size;
+    copyRegion.dstOffset = dstOffset;
     vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
     CommandPool::EndCommandBuffer( commandBuffer );
@@ -162,6 +160,8 @@ void copyBuffer( const CommandPool& commandPool, VkBuffer srcBuffer, VkBuffer ds
 
 void copyBufferToImage( const CommandPool& commandPool, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height )
 {
+    SVK_TRACE_SCOPE( "copyBufferToImage" );
+
     VkCommandBuffer commandBuffer = commandPool.CreateCommandBuffer();
     CommandPool::BeginCommandBuffer( commandBuffer, true );
 
@@ -187,4 +187,31 @@ void copyBufferToImage( const CommandPool& commandPool, VkBuffer buffer, VkImage
     commandPool.FreeCommandBuffer( commandBuffer );
 }
 
+
+void cmdBufferBarrier( VkCommandBuffer commandBuffer, VkBuffer buffer, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess, VkDeviceSize offset, VkDeviceSize size )
+{
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstAccessMask = dstAccess;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = buffer;
+    barrier.offset = offset;
+    barrier.size = size;
+
+    vkCmdPipelineBarrier( commandBuffer, srcStage, dstStage, 0, 0, nullptr, 1, &barrier, 0, nullptr );
+}
+
+
+void cmdMemoryBarrier( VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess )
+{
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstAccessMask = dstAccess;
+
+    vkCmdPipelineBarrier( commandBuffer, srcStage, dstStage, 0, 1, &barrier, 0, nullptr, 0, nullptr );
+}
+
 } // namespace svk
\ No newline at end of file
@@ -33,20 +33,44 @@ VkShaderModule CreateShaderModule( VkDevice device, const std::vector<char>& cod
 
 VkSurfaceFormatKHR ChooseSwapSurfaceFormat( const std::vector<VkSurfaceFormatKHR>& availableFormats );
 
-VkPresentModeKHR ChooseSwapPresentMode( const std::vector<VkPresentModeKHR>& availablePresentModes );
+// First of the preferred modes that is available, FIFO (which is always available) otherwise.
+VkPresentModeKHR ChooseSwapPresentMode( const std::vector<VkPresentModeKHR>& availablePresentModes, const std::vector<VkPresentModeKHR>& preferredPresentModes );
 
-VkExtent2D ChooseSwapExtent( GLFWwindow* window, const VkSurfaceCapabilitiesKHR& capabilities );
+VkExtent2D ChooseSwapExtent( const VkExtent2D& framebufferSize, const VkSurfaceCapabilitiesKHR& capabilities );
 
 SwapChainSupportDetails QuerySwapChainSupport( VkPhysicalDevice device, VkSurfaceKHR surface );
 
 
 void createBuffer( VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory );
 
-void copyBuffer( const CommandPool& commandPool, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size );
+void copyBuffer( const CommandPool& commandPool, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset = 0 );
 
 void copyBufferToImage( const CommandPool& commandPool, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height );
 
 
+// Makes writes of srcAccess in srcStage visible to dstAccess in dstStage,
+// e.g. compute shader writes to a buffer read afterwards as vertex input.
+void cmdBufferBarrier(
+    VkCommandBuffer commandBuffer,
+    VkBuffer buffer,
+    VkPipelineStageFlags srcStage,
+    VkAccessFlags srcAccess,
+    VkPipelineStageFlags dstStage,
+    VkAccessFlags dstAccess,
+    VkDeviceSize offset = 0,
+    VkDeviceSize size = VK_WHOLE_SIZE
+);
+
+// Same as cmdBufferBarrier for all memory.
+void cmdMemoryBarrier(
+    VkCommandBuffer commandBuffer,
+    VkPipelineStageFlags srcStage,
+    VkAccessFlags srcAccess,
+    VkPipelineStageFlags dstStage,
+    VkAccessFlags dstAccess
+);
+
+
 } // namespace svk
 
 #endif // SVK_VULKANBASE_H
\ No newline at end of file
@@ -3,6 +3,8 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#include "Trace.h"
+
 #include <iostream>
 #include <set>
 
@@ -24,6 +26,8 @@ void VulkanContext::Init(
     const std::vector<const char*>& validationLayers,
     const std::vector<const char*>& deviceExtensions )
 {
+    SVK_TRACE_SCOPE( "VulkanContext::Init" );
+
     this->appName = appName;
     this->window = window;
     this->validationLayers = validationLayers;
@@ -69,6 +73,11 @@ void VulkanContext::Destroy()
     familyIndices = {};
     graphicsQueue = VK_NULL_HANDLE;
     presentQueue = VK_NULL_HANDLE;
+    computeQueue = VK_NULL_HANDLE;
+    timestampPeriod = 0.0f;
+    timestampValidMask = 0;
+    isPipelineStatisticsSupported = false;
+    isFragmentStoresAndAtomicsSupported = false;
 }
 
 
@@ -101,6 +110,8 @@ uint32_t VulkanContext::FindMemoryType( uint32_t typeFilter, VkMemoryPropertyFla
 
 void VulkanContext::SubmitGraphicsQueue( const VkCommandBuffer& commandBuffer ) const
 {
+    SVK_TRACE_SCOPE( "SubmitGraphicsQueueAndWait" );
+
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
     submitInfo.commandBufferCount = 1;
@@ -114,6 +125,8 @@ void VulkanContext::SubmitGraphicsQueue( const VkCommandBuffer& commandBuffer )
 
 void VulkanContext::SubmitGraphicsQueue( const VkCommandBuffer& commandBuffer, const std::vector<VkSemaphore>& waitSemaphores, const std::vector<VkPipelineStageFlags>& waitStages, const std::vector<VkSemaphore>& signalSemaphores, const VkFence fence ) const
 {
+    SVK_TRACE_SCOPE( "SubmitGraphicsQueue" );
+
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
@@ -136,11 +149,32 @@ void VulkanContext::SubmitGraphicsQueue( const VkCommandBuffer& commandBuffer, c
         submitInfo.pSignalSemaphores = signalSemaphores.data();
     }
 
-    vkResetFences( device, 1, &fence );
+    if ( fence != VK_NULL_HANDLE )
+        vkResetFences( device, 1, &fence );
 
     if ( vkQueueSubmit( graphicsQueue, 1, &submitInfo, fence ) != VK_SUCCESS )
         throw std::runtime_error( "Failed to submit graphics queue." );
-    vkQueueWaitIdle( graphicsQueue );
+    // Completion is signalled by the fence, there is no wait here, so that frames can be in flight.
+    if ( fence == VK_NULL_HANDLE )
+        vkQueueWaitIdle( graphicsQueue );
+}
+
+
+void VulkanContext::SubmitComputeQueue( const VkCommandBuffer& commandBuffer ) const
+{
+    SVK_TRACE_SCOPE( "SubmitComputeQueueAndWait" );
+
+    if ( computeQueue == VK_NULL_HANDLE )
+        throw std::runtime_error( "No compute queue available." );
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+
+    if ( vkQueueSubmit( computeQueue, 1, &submitInfo, VK_NULL_HANDLE ) != VK_SUCCESS )
+        throw std::runtime_error( "Failed to submit compute queue." );
+    vkQueueWaitIdle( computeQueue );
 }
 
 
@@ -198,6 +232,16 @@ void VulkanContext::SetupDebugMessenger()
 
 void VulkanContext::CreateSurface()
 {
+    if ( IsHeadless() )
+    {
+        VkHeadlessSurfaceCreateInfoEXT createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT;
+        auto func = (PFN_vkCreateHeadlessSurfaceEXT) vkGetInstanceProcAddr( instance, "vkCreateHeadlessSurfaceEXT" );
+        if ( func == nullptr || func( instance, &createInfo, nullptr, &surface ) != VK_SUCCESS )
+            throw std::runtime_error( "failed to create headless surface!" );
+        return;
+    }
+
     if ( glfwCreateWindowSurface( instance, window, nullptr, &surface ) != VK_SUCCESS )
         throw std::runtime_error( "failed to create window surface!" );
 }
@@ -234,6 +278,8 @@ void VulkanContext::CreateLogicalDevice()
 
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
     std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value() };
+    if ( indices.computeFamily.has_value() )
+        uniqueQueueFamilies.insert( indices.computeFamily.value() );
 
     float queuePriority = 1.0f;
     for ( uint32_t queueFamily : uniqueQueueFamilies )
@@ -246,8 +292,27 @@ void VulkanContext::CreateLogicalDevice()
         queueCreateInfos.push_back( queueCreateInfo );
     }
 
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures( physicalDevice, &supportedFeatures );
+    isPipelineStatisticsSupported = ( supportedFeatures.pipelineStatisticsQuery == VK_TRUE );
+    isFragmentStoresAndAtomicsSupported = ( supportedFeatures.fragmentStoresAndAtomics == VK_TRUE );
+
     VkPhysicalDeviceFeatures deviceFeatures {};
     deviceFeatures.samplerAnisotropy = VK_TRUE;
+    deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+    deviceFeatures.fragmentStoresAndAtomics = supportedFeatures.fragmentStoresAndAtomics;
+
+    // Timestamps, for GPU profiling.
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties( physicalDevice, &deviceProperties );
+    timestampPeriod = deviceProperties.limits.timestampPeriod;
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties( physicalDevice, &queueFamilyCount, nullptr );
+    std::vector<VkQueueFamilyProperties> queueFamilies( queueFamilyCount );
+    vkGetPhysicalDeviceQueueFamilyProperties( physicalDevice, &queueFamilyCount, queueFamilies.data() );
+    const uint32_t timestampValidBits = queueFamilies[ indices.graphicsFamily.value() ].timestampValidBits;
+    timestampValidMask = ( timestampValidBits >= 64 ) ? ~uint64_t( 0 ) : ( ( uint64_t( 1 ) << timestampValidBits ) - 1 );
 
     VkDeviceCreateInfo createInfo {};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -274,6 +339,8 @@ void VulkanContext::CreateLogicalDevice()
 
     vkGetDeviceQueue( device, indices.graphicsFamily.value(), 0, &graphicsQueue );
     vkGetDeviceQueue( device, indices.presentFamily.value(), 0, &presentQueue );
+    if ( indices.computeFamily.has_value() )
+        vkGetDeviceQueue( device, indices.computeFamily.value(), 0, &computeQueue );
 }
 
 
@@ -319,11 +386,18 @@ VkDebugUtilsMessengerCreateInfoEXT VulkanContext::CreateDebugMessengerCreateInfo
 
 std::vector<const char*> VulkanContext::GetRequiredExtensions()
 {
-    uint32_t glfwExtensionCount = 0;
-    const char** glfwExtensions;
-    glfwExtensions = glfwGetRequiredInstanceExtensions( &glfwExtensionCount );
-
-    std::vector<const char*> extensions( glfwExtensions, glfwExtensions + glfwExtensionCount );
+    std::vector<const char*> extensions;
+    if ( IsHeadless() )
+    {
+        extensions = { VK_KHR_SURFACE_EXTENSION_NAME, VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME };
+    }
+    else
+    {
+        uint32_t glfwExtensionCount = 0;
+        const char** glfwExtensions;
+        glfwExtensions = glfwGetRequiredInstanceExtensions( &glfwExtensionCount );
+        extensions.assign( glfwExtensions, glfwExtensions + glfwExtensionCount );
+    }
 
     if ( enableValidationLayers )
         extensions.push_back( VK_EXT_DEBUG_UTILS_EXTENSION_NAME );
@@ -360,6 +434,11 @@ VulkanContext::QueueFamilyIndices VulkanContext::FindQueueFamilies( VkPhysicalDe
         i++;
     }
 
+    // Compute is optional, and only used on the graphics family: compute work is recorded into
+    // frame command buffers, without queue ownership transfers.
+    if ( indices.graphicsFamily.has_value() && ( queueFamilies[indices.graphicsFamily.value()].queueFlags & VK_QUEUE_COMPUTE_BIT ) )
+        indices.computeFamily = indices.graphicsFamily;
+
     return indices;
 }
 
@@ -1,6 +1,8 @@
 #ifndef SVK_VULKANCONTEXT_H
 #define SVK_VULKANCONTEXT_H
 
+#include "PresentPolicy.h"
+
 #include <vulkan/vulkan.h>
 
 #include <optional>
@@ -22,6 +24,7 @@ public:
 
     VulkanContext() = default;
 
+    // Without a window, i.e. headless, presents to a VK_EXT_headless_surface, e.g. on software Vulkan without a display.
     void Init(
         const std::string& appName,
         GLFWwindow* window,
@@ -32,16 +35,22 @@ public:
     void Destroy();
 
 
+    // Should be called before the swap chain is created.
+    void SetPresentPolicy( const PresentPolicy& policy ) { presentPolicy = policy; }
+
+
     // Member getters.
 
     VkDebugUtilsMessageSeverityFlagBitsEXT VulkanMessageLevelToDisplay() const { return vulkanMessageLevelToDisplay; }
-    int MaxFramesInFlight() const { return MAX_FRAMES_IN_FLIGHT; }
+    int MaxFramesInFlight() const { return int( presentPolicy.framesInFlight ); }
+    const PresentPolicy& GetPresentPolicy() const { return presentPolicy; }
     bool IsEnableValidationLayers() const { return enableValidationLayers; }
 
     const std::vector<const char*>& ValidationLayers() const { return validationLayers; }
     const std::vector<const char*>& DeviceExtensions() const { return deviceExtensions; }
 
     GLFWwindow* Window() const { return window; }
+    bool IsHeadless() const { return window == nullptr; }
     VkInstance Instance() const { return instance; }
     VkSurfaceKHR Surface() const { return surface; }
 
@@ -50,9 +59,21 @@ public:
 
     const std::optional<uint32_t>& GraphicsFamily() const { return familyIndices.graphicsFamily; }
     const std::optional<uint32_t>& PresentFamily()  const { return familyIndices.presentFamily; }
+    // Graphics family if it supports compute, otherwise none: compute work is recorded into frame command buffers.
+    const std::optional<uint32_t>& ComputeFamily()  const { return familyIndices.computeFamily; }
 
     VkQueue GraphicsQueue() const { return graphicsQueue; }
     VkQueue PresentQueue()  const { return presentQueue; }
+    VkQueue ComputeQueue()  const { return computeQueue; }
+
+    // Timestamp queries on the graphics queue: nanoseconds per tick, and mask of the valid bits (0 if unsupported).
+    float TimestampPeriod() const { return timestampPeriod; }
+    uint64_t TimestampValidMask() const { return timestampValidMask; }
+    // Feature pipelineStatisticsQuery, enabled if the device supports it.
+    bool IsPipelineStatisticsSupported() const { return isPipelineStatisticsSupported; }
+
+    // Feature fragmentStoresAndAtomics, enabled if the device supports it.
+    bool IsFragmentStoresAndAtomicsSupported() const { return isFragmentStoresAndAtomicsSupported; }
 
 
     // Utility functions.
@@ -69,12 +90,16 @@ public:
         const VkFence fence = VK_NULL_HANDLE
     ) const;
 
+    // Submits and waits for completion.
+    void SubmitComputeQueue( const VkCommandBuffer& commandBuffer ) const;
+
 
 private:
     struct QueueFamilyIndices
     {
         std::optional<uint32_t> graphicsFamily;
         std::optional<uint32_t> presentFamily;
+        std::optional<uint32_t> computeFamily;
 
         bool isComplete()
         {
@@ -118,7 +143,7 @@ private:
     VkDebugUtilsMessageSeverityFlagBitsEXT vulkanMessageLevelToDisplay = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT;
 
     // Should be specified before Vulkan initialization.
-    int MAX_FRAMES_IN_FLIGHT = 2;
+    PresentPolicy presentPolicy;
 
     bool enableValidationLayers = false;
 
@@ -140,6 +165,12 @@ private:
 
     VkQueue graphicsQueue = VK_NULL_HANDLE;
     VkQueue presentQueue = VK_NULL_HANDLE;
+    VkQueue computeQueue = VK_NULL_HANDLE;
+
+    float timestampPeriod = 0.0f;
+    uint64_t timestampValidMask = 0;
+    bool isPipelineStatisticsSupported = false;
+    bool isFragmentStoresAndAtomicsSupported = false;
 };
 
 
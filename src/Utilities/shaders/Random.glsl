@@ -0,0 +1,53 @@
+// Counter-based random numbers, same streams as svk::RandomUint and svk::RandomFloat (Utilities/Random.h).
+// 64-bit seeds and indices are given as uvec2( low, high ).
+// Include with:
+//     #extension GL_GOOGLE_include_directive : require
+//     #include "Random.glsl"
+
+#ifndef SVK_RANDOM_GLSL
+#define SVK_RANDOM_GLSL
+
+
+// Philox4x32-10.
+uvec4 philox4x32( uvec4 counter, uvec2 key )
+{
+    for ( int round = 0; round < 10; ++round )
+    {
+        uint hi0, lo0, hi1, lo1;
+        umulExtended( 0xD2511F53u, counter.x, hi0, lo0 );
+        umulExtended( 0xCD9E8D57u, counter.z, hi1, lo1 );
+        counter = uvec4( hi1 ^ counter.y ^ key.x, lo1, hi0 ^ counter.w ^ key.y, lo0 );
+        key += uvec2( 0x9E3779B9u, 0xBB67AE85u );
+    }
+    return counter;
+}
+
+
+uint randomUint( uvec2 seed, uvec2 index )
+{
+    // Block index / 4 of the 64-bit index.
+    const uvec2 block = uvec2( ( index.x >> 2 ) | ( index.y << 30 ), index.y >> 2 );
+    const uvec4 words = philox4x32( uvec4( block, 0u, 0u ), seed );
+    return words[ index.x & 3u ];
+}
+
+
+// Uniform in [0,1), with 24 bits of precision.
+float randomFloat( uvec2 seed, uvec2 index )
+{
+    return float( randomUint( seed, index ) >> 8 ) * ( 1.0 / 16777216.0 );
+}
+
+
+uint randomUint( uint seed, uint index )
+{
+    return randomUint( uvec2( seed, 0u ), uvec2( index, 0u ) );
+}
+
+float randomFloat( uint seed, uint index )
+{
+    return randomFloat( uvec2( seed, 0u ), uvec2( index, 0u ) );
+}
+
+
+#endif // SVK_RANDOM_GLSL